@@ -8,8 +8,14 @@
 *  The buffer manager supports the management of multiple buffer
 *  pools simultaneously, where each buffer pool is a combination of a
 *  page file and the page frames that store pages from that file.
-*  Two page replacement strategies, namely FIFO and LRU,
-*  have been implemented in this implementation of the buffer manager.
+*  Six page replacement strategies, namely FIFO, LRU, CLOCK, LFU, LRU-K
+*  and ARC, have been implemented in this implementation of the buffer manager.
+*  Resident pages are located through a hash-based page table, so
+*  pinning, unpinning and flushing a page do not depend on the pool size.
+*  A pool may be shared by several threads: the page table is split
+*  into latched stripes, every frame has its own latch, and pages are
+*  read from disk after the replacement decision has been made, so a
+*  slow read does not hold up threads that hit in the pool.
 *
 *  @author Rushikesh Kadam (A20517258) - rkadam7@hawk.iit.edu
 *  @author Haren Amal (A20513547) - hamal@hawk.iit.edu
@@ -20,607 +26,4097 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <stdint.h>
+#include <sys/mman.h>
 
 // user-defined libraries
 #include "dberror.h"
 #include "storage_mgr.h"
 #include "buffer_mgr.h"
 #include "ds_define.h"
+#include "latency_stat.h"
+#include "trace_log.h"
 
-SM_FileHandle *fh;
-BufferQueue *bufferQueue;
-int numOfReadOps;
-int numOfWriteOps;
+// Size of a huge page; frame memory backed by huge pages is a multiple of it
+#define HUGE_PAGE_SIZE ((size_t)2 * 1024 * 1024)
+
+// Requests a pool keeps in flight at once in its asynchronous I/O queue
+#define ASYNC_IO_QUEUE_DEPTH 32
 
 /**
 *
-* The BufferQueue structure is used in the implementation of a buffer pool manager that manages the allocation of pages in memory.
-* Here we initialize the BufferQueue.
+* This function returns the home slot of a page number in the page table. It uses Fibonacci (multiplicative)
+* hashing so that consecutive page numbers are spread over the whole table.
 *
 */
+unsigned int hashPageNumber(PageTable *const table, const PageNumber pageNum)
+{
+    return ((unsigned int)pageNum * 2654435769u) >> table->shift;
+}
 
-void initializeBufferQueue(BM_BufferPool *const bm) //complete refactor haren
+/**
+*
+* This function allocates a page table for up to numEntries pages. The capacity is the smallest power of two
+* that is at least twice the number of entries, which keeps the load factor at or below one half.
+*
+*/
+RC initializePageTable(PageTable *const table, const int numEntries)
 {
-   PageNode *page[bm->numPages];
-   int pageFinal = (bm->numPages);
-   pageFinal--;
+    int capacity = 8;
+    int log2Capacity = 3;
 
+    while (capacity < 2 * numEntries) {
+        capacity <<= 1;
+        log2Capacity++;
+    }
 
-   int tempPageNumber = pageFinal;
+    table->slots = malloc(capacity * sizeof(PageTableSlot));
+    if (!table->slots) {
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
 
+    for (int i = 0; i < capacity; i++) {
+        table->slots[i].pageNum = NO_PAGE;
+        table->slots[i].index = -1;
+    }
+    table->capacity = capacity;
+    table->shift = 32 - log2Capacity;
+    table->numOfEntries = 0;
+    return RC_OK;
+}
 
+/**
+*
+* This function returns the index (frame number) stored for pageNum, or -1 if the page is not in the table.
+*
+*/
+int lookupPageTable(PageTable *const table, const PageNumber pageNum)
+{
+    unsigned int mask = table->capacity - 1;
+    unsigned int slot = hashPageNumber(table, pageNum);
 
-   while(tempPageNumber >= 0){
-       page[pageFinal - tempPageNumber] = calloc(1, sizeof(PageNode));
-       tempPageNumber--;
-   }
+    while (table->slots[slot].pageNum != NO_PAGE) {
+        if (table->slots[slot].pageNum == pageNum) {
+            return table->slots[slot].index;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
 
+/**
+*
+* This function doubles the capacity of a page table and re-inserts its entries.
+*
+*/
+RC growPageTable(PageTable *const table)
+{
+    PageTable grown;
 
-   tempPageNumber = 0;
-   while(tempPageNumber <= pageFinal){
-       page[tempPageNumber]->data = (char *)malloc(PAGE_SIZE);
-       page[tempPageNumber]->dirtyFlag = false;
-       page[tempPageNumber]->pageNum = -1;
-       page[tempPageNumber]->fixCount = 0;
-       page[tempPageNumber]->frameNumber = tempPageNumber;
-       tempPageNumber++;
-   }
+    if (initializePageTable(&grown, table->capacity) != RC_OK) {
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+    for (int i = 0; i < table->capacity; i++) {
+        if (table->slots[i].pageNum != NO_PAGE) {
+            insertPageTable(&grown, table->slots[i].pageNum, table->slots[i].index);
+        }
+    }
+    free(table->slots);
+    *table = grown;
+    return RC_OK;
+}
 
+/**
+*
+* This function records that pageNum now lives at the given index. The page must not already be in the table.
+* The table grows once it would become more than half full; if that fails the entry is still added as long as
+* a slot is free.
+*
+*/
+RC insertPageTable(PageTable *const table, const PageNumber pageNum, const int index)
+{
+    if (2 * (table->numOfEntries + 1) > table->capacity && growPageTable(table) != RC_OK
+        && table->numOfEntries + 1 >= table->capacity) {
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
 
-   tempPageNumber = 0;
-   page[tempPageNumber]->prev = NULL;
-   page[tempPageNumber]->next = page[tempPageNumber+1];
-   tempPageNumber++;
-   while(tempPageNumber <= pageFinal){
-       if(tempPageNumber == pageFinal){
-           page[tempPageNumber]->next = NULL;
-           page[tempPageNumber]->prev = page[tempPageNumber-1];
-           tempPageNumber++;  
-           continue;
-       }
-	   int next = tempPageNumber+1;
-	   int prev = tempPageNumber-1;
-       page[tempPageNumber]->next = page[next];
-       page[tempPageNumber]->prev = page[prev];
-       tempPageNumber++;
-      
-   }
-   bufferQueue->numOfFilledFrames = 0;
-   bufferQueue->frameCount = bm->numPages;
-   bufferQueue->front = page[0];
-   bufferQueue->rear = page[pageFinal];
-}
+    unsigned int mask = table->capacity - 1;
+    unsigned int slot = hashPageNumber(table, pageNum);
 
+    while (table->slots[slot].pageNum != NO_PAGE) {
+        slot = (slot + 1) & mask;
+    }
+    table->slots[slot].pageNum = pageNum;
+    table->slots[slot].index = index;
+    table->numOfEntries++;
+    return RC_OK;
+}
 
 /**
 *
-* This function will check whether the BufferQueue is empty
+* This function removes pageNum from the page table. Instead of leaving a tombstone, the entries that follow the
+* freed slot in the same probe run are shifted back, so lookups never have to skip over deleted slots.
 *
 */
-
-bool isQueueEmpty()
+void removePageTable(PageTable *const table, const PageNumber pageNum)
 {
-   return bufferQueue->numOfFilledFrames==0;
+    unsigned int mask = table->capacity - 1;
+    unsigned int hole = hashPageNumber(table, pageNum);
+
+    while (table->slots[hole].pageNum != pageNum) {
+        if (table->slots[hole].pageNum == NO_PAGE) {
+            return;
+        }
+        hole = (hole + 1) & mask;
+    }
+
+    unsigned int next = (hole + 1) & mask;
+    while (table->slots[next].pageNum != NO_PAGE) {
+        unsigned int home = hashPageNumber(table, table->slots[next].pageNum);
+
+        // The entry may move into the hole only if its home slot does not lie between the hole and its current slot
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            table->slots[hole] = table->slots[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    table->slots[hole].pageNum = NO_PAGE;
+    table->slots[hole].index = -1;
+    table->numOfEntries--;
 }
 
 /**
 *
-* This function will remove the item from the BufferQueue. Before removing an item it will check whether
-* the queue is empty. If the queue is empty it will simply return the error code. Otherwise it will
-* remove the desired item.
+* This function maps size bytes of anonymous memory aligned to a huge page and asks for transparent huge pages. More
+* than needed is mapped and the unaligned head and tail are unmapped again. Returns MAP_FAILED if nothing was mapped;
+* pages tells whether the kernel accepted the request for huge pages.
+*
 */
-RC removeBufferItem()
+void *mapTransparentHugePages(const size_t size, BM_HugePages *const pages)
 {
-	if (isQueueEmpty())
-	{
-		return RC_EMPTY_QUEUE;
-	}
+    char *mapped = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+        return MAP_FAILED;
+    }
 
-	PageNode *page = bufferQueue->front;
+    char *aligned = (char *)(((uintptr_t)mapped + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+    if (aligned > mapped) {
+        munmap(mapped, aligned - mapped);
+    }
+    if (mapped + HUGE_PAGE_SIZE > aligned) {
+        munmap(aligned + size, mapped + HUGE_PAGE_SIZE - aligned);
+    }
 
-	int tempPageNumber = 0;
-	while(tempPageNumber < bufferQueue->numOfFilledFrames){
-		if(tempPageNumber == bufferQueue->numOfFilledFrames-1){
-        bufferQueue->rear = page;
-		break;
+    *pages = BM_HUGE_PAGES_NONE;
+#ifdef MADV_HUGEPAGE
+    if (madvise(aligned, size, MADV_HUGEPAGE) == 0) {
+        *pages = BM_HUGE_PAGES_TRANSPARENT;
     }
-	page = page->next;
-	tempPageNumber++;
-   }
+#endif
+    return aligned;
+}
 
-	int rearPage;
-	int deletePageIdx = page->pageNum;
-	page = bufferQueue->rear;
+/**
+*
+* This function allocates a segment with the memory of numPages frames, the first of which is firstFrame, as
+* requested by memory (NULL for ordinary pages). Explicit huge pages fall back to transparent ones and those to
+* ordinary page-aligned memory, so the allocation only fails if there is no memory at all. The kind of pages obtained,
+* and whether they could be locked, is kept in the segment.
+*
+*/
+RC allocateSegment(FrameSegment *const segment, const int firstFrame, const int numPages, const BM_PoolMemoryConfig *const memory)
+{
+    size_t size = (size_t)numPages * PAGE_SIZE;
+    BM_HugePages wanted = memory ? memory->hugePages : BM_HUGE_PAGES_NONE;
+    BM_HugePages pages = BM_HUGE_PAGES_NONE;
+    void *arena = MAP_FAILED;
 
-	tempPageNumber = 0;
-	while(tempPageNumber < bufferQueue->frameCount){
-		if(page->fixCount){
-			rearPage = page->pageNum;
-			page = page->prev;
-		}
-		else if(page->pageNum == bufferQueue->rear->pageNum){
-			bufferQueue->rear = bufferQueue->rear->prev;
-			bufferQueue->rear->next = (bufferQueue->rear->next) == NULL?bufferQueue->rear->next:NULL;
-		}
-		else{
-			page->prev->next = page->next;
-			page->next->prev = page->prev;
-		}
-		tempPageNumber++;
-	}
+    if (wanted != BM_HUGE_PAGES_NONE) {
+        size_t hugeSize = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+#ifdef MAP_HUGETLB
+        if (wanted == BM_HUGE_PAGES_EXPLICIT) {
+            arena = mmap(NULL, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            pages = BM_HUGE_PAGES_EXPLICIT;
+        }
+#endif
+        if (arena == MAP_FAILED) {
+            arena = mapTransparentHugePages(hugeSize, &pages);
+        }
+        if (arena != MAP_FAILED) {
+            size = hugeSize;
+        }
+    }
 
-	if (page->dirtyFlag)
-	{
-		writeBlock(page->pageNum, fh, page->data);
-		numOfWriteOps++;
-	}
-	--bufferQueue->numOfFilledFrames;
-	return rearPage == bufferQueue->rear->pageNum?0:deletePageIdx;
+    segment->mapped = arena != MAP_FAILED;
+    if (!segment->mapped) {
+        pages = BM_HUGE_PAGES_NONE;
+        if (posix_memalign(&arena, PAGE_SIZE, size) != 0) {
+            return RC_BUFFER_POOL_INITIALIZE_ERROR;
+        }
+    }
+
+    segment->memory = arena;
+    segment->size = size;
+    segment->firstFrame = firstFrame;
+    segment->numOfFrames = (int)(size / PAGE_SIZE);
+    segment->pages = pages;
+    segment->locked = memory && memory->lockMemory && mlock(arena, size) == 0;
+    return RC_OK;
 }
 
 /**
 *
-* This function adds a new buffer item to the BufferQueue.
+* This function releases the memory of a segment.
 *
 */
-RC addBufferItem(BM_PageHandle *const page, const PageNumber pageNum, BM_BufferPool *const bm)
+void freeSegment(FrameSegment *const segment)
 {
-	PageNode *pageNode = (PageNode *)malloc(sizeof(PageNode));
-	
-	// Check if the buffer pool is full. If it is, remove a page from the buffer pool to make room for the new page.
-	int deletePageIdx = (bufferQueue->numOfFilledFrames == bufferQueue->frameCount)?removeBufferItem():-1;
-
-	char *data = (char *)calloc(PAGE_SIZE, sizeof(char));
-	pageNode->prev = NULL;
-	pageNode->next = NULL;
-	pageNode->pageNum = pageNum;
-	pageNode->dirtyFlag = false;
-	pageNode->frameNumber = 0;
-	pageNode->fixCount = 1;
-	pageNode->data = data;
-		
-
-	numOfReadOps = readBlock(pageNode->pageNum, fh, pageNode->data) == RC_OK?numOfReadOps+1:numOfReadOps;
-	page->data = pageNode->data;
-	pageNode->next = bufferQueue->front;
-	bufferQueue->front->prev = pageNode;
-	page->pageNum = pageNode->pageNum = pageNum;
-	pageNode->frameNumber = isQueueEmpty()? bufferQueue->front->frameNumber:((deletePageIdx == -1)?(bufferQueue->front->frameNumber + 1):deletePageIdx);
-	bufferQueue->front = pageNode;
-	bufferQueue->numOfFilledFrames++;
-	return RC_OK;
+    if (segment->locked) {
+        munlock(segment->memory, segment->size);
+    }
+    if (segment->mapped) {
+        munmap(segment->memory, segment->size);
+    } else {
+        free(segment->memory);
+    }
 }
 
 /**
 *
-* This function updates the attributes of buffer pool.
+* This function returns where the data of a frame starts in the given segments, or NULL if they have no room for it.
 *
 */
-void updateBM_BufferPool(BM_BufferPool *const bm, const char *const pageFileName, const int numPages, ReplacementStrategy strategy)
+char *frameData(FrameSegment *const segments, const int numOfSegments, const int frameNumber)
 {
-    bm->pageFile = strdup(pageFileName);
-    bm->numPages = numPages;
-    bm->strategy = strategy;
-	char *buffer = (char *)calloc(numPages, PAGE_SIZE);
-    bm->mgmtData = buffer;
+    for (int i = 0; i < numOfSegments; i++) {
+        if (frameNumber < segments[i].firstFrame + segments[i].numOfFrames) {
+            return segments[i].memory + (size_t)(frameNumber - segments[i].firstFrame) * PAGE_SIZE;
+        }
+    }
+    return NULL;
 }
 
 /**
 *
-* This function pins a page in the buffer pool.
+* These functions create the descriptor of an empty frame whose page data starts at data, and release it again.
+* Descriptors are allocated one by one, so that they keep their address for as long as the frame exists.
 *
 */
-RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+PageNode *newFrame(char *const data, const int frameNumber)
 {
-    RC res;
-    switch (bm->strategy)
-    {
-        case RS_FIFO:
-            res = pinPageWithFIFO(bm, page, pageNum);
-            break;
-        case RS_LRU:
-            res = pinPageWithLRU(bm, page, pageNum);
-            break;
-        default:
-            res = RC_INVALID_STRATEGY;
-            break;
+    PageNode *pageNode = calloc(1, sizeof(PageNode));
+    if (!pageNode) {
+        return NULL;
     }
-    return res;
+    pageNode->data = data;
+    pageNode->pageNum = NO_PAGE;
+    pageNode->frameNumber = frameNumber;
+    pthread_mutex_init(&pageNode->latch, NULL);
+    pthread_cond_init(&pageNode->ioDone, NULL);
+    return pageNode;
+}
+
+void freeFrame(PageNode *const pageNode)
+{
+    pthread_mutex_destroy(&pageNode->latch);
+    pthread_cond_destroy(&pageNode->ioDone);
+    free(pageNode);
 }
 
 /**
 *
-* This function initializes the Buffer Pool with its attributes like number of pages, page file name, and replacement strategy.
+* The BufferQueue structure is used in the implementation of a buffer pool manager that manages the allocation of pages in memory.
+* Here we initialize the BufferQueue. The frame descriptors are found through a table indexed by frame number and are
+* linked into the queue in frame order; every frame starts out on the stack of free frames. The page data of all
+* frames is carved out of a single page-aligned segment that is allocated here once (see allocateSegment) and reused
+* for the whole lifetime of the pool, so pinning never allocates memory.
 *
 */
-RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, const int numPages, ReplacementStrategy strategy, void *stratData)
+
+RC initializeBufferQueue(BufferQueue *const queue, const int numPages, const BM_PoolMemoryConfig *const memory)
 {
-    bufferQueue = malloc(sizeof(BufferQueue));
-    fh = malloc(sizeof(SM_FileHandle));
+   memset(queue, 0, sizeof(BufferQueue));
+   queue->frames = calloc(numPages, sizeof(PageNode *));
+   queue->freeFrames = malloc(numPages * sizeof(int));
+   queue->segments = malloc(sizeof(FrameSegment));
 
-    if (!fh || !bufferQueue) {
-        return RC_BUFFER_POOL_INITIALIZE_ERROR;
-    }
-	//If memory gets allocated, call update function for updating the attributes of the buffer pool.
-    updateBM_BufferPool(bm, pageFileName, numPages, strategy);
+   if (!queue->frames || !queue->freeFrames || !queue->segments
+       || allocateSegment(&queue->segments[0], 0, numPages, memory) != RC_OK) {
+       free(queue->frames);
+       free(queue->freeFrames);
+       free(queue->segments);
+       memset(queue, 0, sizeof(BufferQueue));
+       return RC_BUFFER_POOL_INITIALIZE_ERROR;
+   }
+   queue->numOfSegments = 1;
+
+   int tempPageNumber = 0;
+   while(tempPageNumber < numPages){
+       PageNode *page = newFrame(queue->segments[0].memory + (size_t)tempPageNumber * PAGE_SIZE, tempPageNumber);
+       if (!page) {
+           while (tempPageNumber > 0) {
+               freeFrame(queue->frames[--tempPageNumber]);
+           }
+           freeSegment(&queue->segments[0]);
+           free(queue->frames);
+           free(queue->freeFrames);
+           free(queue->segments);
+           memset(queue, 0, sizeof(BufferQueue));
+           return RC_BUFFER_POOL_INITIALIZE_ERROR;
+       }
+       queue->frames[tempPageNumber] = page;
+       page->prev = (tempPageNumber == 0) ? NULL : queue->frames[tempPageNumber - 1];
+       if (page->prev) {
+           page->prev->next = page;
+       }
+       tempPageNumber++;
+   }
 
-    RC rc = openPageFile(bm->pageFile, fh);
+   // The stack is filled from the highest frame down, so empty frames are handed out in frame order
+   for (int i = 0; i < numPages; i++) {
+       queue->freeFrames[i] = numPages - 1 - i;
+   }
+   queue->numOfFreeFrames = numPages;
+   queue->frameCount = numPages;
+   queue->clockHand = 0;
+   queue->front = queue->frames[0];
+   queue->rear = queue->frames[numPages - 1];
+   return RC_OK;
+}
 
-    if (rc != RC_OK) {
-        free(fh);
-        free(bufferQueue);
-        return rc;
+/**
+*
+* This function releases the frames of a BufferQueue and their memory.
+*
+*/
+void freeBufferQueue(BufferQueue *const queue)
+{
+    for (int i = 0; queue->frames && i < queue->frameCount; i++) {
+        freeFrame(queue->frames[i]);
     }
-    numOfReadOps = numOfWriteOps = 0;
-    initializeBufferQueue(bm);
+    for (int i = 0; i < queue->numOfSegments; i++) {
+        freeSegment(&queue->segments[i]);
+    }
+    free(queue->frames);
+    free(queue->freeFrames);
+    free(queue->segments);
+    queue->frames = NULL;
+    queue->freeFrames = NULL;
+    queue->segments = NULL;
+    queue->numOfSegments = 0;
+}
 
-    return RC_OK;
+
+/**
+*
+* This function returns the page table stripe responsible for pageNum.
+*
+*/
+PageTableStripe *stripeOf(BufferPoolMgmt *const pool, const PageNumber pageNum)
+{
+    return &pool->pageTable[(unsigned int)pageNum & (PAGE_TABLE_STRIPES - 1)];
 }
 
+/**
+*
+* This function returns the frame holding pageNum, or NULL if the page is not resident in the buffer pool.
+* The frame can only be relied on while the caller holds the strategy latch or a pin on the page.
+*
+*/
+PageNode *findFrame(BufferPoolMgmt *const pool, const PageNumber pageNum)
+{
+    PageTableStripe *stripe = stripeOf(pool, pageNum);
+
+    pthread_mutex_lock(&stripe->latch);
+    int frameNumber = lookupPageTable(&stripe->table, pageNum);
+    PageNode *pageNode = (frameNumber < 0) ? NULL : pool->queue.frames[frameNumber];
+    pthread_mutex_unlock(&stripe->latch);
+    return pageNode;
+}
 
 /**
 *
-* This function will shutdown the buffer pool. It writes any dirty pages back to the disk if they are not being used by any process.
+* This function adds one pin to a frame and sets its reference bit.
 *
 */
-RC shutdownBufferPool(BM_BufferPool *const bm)
+void pinFrame(PageNode *const pageNode)
 {
-    PageNode *currentPageInfo = bufferQueue->front;
-    int numDirtyPagesWritten = 0;
-    while (currentPageInfo != NULL) {
-        if (currentPageInfo->dirtyFlag && currentPageInfo->fixCount == 0) {
-            if (writeBlock(currentPageInfo->pageNum, fh, currentPageInfo->data) != RC_OK)
-                return RC_WRITE_FAILED;
-            numOfWriteOps++;
-            currentPageInfo->dirtyFlag = false;
-        }
-        currentPageInfo = currentPageInfo->next;
-    }
-    closePageFile(fh);
-    return RC_OK;
+    pthread_mutex_lock(&pageNode->latch);
+    pageNode->fixCount++;
+    pageNode->refBit = true;
+    pthread_mutex_unlock(&pageNode->latch);
 }
 
 /**
 *
-* This function forcefully flushes all the dirty pages to the disk.
+* This function records an access to a resident frame in the access buffer of its stripe; the caller holds the
+* stripe latch. It returns false if the buffer is full, the caller then has to go through the strategy latch.
 *
 */
-RC forceFlushPool(BM_BufferPool *const bm)
+bool recordAccess(BufferPoolMgmt *const pool, PageTableStripe *const stripe, PageNode *const pageNode, const bool release)
 {
-    PageNode *currentPageInfo = bufferQueue->front;
-    int idx = 0;
-    
-     while (idx < bufferQueue->frameCount)
-    {
-        if (currentPageInfo->dirtyFlag == true)
-        {
-            if (currentPageInfo->fixCount == 0)
-            {
-                writeBlock(currentPageInfo->pageNum, fh, currentPageInfo->data);
-                numOfWriteOps++;
-                currentPageInfo->dirtyFlag = false;
-            }
-        }
-        
-        currentPageInfo = currentPageInfo->next;
-        idx++;
+    if (stripe->numOfAccesses == ACCESS_BUFFER_SIZE) {
+        return false;
     }
-    return RC_OK;
+    PageAccess *access = &stripe->accesses[stripe->numOfAccesses++];
+    access->pageNode = pageNode;
+    access->seq = atomic_fetch_add_explicit(&pool->accessClock, 1, memory_order_relaxed);
+    access->release = release;
+    return true;
 }
 
 /**
 *
-* This function unpins the page from the buffer pool
+* This function pins pageNum if it is resident, without taking the strategy latch. The pin is taken while the
+* stripe latch is held, so the page cannot be evicted in between. A strategy that reorders its frames on a hit gets
+* the hit recorded in the stripe's access buffer in the same step (see PageAccess). Returns the pinned frame, or
+* NULL if the page is not resident or the hit cannot be recorded.
 *
 */
-RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+PageNode *pinResidentPage(BufferPoolMgmt *const pool, BM_PageHandle *const page, const PageNumber pageNum)
 {
-    PageNode *currentPageInfo = bufferQueue->front;
-    while(currentPageInfo != NULL && currentPageInfo->pageNum != page->pageNum) {
-        currentPageInfo = currentPageInfo->next;
+    PageTableStripe *stripe = stripeOf(pool, pageNum);
+
+    pthread_mutex_lock(&stripe->latch);
+    int frameNumber = lookupPageTable(&stripe->table, pageNum);
+    PageNode *pageNode = (frameNumber < 0) ? NULL : pool->queue.frames[frameNumber];
+    if (pageNode && pool->accessBatch && !recordAccess(pool, stripe, pageNode, false)) {
+        pageNode = NULL;
     }
-    
-    if (!currentPageInfo) {
-        return RC_READ_NON_EXISTING_PAGE;
-    } else {
-        currentPageInfo->fixCount--;
-        return RC_OK;
+    if (pageNode) {
+        pinFrame(pageNode);
+    }
+    pthread_mutex_unlock(&stripe->latch);
+
+    if (!pageNode) {
+        return NULL;
     }
+    page->data = pageNode->data;
+    page->pageNum = pageNum;
+    return pageNode;
 }
 
 /**
 *
-* This function will write a page from the buffer pool to disk.
+* This function blocks until the page held by a pinned frame has been read from disk. A pin that has to wait for
+* the read of another thread is counted as a pin wait. It returns RC_CHECKSUM_MISMATCH if the page read failed its
+* checksum.
 *
 */
-RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page) //check again
+RC waitForFrame(BufferPoolMgmt *const pool, PageNode *const pageNode)
 {
-	
-    PageNode *currentPageInfo = bufferQueue->front;
-    
-    while (currentPageInfo != NULL && currentPageInfo->pageNum != page->pageNum)
-    {
-        currentPageInfo = currentPageInfo->next;
+    pthread_mutex_lock(&pageNode->latch);
+    if (pageNode->ioInProgress) {
+        atomic_fetch_add_explicit(&pool->numOfPinWaits, 1, memory_order_relaxed);
     }
-    
-    if (!currentPageInfo)
-        return RC_READ_NON_EXISTING_PAGE;
-
-	int writeBlockOut = writeBlock(currentPageInfo->pageNum, fh, currentPageInfo->data);
-	numOfWriteOps = (writeBlockOut)?numOfWriteOps:numOfWriteOps+1;
-	if(writeBlockOut){
-		return RC_WRITE_FAILED;
-	}
-    
-    return RC_OK;
+    while (pageNode->ioInProgress) {
+        pthread_cond_wait(&pageNode->ioDone, &pageNode->latch);
+    }
+    bool corrupt = pageNode->corrupt;
+    pthread_mutex_unlock(&pageNode->latch);
+    return corrupt ? RC_CHECKSUM_MISMATCH : RC_OK;
 }
 
-
 /**
 *
-* This function marks a page in the buffer pool as dirty.
+* This function finishes a pin once the pin is held: it waits for the page to be read and, if the page failed its
+* checksum, drops the pin again. The corrupt page stays in its frame, so every pin of it fails, until it is evicted
+* and read anew. The pin keeps the page in its frame, so the frame is found through the page table.
 *
 */
-RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page) {
-    PageNode *currentPageInfo = bufferQueue->front;
-
-    while (currentPageInfo) {
-        if (currentPageInfo->pageNum == page->pageNum) {
-            currentPageInfo->dirtyFlag = true;
-            return RC_OK;
-        }
-        currentPageInfo = currentPageInfo->next;
+RC finishPin(BufferPoolMgmt *const pool, BM_PageHandle *const page)
+{
+    RC rc = waitForFrame(pool, findFrame(pool, page->pageNum));
+    if (rc != RC_OK) {
+        unpinPageNumber(pool, page->pageNum);
     }
+    return rc;
+}
 
-    return RC_READ_NON_EXISTING_PAGE;
+/**
+*
+* This function counts a demand pin as a miss if it had to read the page and as a hit otherwise.
+*
+*/
+void countPin(BufferPoolMgmt *const pool, const bool miss)
+{
+    atomic_fetch_add_explicit(miss ? &pool->numOfMisses : &pool->numOfHits, 1, memory_order_relaxed);
 }
 
 /**
 *
-* This function returns an array of page representing the page currently held in each frame of the buffer pool.
+* This function reads the page assigned to a frame from the page file. The storage manager reads at the page's
+* offset, so no latch is needed and misses on different pages read in parallel. A page that lies beyond the end of
+* the file is presented as an empty (zeroed) page.
 *
 */
-PageNumber *getFrameContents(BM_BufferPool *const bm)
+void readFrameData(BufferPoolMgmt *const pool, PageNode *const pageNode)
 {
-    PageNumber (*pages)[bm->numPages];
-    pages = calloc(bm->numPages, sizeof(int));  
-    for (int i = 0; i < bm->numPages; i++)
-    {
-        PageNode *currentPageInfo = bufferQueue->front;
-        while (currentPageInfo)
-        {
-            if (currentPageInfo->frameNumber == i)
-            {
-                (*pages)[i] = currentPageInfo->pageNum;
-                break;
-            }
-            currentPageInfo = currentPageInfo->next;
-        }
+    if (readBlock(pageNode->pageNum, &pool->fh, pageNode->data) == RC_OK) {
+        atomic_fetch_add_explicit(&pool->numOfReadOps, 1, memory_order_relaxed);
+        pageNode->corrupt = pool->verifyChecksums && verifyPage(pageNode->pageNum, &pool->fh, pageNode->data) != RC_OK;
+    } else {
+        memset(pageNode->data, 0, PAGE_SIZE);
     }
-    return *pages;
 }
 
 /**
 *
-* This function returns reference to a boolean array that shows which pages in a buffer pool have been marked as dirty.
+* This function tells whether the replacement strategy of a pool keeps track of the frames that become unpinned:
+* LFU links them into their bucket and LRU-K into its heap of victim candidates. Such a pool records the unpin that
+* drops the last pin of a frame in the access buffer of the page's stripe, like a hit (see PageAccess).
 *
 */
-bool *getDirtyFlags(BM_BufferPool *const bm)
+bool tracksUnpinnedFrames(BufferPoolMgmt *const pool)
 {
-    bool (*dirtyFlagArray)[bm->numPages];
-    dirtyFlagArray = calloc(bm->numPages, sizeof(bool));
+    return pool->lfu || pool->lruk;
+}
 
-    for (int i = 0; i < bm->numPages; i++)
-    {
-        PageNode *currentPageInfo = bufferQueue->front;
-        while (currentPageInfo != NULL && currentPageInfo->frameNumber != i) {
-            currentPageInfo = currentPageInfo->next;
-        }
+/**
+*
+* This function hands a frame that is unpinned to the strategy; the caller holds the strategy latch. It is called
+* for every recorded release, and a frame may have been pinned again or already been handed over since, so only an
+* unpinned frame that is not yet linked is linked.
+*
+*/
+void releaseStrategyFrame(BufferPoolMgmt *const pool, PageNode *const pageNode)
+{
+    pthread_mutex_lock(&pageNode->latch);
+    bool unpinned = pageNode->pageNum != NO_PAGE && pageNode->fixCount == 0;
+    pthread_mutex_unlock(&pageNode->latch);
 
-        if (currentPageInfo) {
-            (*dirtyFlagArray)[i] = currentPageInfo->dirtyFlag;
-        }
+    if (!unpinned) {
+        return;
+    }
+    if (pool->lfu) {
+        releaseLFUFrame(pageNode);
+    } else if (pool->lruk) {
+        releaseLRUKFrame(pool->lruk, pageNode);
     }
-    return *dirtyFlagArray;
 }
 
 /**
 *
-* This function returns an array of fixCounts for each page in the buffer pool
+* This function hands the frame of pageNum to the strategy after its last pin was dropped but the access buffer of
+* its stripe was full. The recorded accesses are applied first so the release keeps its place after them. The frame
+* is looked up again under the strategy latch, since the page may have been evicted in between.
 *
 */
-int *getFixCounts(BM_BufferPool *const bm) {
-	
-    int (*fixCountsArray)[bm->numPages];
-    fixCountsArray = calloc(bm->numPages, sizeof(int));
-
-    for (int i = 0; i < bm->numPages; i++) {
-		PageNode *currentPageInfo = bufferQueue->front;
-        while (currentPageInfo != NULL && currentPageInfo->frameNumber != i) {
-            currentPageInfo = currentPageInfo->next;
-        }
-        if (currentPageInfo) {
-            (*fixCountsArray)[i] = currentPageInfo->fixCount;
-        }
+void releaseUnrecordedPin(BufferPoolMgmt *const pool, const PageNumber pageNum)
+{
+    pthread_mutex_lock(&pool->strategyLatch);
+    applyPageAccesses(pool, false);
+    PageNode *pageNode = findFrame(pool, pageNum);
+    if (pageNode) {
+        releaseStrategyFrame(pool, pageNode);
     }
-    return *fixCountsArray;
+    pthread_mutex_unlock(&pool->strategyLatch);
 }
 
+/**
+*
+* This function marks the read of a frame as finished and wakes up the threads waiting for it. With dropPin the pin
+* taken for the read is dropped in the same step, so that a waiting thread never sees it.
+*
+*/
+void finishFrameRead(BufferPoolMgmt *const pool, PageNode *const pageNode, const bool dropPin)
+{
+    PageNumber pageNum = pageNode->pageNum;
+    PageTableStripe *stripe = dropPin ? stripeOf(pool, pageNum) : NULL;
 
+    if (stripe) {
+        pthread_mutex_lock(&stripe->latch);
+    }
+    pthread_mutex_lock(&pageNode->latch);
+    pageNode->ioInProgress = false;
+    bool released = dropPin && --pageNode->fixCount == 0;
+    pthread_cond_broadcast(&pageNode->ioDone);
+    pthread_mutex_unlock(&pageNode->latch);
+    bool recorded = !released || !tracksUnpinnedFrames(pool) || recordAccess(pool, stripe, pageNode, true);
+    if (stripe) {
+        pthread_mutex_unlock(&stripe->latch);
+    }
+    if (!recorded) {
+        releaseUnrecordedPin(pool, pageNum);
+    }
+}
 
 /**
 *
-* This function returns the number of pages that have been read from the disk.
+* This function reads the page a miss has assigned to a frame and wakes up the threads waiting for it.
 *
 */
-int getNumReadIO(BM_BufferPool *const bm)
+void readIntoFrame(BufferPoolMgmt *const pool, PageNode *const pageNode, const bool dropPin)
 {
-	return numOfReadOps?numOfReadOps:0;
+    readFrameData(pool, pageNode);
+    finishFrameRead(pool, pageNode, dropPin);
 }
 
 /**
 *
-* This function returns the number of pages that have been written to the disk.
+* This function orders frames by the page they hold, so that a batch of pages is read in file order.
 *
 */
-int getNumWriteIO(BM_BufferPool *const bm)
+int comparePageNodes(const void *first, const void *second)
 {
-	return numOfWriteOps?numOfWriteOps:0;
+    PageNumber firstPage = (*(PageNode *const *)first)->pageNum;
+    PageNumber secondPage = (*(PageNode *const *)second)->pageNum;
+    return (firstPage > secondPage) - (firstPage < secondPage);
 }
 
 /**
 *
-* This function pins a page in the buffer pool using LRU page replacement policy
+* This function marks the frames whose pages an asynchronous request transferred. The tag of a request is the
+* index of its first frame.
 *
 */
-RC pinPageWithLRU(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+void markTransferred(const SM_IOCompletion *const completions, const int numOfCompletions, bool *const transferred)
 {
-	bool isPageFound = false;
-	PageNode *pageNode = bufferQueue->front;
-
-	int tempPageNumber = 0;
-	
-	// Loop through all the pages in the buffer pool
-	while(tempPageNumber < bm->numPages){
-
-		// If page is found in the buffer pool, set pageFound flag to 1 and break out of the loop, otherwise goto the next page
-		if(!isPageFound && pageNode->pageNum == pageNum){
-			isPageFound = true;
-			break;
-		}
-		pageNode = pageNode->next;
-		tempPageNumber++;
-	}
-
-	if (!isPageFound)
-	{
-    addBufferItem(page, pageNum, bm);
-	} 
-	else 
-	{
-    pageNode->fixCount++;
-    page->data = pageNode->data;
-    page->pageNum = pageNum;
-
-    if (pageNode != bufferQueue->front) {
-        if (pageNode == bufferQueue->rear) {
-            bufferQueue->rear = pageNode->prev;
-        }
-
-        if (pageNode->prev) {
-            pageNode->prev->next = pageNode->next;
-        }
-
-        if (pageNode->next) {
-            pageNode->next->prev = pageNode->prev;
+    for (int i = 0; i < numOfCompletions; i++) {
+        int first = (int)(intptr_t)completions[i].tag;
+        for (int j = 0; j < completions[i].numOfPages; j++) {
+            transferred[first + j] = true;
         }
-
-        pageNode->prev = NULL;
-        pageNode->next = bufferQueue->front;
-        bufferQueue->front->prev = pageNode;
-		printf("##Checkpoint##");
-        bufferQueue->front = pageNode;
     }
 }
-	return RC_OK;
-}
 
 /**
 *
-* This function pins a page in the buffer pool using FIFO page replacement policy
+* This function reads or writes one run of adjacent pages synchronously. Only pages that exist in the file are read,
+* like an asynchronous read only completes those.
 *
 */
-RC pinPageWithFIFO(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+void transferFrameRun(BufferPoolMgmt *const pool, const PageNumber startPage, const int numOfPages,
+                      SM_PageHandle *const buffers, const bool isWrite, bool *const transferred)
 {
-	bool isPageFound = false;
-	int numPages = bm->numPages;
-	PageNode *backupPageInfo = NULL;
-	PageNode *currentPageInfo = bufferQueue->front;
-
-	while(currentPageInfo){
-		if(currentPageInfo->pageNum == pageNum){
-			isPageFound = true;
-			break;
-		}
-		currentPageInfo = currentPageInfo->next;
-	}
+    int count = numOfPages;
+    if (!isWrite && startPage + count > pool->fh.totalNumPages) {
+        count = (pool->fh.totalNumPages > startPage) ? pool->fh.totalNumPages - startPage : 0;
+    }
+    if (count > 0 && (isWrite ? writeBlocks(startPage, count, &pool->fh, buffers)
+                              : readBlocks(startPage, count, &pool->fh, buffers)) == RC_OK) {
+        for (int i = 0; i < count; i++) {
+            transferred[i] = true;
+        }
+    }
+}
+
+/**
+*
+* This function reads or writes the pages of frames sorted by page number through the pool's asynchronous I/O
+* queue. Each run of adjacent pages is one vectored request and all runs are in flight together, up to the depth
+* of the queue. If the queue is not backed by the kernel it would only carry each request out synchronously, so the
+* runs are read and written directly (readBlocks, writeBlocks), one vectored call per run. transferred[i] tells
+* whether the page of frame i was fully read or written. The caller holds the I/O latch.
+*
+*/
+void transferFrameRuns(BufferPoolMgmt *const pool, PageNode **const pageNodes, const int numOfFrames,
+                       const bool isWrite, bool *const transferred)
+{
+    SM_PageHandle buffers[SM_MAX_ASYNC_PAGES];
+    SM_IOCompletion completions[ASYNC_IO_QUEUE_DEPTH];
+    int numOfCompletions;
+
+    memset(transferred, 0, numOfFrames * sizeof(bool));
+    for (int first = 0, last; first < numOfFrames; first = last) {
+        buffers[0] = pageNodes[first]->data;
+        for (last = first + 1; last < numOfFrames && last - first < SM_MAX_ASYNC_PAGES
+             && pageNodes[last]->pageNum == pageNodes[last - 1]->pageNum + 1; last++) {
+            buffers[last - first] = pageNodes[last]->data;
+        }
+
+        if (!pool->aio.kernelQueue) {
+            transferFrameRun(pool, pageNodes[first]->pageNum, last - first, buffers, isWrite, transferred + first);
+            continue;
+        }
+        while (true) {
+            RC rc = isWrite ? submitWrite(&pool->aio, &pool->fh, pageNodes[first]->pageNum, last - first, buffers, (void *)(intptr_t)first)
+                            : submitRead(&pool->aio, &pool->fh, pageNodes[first]->pageNum, last - first, buffers, (void *)(intptr_t)first);
+            if (rc != RC_IO_QUEUE_FULL) {
+                break;
+            }
+            rc = reapCompletions(&pool->aio, completions, ASYNC_IO_QUEUE_DEPTH, 1, &numOfCompletions);
+            markTransferred(completions, numOfCompletions, transferred);
+            if (rc != RC_OK && numOfCompletions == 0) {
+                break;
+            }
+        }
+    }
+
+    while (pendingAsyncIO(&pool->aio) > 0) {
+        RC rc = reapCompletions(&pool->aio, completions, ASYNC_IO_QUEUE_DEPTH, ASYNC_IO_QUEUE_DEPTH, &numOfCompletions);
+        markTransferred(completions, numOfCompletions, transferred);
+        if (rc != RC_OK && numOfCompletions == 0) {
+            break;
+        }
+    }
+}
+
+/**
+*
+* This function reads the pages of several frames under a single acquisition of the I/O latch and then wakes up the
+* threads waiting for any of them. The reads go through the asynchronous I/O queue, so all of them are in flight at
+* once; a page that could not be read is presented as an empty page, like readFrameData does. With dropPin the pins
+* taken for the reads are dropped (see finishFrameRead).
+*
+*/
+void readIntoFrames(BufferPoolMgmt *const pool, PageNode **const pageNodes, const int numOfFrames, const bool dropPin)
+{
+    qsort(pageNodes, numOfFrames, sizeof(PageNode *), comparePageNodes);
+    bool *transferred = malloc(numOfFrames * sizeof(bool));
+
+    pthread_mutex_lock(&pool->ioLatch);
+    if (transferred) {
+        transferFrameRuns(pool, pageNodes, numOfFrames, false, transferred);
+        for (int i = 0; i < numOfFrames; i++) {
+            if (transferred[i]) {
+                atomic_fetch_add_explicit(&pool->numOfReadOps, 1, memory_order_relaxed);
+                pageNodes[i]->corrupt = pool->verifyChecksums && verifyPage(pageNodes[i]->pageNum, &pool->fh, pageNodes[i]->data) != RC_OK;
+            } else {
+                memset(pageNodes[i]->data, 0, PAGE_SIZE);
+            }
+        }
+    } else {
+        for (int i = 0; i < numOfFrames; i++) {
+            readFrameData(pool, pageNodes[i]);
+        }
+    }
+    pthread_mutex_unlock(&pool->ioLatch);
+    free(transferred);
+
+    for (int i = 0; i < numOfFrames; i++) {
+        finishFrameRead(pool, pageNodes[i], dropPin);
+    }
+}
+
+/**
+*
+* This function will check whether the BufferQueue is empty
+*
+*/
+
+bool isQueueEmpty(BufferQueue *const queue)
+{
+   return queue->numOfFreeFrames==queue->frameCount;
+}
+
+/**
+*
+* These functions unlink a frame from the BufferQueue and relink it at the front or the rear of the queue.
+*
+*/
+void unlinkPageNode(BufferQueue *const queue, PageNode *const pageNode)
+{
+    if (pageNode->prev) {
+        pageNode->prev->next = pageNode->next;
+    } else {
+        queue->front = pageNode->next;
+    }
+
+    if (pageNode->next) {
+        pageNode->next->prev = pageNode->prev;
+    } else {
+        queue->rear = pageNode->prev;
+    }
+    pageNode->prev = pageNode->next = NULL;
+}
+
+void linkAtFront(BufferQueue *const queue, PageNode *const pageNode)
+{
+    pageNode->prev = NULL;
+    pageNode->next = queue->front;
+    if (queue->front) {
+        queue->front->prev = pageNode;
+    } else {
+        queue->rear = pageNode;
+    }
+    queue->front = pageNode;
+}
+
+void linkAtRear(BufferQueue *const queue, PageNode *const pageNode)
+{
+    pageNode->next = NULL;
+    pageNode->prev = queue->rear;
+    if (queue->rear) {
+        queue->rear->next = pageNode;
+    } else {
+        queue->front = pageNode;
+    }
+    queue->rear = pageNode;
+}
+
+/**
+*
+* This function writes a frame back to disk if it is dirty and clears its dirty flag. The flag is cleared before the
+* write, so a page dirtied again while it is being written stays dirty. written tells whether the frame was written.
+*
+*/
+RC writeBackFrame(BufferPoolMgmt *const pool, PageNode *const pageNode, bool *const written)
+{
+    pthread_mutex_lock(&pageNode->latch);
+    bool dirty = pageNode->dirtyFlag;
+    *written = false;
+    pageNode->dirtyFlag = false;
+    pthread_mutex_unlock(&pageNode->latch);
+
+    if (!dirty) {
+        return RC_OK;
+    }
+
+    pthread_mutex_lock(&pool->ioLatch);
+    RC rc = writeBlock(pageNode->pageNum, &pool->fh, pageNode->data);
+    if (rc == RC_OK) {
+        pool->numOfWriteOps++;
+    }
+    pthread_mutex_unlock(&pool->ioLatch);
+
+    if (rc != RC_OK) {
+        pthread_mutex_lock(&pageNode->latch);
+        pageNode->dirtyFlag = true;
+        pthread_mutex_unlock(&pageNode->latch);
+        return RC_WRITE_FAILED;
+    }
+    *written = true;
+    return RC_OK;
+}
+
+/**
+*
+* This function returns a frame that holds no page, or NULL once every frame has been filled.
+* Empty frames are handed out in frame order.
+*
+*/
+PageNode *getEmptyFrame(BufferQueue *const queue)
+{
+    if (queue->numOfFreeFrames == 0) {
+        return NULL;
+    }
+    return queue->frames[queue->freeFrames[--queue->numOfFreeFrames]];
+}
+
+/**
+*
+* This function evicts the page held by the victim frame: the page is written back if it is dirty and
+* removed from the page table, after which the frame can be reused. The victim is claimed under its stripe
+* and frame latches; if another thread pinned it in the meantime RC_FRAME_IN_USE is returned and the frame
+* keeps its page. The strategies may therefore pick victims from pin counts read without the frame latch.
+*
+*/
+RC evictFrame(BufferPoolMgmt *const pool, PageNode *const victim)
+{
+    if (victim->pageNum == NO_PAGE) {
+        return RC_OK;
+    }
+
+    bool wroteVictim = false;
+    while (true) {
+        bool written;
+        if (victim->dirtyFlag && pool->writer) {
+            // The background writer fell behind, let it start its next round right away
+            pthread_cond_signal(&pool->writer->wakeup);
+        }
+        if (writeBackFrame(pool, victim, &written) != RC_OK) {
+            return RC_WRITE_FAILED;
+        }
+        wroteVictim = wroteVictim || written;
+
+        PageTableStripe *stripe = stripeOf(pool, victim->pageNum);
+        pthread_mutex_lock(&stripe->latch);
+        pthread_mutex_lock(&victim->latch);
+        bool inUse = victim->fixCount > 0;
+        bool claimed = !inUse && !victim->dirtyFlag && !victim->writeInProgress;
+        if (claimed) {
+            removePageTable(&stripe->table, victim->pageNum);
+            victim->pageNum = NO_PAGE;
+        }
+        pthread_mutex_unlock(&stripe->latch);
+
+        // A frame that is being written by the background writer can be claimed once the write has finished
+        while (!inUse && victim->writeInProgress) {
+            pthread_cond_wait(&victim->ioDone, &victim->latch);
+        }
+        pthread_mutex_unlock(&victim->latch);
+
+        if (inUse) {
+            return RC_FRAME_IN_USE;
+        }
+        if (claimed) {
+            atomic_fetch_add_explicit(&pool->numOfEvictions, 1, memory_order_relaxed);
+            if (wroteVictim) {
+                atomic_fetch_add_explicit(&pool->numOfDirtyEvictions, 1, memory_order_relaxed);
+            }
+            return RC_OK;
+        }
+    }
+}
+
+/**
+*
+* If the current pin recycles a frame of an access ring, this function evicts the page held by that frame and
+* returns the frame in victim. victim is NULL if there is no ring frame or another thread pinned it meanwhile.
+*
+*/
+RC claimRingVictim(BufferPoolMgmt *const pool, PageNode **const victim)
+{
+    *victim = NULL;
+    if (!pool->ringVictim) {
+        return RC_OK;
+    }
+
+    RC rc = evictFrame(pool, pool->ringVictim);
+    if (rc == RC_OK) {
+        *victim = pool->ringVictim;
+    }
+    return (rc == RC_FRAME_IN_USE) ? RC_OK : rc;
+}
+
+/**
+*
+* This function assigns pageNum to the given frame, pins it once, registers it in the page table and points the page
+* handle at it. The frame is marked as being read and remembered in pool->pendingLoad; pinPage reads the page once it
+* has released the strategy latch, and other threads pinning the page wait until the read has finished.
+*
+*/
+RC loadPageIntoFrame(BufferPoolMgmt *const pool, PageNode *const pageNode, BM_PageHandle *const page, const PageNumber pageNum)
+{
+    PageTableStripe *stripe = stripeOf(pool, pageNum);
+
+    pthread_mutex_lock(&pageNode->latch);
+    pageNode->pageNum = pageNum;
+    pageNode->fixCount = 1;
+    pageNode->dirtyFlag = false;
+    pageNode->refBit = true;
+    pageNode->ioInProgress = true;
+    pageNode->corrupt = false;
+    pageNode->loadSeq = atomic_load_explicit(&pool->accessClock, memory_order_relaxed);
+    pthread_mutex_unlock(&pageNode->latch);
+
+    pthread_mutex_lock(&stripe->latch);
+    RC rc = insertPageTable(&stripe->table, pageNum, pageNode->frameNumber);
+    pthread_mutex_unlock(&stripe->latch);
+
+    if (rc != RC_OK) {
+        pageNode->pageNum = NO_PAGE;
+        pageNode->fixCount = 0;
+        pageNode->ioInProgress = false;
+        return rc;
+    }
+
+    pool->pendingLoad = pageNode;
+    page->data = pageNode->data;
+    page->pageNum = pageNum;
+    return RC_OK;
+}
 
-	if (isPageFound)
+/**
+*
+* This function will remove the least recently used item from the BufferQueue. Before removing an item it will check
+* whether the queue is empty. If the queue is empty it will simply return NULL. Otherwise the unpinned frame closest
+* to the rear of the queue is evicted and returned so that it can be reused.
+*/
+PageNode *removeBufferItem(BufferPoolMgmt *const pool)
+{
+	if (isQueueEmpty(&pool->queue))
 	{
-		++currentPageInfo->fixCount;
-		page->data = currentPageInfo->data;
-		page->pageNum = (page)?pageNum:-1;
-		return RC_OK;
+		return NULL;
 	}
 
-	currentPageInfo = bufferQueue->front;
-	while (bufferQueue->numOfFilledFrames < bufferQueue->frameCount)
-	{
-		if (currentPageInfo->pageNum == -1)
-		{
-			currentPageInfo->pageNum = pageNum;
-			page->pageNum = pageNum;
-            currentPageInfo->fixCount = 1;
-			currentPageInfo->dirtyFlag = false;
-			bufferQueue->numOfFilledFrames = bufferQueue->numOfFilledFrames + 1;
-			readBlock(currentPageInfo->pageNum, fh, currentPageInfo->data);
-            numOfReadOps = readBlock(currentPageInfo->pageNum, fh, currentPageInfo->data) == RC_OK?numOfReadOps+1:numOfReadOps;
-			page->data = currentPageInfo->data;
-			return RC_OK;
+	// A pin through an access ring recycles the ring's frame instead, unless a hit pinned it meanwhile
+	if (pool->ringVictim) {
+		RC rc = evictFrame(pool, pool->ringVictim);
+		if (rc != RC_FRAME_IN_USE) {
+			return (rc == RC_OK) ? pool->ringVictim : NULL;
 		}
-		currentPageInfo = currentPageInfo->next;
 	}
 
-
-	PageNode *newNode = (PageNode *)malloc(sizeof(PageNode));
-	newNode->data = NULL;
-	newNode->next = NULL;
-	newNode->fixCount = 1;
-	newNode->dirtyFlag = false;
-	newNode->pageNum = pageNum;
-	page->pageNum = pageNum;
-	newNode->prev = bufferQueue->rear;
-	currentPageInfo = bufferQueue->front;
-	
-	while(currentPageInfo && currentPageInfo->fixCount){
-		currentPageInfo = currentPageInfo->next;
+	PageNode *page = pool->queue.rear;
+	while (page) {
+		if (!page->fixCount) {
+			RC rc = evictFrame(pool, page);
+			if (rc == RC_OK) {
+				return page;
+			}
+			if (rc != RC_FRAME_IN_USE) {
+				return NULL;
+			}
+		}
+		page = page->prev;
 	}
+	return NULL;
+}
 
+/**
+*
+* This function adds a new buffer item to the BufferQueue. An empty frame is used while there is one, otherwise the
+* least recently used page is removed first. The page is then read into the frame, which becomes the front of the queue.
+*
+*/
+RC addBufferItem(BM_PageHandle *const page, const PageNumber pageNum, BM_BufferPool *const bm)
+{
+	BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+	PageNode *pageNode = pool->ringVictim ? NULL : getEmptyFrame(&pool->queue);
 
-	if (!currentPageInfo)
-	{
-		printf("##Checkpoint: No free buffer##");
-		return RC_FULL_BUFFER;
+	// Check if the buffer pool is full. If it is, remove a page from the buffer pool to make room for the new page.
+	if (!pageNode) {
+		pageNode = removeBufferItem(pool);
+		if (!pageNode) {
+			return RC_FULL_BUFFER;
+		}
 	}
 
-	backupPageInfo = currentPageInfo;
-	if (currentPageInfo == bufferQueue->front)
-	{
-		bufferQueue->front->prev = NULL;
-		bufferQueue->front = (bufferQueue)?bufferQueue->front->next:bufferQueue->front;
-	}
-	else if (currentPageInfo != bufferQueue->rear)
-	{
-		currentPageInfo->prev->next = currentPageInfo->next;
-		currentPageInfo->next->prev = currentPageInfo->prev;
+	RC rc = loadPageIntoFrame(pool, pageNode, page, pageNum);
+	if (rc != RC_OK) {
+		return rc;
 	}
-	else
-	{
-		bufferQueue->rear = currentPageInfo->prev;
-		newNode->prev = (bufferQueue)?bufferQueue->rear:newNode->prev;
+	unlinkPageNode(&pool->queue, pageNode);
+	// Pages of an access ring are not made most recently used, so they are the first to go
+	if (pool->ringMode) {
+		linkAtRear(&pool->queue, pageNode);
+	} else {
+		linkAtFront(&pool->queue, pageNode);
 	}
+	return RC_OK;
+}
 
+/**
+*
+* This function updates the attributes of buffer pool.
+*
+*/
+void updateBM_BufferPool(BM_BufferPool *const bm, const char *const pageFileName, const int numPages, ReplacementStrategy strategy, BufferPoolMgmt *const pool)
+{
+    bm->pageFile = strdup(pageFileName);
+    bm->numPages = numPages;
+    bm->strategy = strategy;
+    bm->mgmtData = pool;
+}
 
-	if (backupPageInfo->dirtyFlag == true)
-	{
-		numOfWriteOps = writeBlock(backupPageInfo->pageNum, fh, backupPageInfo->data) == RC_OK?numOfWriteOps+1:numOfWriteOps;
-	}
-	
-	newNode->data = backupPageInfo->data;
-	newNode->frameNumber = backupPageInfo->frameNumber;
-	bufferQueue->rear->next = newNode;
-	bufferQueue->rear = newNode;
-	numOfReadOps = readBlock(pageNum, fh, newNode->data) == RC_OK?numOfReadOps+1: numOfReadOps;
-	page->data = newNode->data;
-	return RC_OK;
-}
\ No newline at end of file
+/**
+*
+* This function pins pageNum through the replacement strategy of the pool; the caller holds the strategy latch. The
+* accesses recorded without the latch are applied first. If the page was not resident, the frame assigned to it is
+* returned in pendingLoad and the caller has to read the page into it.
+*
+*/
+RC pinWithStrategy(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum, PageNode **const pendingLoad)
+{
+    RC res;
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+
+    applyPageAccesses(pool, false);
+    pool->pendingLoad = NULL;
+    switch (bm->strategy)
+    {
+        case RS_FIFO:
+            res = pinPageWithFIFO(bm, page, pageNum);
+            break;
+        case RS_LRU:
+            res = pinPageWithLRU(bm, page, pageNum);
+            break;
+        case RS_CLOCK:
+            res = pinPageWithCLOCK(bm, page, pageNum);
+            break;
+        case RS_LFU:
+            res = pinPageWithLFU(bm, page, pageNum);
+            break;
+        case RS_LRU_K:
+            res = pinPageWithLRUK(bm, page, pageNum);
+            break;
+        case RS_ARC:
+            res = pinPageWithARC(bm, page, pageNum);
+            break;
+        default:
+            res = RC_INVALID_STRATEGY;
+            break;
+    }
+    *pendingLoad = pool->pendingLoad;
+    pool->pendingLoad = NULL;
+    return res;
+}
+
+/**
+*
+* This function runs the replacement strategy of the pool under the strategy latch and pins pageNum, see
+* pinWithStrategy.
+*
+*/
+RC runReplacementStrategy(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum, PageNode **const pendingLoad)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+
+    pthread_mutex_lock(&pool->strategyLatch);
+    RC res = pinWithStrategy(bm, page, pageNum, pendingLoad);
+    pthread_mutex_unlock(&pool->strategyLatch);
+    return res;
+}
+
+/**
+*
+* This function pins a page in the buffer pool. A resident page is pinned without the strategy latch: FIFO and CLOCK
+* do not reorder anything on a hit, the other strategies get the hit recorded and apply it later (see PageAccess).
+* Every other pin runs the replacement strategy under the strategy latch; if it assigned the page to a frame, the
+* page is read after the latch has been released.
+*
+*/
+RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    if (pageNum < 0) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    LATENCY_START(start);
+    PageNode *pendingLoad = NULL;
+    PageNode *hit = pinResidentPage(pool, page, pageNum);
+    if (!hit) {
+        RC res = runReplacementStrategy(bm, page, pageNum, &pendingLoad);
+        if (res != RC_OK) {
+            return res;
+        }
+    } else if (bm->strategy == RS_LRU) {
+        TRACE_EVENT(TRACE_LEVEL_DEBUG, TRACE_LRU_HIT, pageNum, hit->frameNumber, 0);
+    }
+
+    countPin(pool, pendingLoad != NULL);
+    if (pendingLoad) {
+        readIntoFrame(pool, pendingLoad, false);
+    }
+    RC rc = finishPin(pool, page);
+    if (rc != RC_OK) {
+        return rc;
+    }
+    if (pool->readAhead) {
+        readAheadAfterPin(bm, pageNum, false);
+    }
+    LATENCY_RECORD(pendingLoad ? LATENCY_PIN_MISS : LATENCY_PIN_HIT, start);
+    return RC_OK;
+}
+
+/**
+*
+* This function tells whether a page is resident in the pool at the moment.
+*
+*/
+bool isPageResident(BufferPoolMgmt *const pool, const PageNumber pageNum)
+{
+    PageTableStripe *stripe = stripeOf(pool, pageNum);
+    pthread_mutex_lock(&stripe->latch);
+    bool resident = lookupPageTable(&stripe->table, pageNum) >= 0;
+    pthread_mutex_unlock(&stripe->latch);
+    return resident;
+}
+
+/**
+*
+* This function pins a page that the caller only reads. In mapped storage mode a page that is not resident is not
+* loaded into a frame: the handle points straight into the mapping of the page file (zero copy), shows the page as
+* last written to the file and must not be written to or marked dirty. Such a pin is neither a hit nor a miss. A
+* resident page, or any page in positional mode, is pinned like pinPage does. Either kind is released with unpinPage.
+*
+*/
+RC pinPageReadOnly(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    if (pageNum < 0) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    SM_PageHandle mappedPage;
+    if (pool->storageMode == BM_STORAGE_MAPPED && !isPageResident(pool, pageNum)
+        && getMappedBlock(pageNum, &pool->fh, &mappedPage) == RC_OK) {
+        if (pool->verifyChecksums && verifyPage(pageNum, &pool->fh, mappedPage) != RC_OK) {
+            return RC_CHECKSUM_MISMATCH;
+        }
+        atomic_fetch_add_explicit(&pool->numOfMappedPins, 1, memory_order_relaxed);
+        page->pageNum = pageNum;
+        page->data = mappedPage;
+        if (pool->readAhead) {
+            readAheadAfterPin(bm, pageNum, true);
+        }
+        return RC_OK;
+    }
+    return pinPage(bm, page, pageNum);
+}
+
+/**
+*
+* This function pins the n pages listed in pageNums and fills one page handle per page. The replacement strategy
+* runs for the whole batch under a single acquisition of the strategy latch, and the pages that missed are then read
+* together, in file order. Either every page is pinned or, if one of them cannot be, none is.
+*
+*/
+RC pinPages(BM_BufferPool *const bm, const PageNumber *const pageNums, BM_PageHandle *const pages, const int n)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    for (int i = 0; i < n; i++) {
+        if (pageNums[i] < 0) {
+            return RC_READ_NON_EXISTING_PAGE;
+        }
+    }
+
+    PageNode **pendingLoads = malloc((n > 0 ? n : 1) * sizeof(PageNode *));
+    if (!pendingLoads) {
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+
+    RC res = RC_OK;
+    int numOfPinned = 0;
+    int numOfPendingLoads = 0;
+
+    pthread_mutex_lock(&pool->strategyLatch);
+    while (numOfPinned < n && res == RC_OK) {
+        PageNode *pendingLoad = NULL;
+        res = pinWithStrategy(bm, &pages[numOfPinned], pageNums[numOfPinned], &pendingLoad);
+        if (res == RC_OK) {
+            numOfPinned++;
+            countPin(pool, pendingLoad != NULL);
+            if (pendingLoad) {
+                pendingLoads[numOfPendingLoads++] = pendingLoad;
+            }
+        }
+    }
+    pthread_mutex_unlock(&pool->strategyLatch);
+
+    // The frames assigned to this batch are read even if the batch failed, other threads may be waiting for them
+    readIntoFrames(pool, pendingLoads, numOfPendingLoads, false);
+    free(pendingLoads);
+
+    if (res != RC_OK) {
+        unpinPages(bm, pages, numOfPinned);
+        return res;
+    }
+    for (int i = 0; i < n; i++) {
+        if (waitForFrame(pool, findFrame(pool, pages[i].pageNum)) != RC_OK) {
+            res = RC_CHECKSUM_MISMATCH;
+        }
+    }
+    if (res != RC_OK) {
+        unpinPages(bm, pages, n);
+    }
+    return res;
+}
+
+/**
+*
+* This function releases the memory of a pool's bookkeeping. It is used by shutdownBufferPool and to undo a
+* partially initialized pool; the page file must already be closed.
+*
+*/
+void freeBufferPoolMgmt(BufferPoolMgmt *const pool)
+{
+    for (int i = 0; i < PAGE_TABLE_STRIPES; i++) {
+        pthread_mutex_destroy(&pool->pageTable[i].latch);
+        free(pool->pageTable[i].table.slots);
+    }
+    freeBufferQueue(&pool->queue);
+    if (pool->aio.mgmtInfo) {
+        shutdownAsyncIO(&pool->aio);
+    }
+    pthread_mutex_destroy(&pool->strategyLatch);
+    pthread_mutex_destroy(&pool->ioLatch);
+    pthread_rwlock_destroy(&pool->resizeLatch);
+    if (pool->lfu) {
+        free(pool->lfu->buckets);
+        free(pool->lfu);
+    }
+    if (pool->lruk) {
+        freeLRUK(pool->lruk);
+        free(pool->lruk);
+    }
+    if (pool->arc) {
+        freeARC(pool->arc);
+        free(pool->arc);
+    }
+    free(pool->accessBatch);
+    free(pool);
+}
+
+/**
+*
+* This function initializes the state of the pool's replacement strategy, if the strategy keeps any, and the room
+* to apply recorded accesses in for the strategies that reorder their frames on a hit.
+*
+*/
+RC initializeStrategy(BufferPoolMgmt *const pool, const int numPages, ReplacementStrategy strategy, void *stratData)
+{
+    switch (strategy)
+    {
+        case RS_LFU:
+            pool->lfu = malloc(sizeof(LFUState));
+            if (!pool->lfu || initializeLFU(pool->lfu, numPages, stratData) != RC_OK) {
+                free(pool->lfu);
+                pool->lfu = NULL;
+                return RC_BUFFER_POOL_INITIALIZE_ERROR;
+            }
+            break;
+        case RS_LRU_K:
+            pool->lruk = malloc(sizeof(LRUKState));
+            if (!pool->lruk || initializeLRUK(pool->lruk, pool->queue.frames, numPages, stratData) != RC_OK) {
+                free(pool->lruk);
+                pool->lruk = NULL;
+                return RC_BUFFER_POOL_INITIALIZE_ERROR;
+            }
+            break;
+        case RS_ARC:
+            pool->arc = malloc(sizeof(ARCState));
+            if (!pool->arc || initializeARC(pool->arc, numPages) != RC_OK) {
+                free(pool->arc);
+                pool->arc = NULL;
+                return RC_BUFFER_POOL_INITIALIZE_ERROR;
+            }
+            break;
+        default:
+            break;
+    }
+    if (strategy != RS_FIFO && strategy != RS_CLOCK) {
+        pool->accessBatch = malloc(PAGE_TABLE_STRIPES * ACCESS_BUFFER_SIZE * sizeof(PageAccess));
+        if (!pool->accessBatch) {
+            return RC_BUFFER_POOL_INITIALIZE_ERROR;
+        }
+    }
+    return RC_OK;
+}
+
+/**
+*
+* This function allocates the page table stripes of a pool and initializes the latches of the pool. Each stripe
+* starts out sized for an even share of the pool and grows on its own if pages cluster in it.
+*
+*/
+RC initializePageTableStripes(BufferPoolMgmt *const pool, const int numPages)
+{
+    pthread_mutex_init(&pool->strategyLatch, NULL);
+    pthread_mutex_init(&pool->ioLatch, NULL);
+    pthread_rwlock_init(&pool->resizeLatch, NULL);
+    for (int i = 0; i < PAGE_TABLE_STRIPES; i++) {
+        pthread_mutex_init(&pool->pageTable[i].latch, NULL);
+        if (initializePageTable(&pool->pageTable[i].table, numPages / PAGE_TABLE_STRIPES + 1) != RC_OK) {
+            return RC_BUFFER_POOL_INITIALIZE_ERROR;
+        }
+    }
+    return RC_OK;
+}
+
+/**
+*
+* This function initializes the Buffer Pool with its attributes like number of pages, page file name, and replacement strategy.
+* All bookkeeping of the pool is kept in a BufferPoolMgmt that bm->mgmtData points to.
+*
+*/
+RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, const int numPages, ReplacementStrategy strategy, void *stratData)
+{
+    return initBufferPoolWithMemory(bm, pageFileName, numPages, strategy, stratData, NULL);
+}
+
+/**
+*
+* This function initializes a Buffer Pool like initBufferPool does, with its frame memory backed as requested by
+* memory (see allocateArena). NULL means ordinary pages.
+*
+*/
+RC initBufferPoolWithMemory(BM_BufferPool *const bm, const char *const pageFileName, const int numPages,
+                            ReplacementStrategy strategy, void *stratData, const BM_PoolMemoryConfig *const memory)
+{
+    if (numPages <= 0) {
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+
+    BufferPoolMgmt *pool = calloc(1, sizeof(BufferPoolMgmt));
+    if (pool && memory) {
+        pool->memory = *memory;
+    }
+
+    if (!pool || initializePageTableStripes(pool, numPages) != RC_OK
+        || initializeBufferQueue(&pool->queue, numPages, &pool->memory) != RC_OK
+        || initializeStrategy(pool, numPages, strategy, stratData) != RC_OK
+        || initAsyncIO(&pool->aio, ASYNC_IO_QUEUE_DEPTH) != RC_OK) {
+        if (pool)
+            freeBufferPoolMgmt(pool);
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+	//If memory gets allocated, call update function for updating the attributes of the buffer pool.
+    updateBM_BufferPool(bm, pageFileName, numPages, strategy, pool);
+
+    RC rc = openPageFile(bm->pageFile, &pool->fh);
+
+    if (rc != RC_OK) {
+        freeBufferPoolMgmt(pool);
+        free(bm->pageFile);
+        bm->pageFile = NULL;
+        bm->mgmtData = NULL;
+        return rc;
+    }
+    pool->numOfReadOps = pool->numOfWriteOps = 0;
+
+    return RC_OK;
+}
+
+
+/**
+*
+* This function reports how the frame memory of a pool is actually backed: the kind of pages it got and whether it
+* is locked into RAM. A pool that grew may have segments backed differently, it is reported with the weakest of them.
+*
+*/
+RC getPoolMemory(BM_BufferPool *const bm, BM_PoolMemoryConfig *const memory)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+
+    pthread_rwlock_rdlock(&pool->resizeLatch);
+    memory->hugePages = pool->queue.segments[0].pages;
+    memory->lockMemory = true;
+    for (int i = 0; i < pool->queue.numOfSegments; i++) {
+        if (pool->queue.segments[i].pages < memory->hugePages) {
+            memory->hugePages = pool->queue.segments[i].pages;
+        }
+        memory->lockMemory = memory->lockMemory && pool->queue.segments[i].locked;
+    }
+    pthread_rwlock_unlock(&pool->resizeLatch);
+    return RC_OK;
+}
+
+/**
+*
+* This function switches the page file of a pool between positional and mapped storage (see BM_StorageMode) and
+* passes the expected access pattern on to the kernel. Leaving mapped mode is refused with RC_FRAME_IN_USE while
+* zero-copy pins are held. No other thread may use the pool during the switch.
+*
+*/
+RC setPoolStorageMode(BM_BufferPool *const bm, const BM_StorageMode mode, const BM_AccessPattern pattern)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+
+    pthread_mutex_lock(&pool->ioLatch);
+    RC rc;
+    if (mode == BM_STORAGE_MAPPED) {
+        rc = mapPageFile(&pool->fh);
+    } else if (atomic_load_explicit(&pool->numOfMappedPins, memory_order_relaxed) > 0) {
+        rc = RC_FRAME_IN_USE;
+    } else {
+        rc = unmapPageFile(&pool->fh);
+    }
+    if (rc == RC_OK) {
+        pool->storageMode = mode;
+        rc = adviseAccessPattern(&pool->fh, (SM_AccessPattern)pattern);
+    }
+    pthread_mutex_unlock(&pool->ioLatch);
+    return rc;
+}
+
+/**
+*
+* This function selects the checksum mode of a pool. The page file handle stores the checksums when pages are
+* written; verification is left to the pool, which checks a page once it has been read into its frame (or before
+* it is pinned zero-copy) and makes the pins of a corrupt page fail.
+*
+*/
+RC setPoolChecksumMode(BM_BufferPool *const bm, const BM_ChecksumMode mode)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+
+    pthread_mutex_lock(&pool->ioLatch);
+    RC rc = setChecksumMode(&pool->fh, (mode == BM_CHECKSUM_NONE) ? SM_CHECKSUM_NONE : SM_CHECKSUM_WRITE);
+    if (rc == RC_OK) {
+        pool->verifyChecksums = (mode == BM_CHECKSUM_VERIFY);
+    }
+    pthread_mutex_unlock(&pool->ioLatch);
+    return rc;
+}
+
+/**
+*
+* This function writes every unpinned dirty frame back. The frames are sorted by page number and each run of
+* adjacent pages goes to disk as one vectored write; the runs are submitted to the asynchronous I/O queue together,
+* so they are written concurrently (see transferFrameRuns). While they are written the frames are marked
+* writeInProgress, like the background writer does, so that pins go ahead and evictions wait for the write.
+* A run that cannot be written stays dirty and RC_WRITE_FAILED is returned once all runs have been tried.
+*
+*/
+RC flushDirtyFrames(BufferPoolMgmt *const pool)
+{
+    pthread_rwlock_rdlock(&pool->resizeLatch);
+    int frameCount = pool->queue.frameCount;
+    PageNode **dirtyFrames = malloc(frameCount * sizeof(PageNode *));
+    bool *written = malloc(frameCount * sizeof(bool));
+    int numOfDirtyFrames = 0;
+    RC rc = RC_OK;
+
+    if (!dirtyFrames || !written) {
+        pthread_rwlock_unlock(&pool->resizeLatch);
+        free(dirtyFrames);
+        free(written);
+        return RC_WRITE_FAILED;
+    }
+
+    for (int i = 0; i < frameCount; i++) {
+        PageNode *pageNode = pool->queue.frames[i];
+        pthread_mutex_lock(&pageNode->latch);
+        if (pageNode->pageNum != NO_PAGE && pageNode->fixCount == 0 && pageNode->dirtyFlag
+            && !pageNode->ioInProgress && !pageNode->writeInProgress) {
+            pageNode->dirtyFlag = false;
+            pageNode->writeInProgress = true;
+            dirtyFrames[numOfDirtyFrames++] = pageNode;
+        }
+        pthread_mutex_unlock(&pageNode->latch);
+    }
+    qsort(dirtyFrames, numOfDirtyFrames, sizeof(PageNode *), comparePageNodes);
+
+    pthread_mutex_lock(&pool->ioLatch);
+    transferFrameRuns(pool, dirtyFrames, numOfDirtyFrames, true, written);
+    for (int i = 0; i < numOfDirtyFrames; i++) {
+        if (written[i]) {
+            pool->numOfWriteOps++;
+        } else {
+            rc = RC_WRITE_FAILED;
+        }
+    }
+    pthread_mutex_unlock(&pool->ioLatch);
+
+    for (int i = 0; i < numOfDirtyFrames; i++) {
+        PageNode *pageNode = dirtyFrames[i];
+        pthread_mutex_lock(&pageNode->latch);
+        if (!written[i]) {
+            pageNode->dirtyFlag = true;
+        }
+        pageNode->writeInProgress = false;
+        pthread_cond_broadcast(&pageNode->ioDone);
+        pthread_mutex_unlock(&pageNode->latch);
+    }
+    pthread_rwlock_unlock(&pool->resizeLatch);
+
+    free(dirtyFrames);
+    free(written);
+    return rc;
+}
+
+/**
+*
+* This function will shutdown the buffer pool. It writes any dirty pages back to the disk if they are not being used by any process.
+* No other thread may use the pool during or after the shutdown. It is refused while zero-copy pins (see pinPageReadOnly) are held,
+* since they point into the mapping of the page file.
+*
+*/
+RC shutdownBufferPool(BM_BufferPool *const bm)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    if (atomic_load_explicit(&pool->numOfMappedPins, memory_order_relaxed) > 0) {
+        return RC_FRAME_IN_USE; // the mapping goes away with the page file
+    }
+
+    stopBackgroundWriter(bm);
+    stopReadAhead(pool);
+
+    if (flushDirtyFrames(pool) != RC_OK)
+        return RC_WRITE_FAILED;
+    closePageFile(&pool->fh);
+    freeBufferPoolMgmt(pool);
+    free(bm->pageFile);
+    bm->pageFile = NULL;
+    bm->mgmtData = NULL;
+    return RC_OK;
+}
+
+/**
+*
+* This function forcefully flushes all the unpinned dirty pages to the disk, in page order (see flushDirtyFrames).
+*
+*/
+RC forceFlushPool(BM_BufferPool *const bm)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    return flushDirtyFrames(pool);
+}
+
+/**
+*
+* This function unpins the page from the buffer pool.
+*
+*/
+RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    if (page->pageNum < 0) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    if (pool->storageMode == BM_STORAGE_MAPPED && isMappedBlock(&pool->fh, page->data)) {
+        atomic_fetch_sub_explicit(&pool->numOfMappedPins, 1, memory_order_relaxed);
+        return RC_OK;
+    }
+
+    LATENCY_START(start);
+    RC rc = unpinPageNumber(pool, page->pageNum);
+    LATENCY_RECORD(LATENCY_UNPIN, start);
+    return rc;
+}
+
+/**
+*
+* This function unpins the n pages of a batch pinned with pinPages. Every page is unpinned even if one of them is
+* not resident.
+*
+*/
+RC unpinPages(BM_BufferPool *const bm, BM_PageHandle *const pages, const int n)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    RC res = RC_OK;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (pages[i].pageNum < 0 || releasePin(pool, pages[i].pageNum) != RC_OK) {
+            res = RC_READ_NON_EXISTING_PAGE;
+        }
+    }
+    return res;
+}
+
+/**
+*
+* This function drops one pin of a resident page.
+*
+*/
+RC unpinPageNumber(BufferPoolMgmt *const pool, const PageNumber pageNum)
+{
+    return releasePin(pool, pageNum);
+}
+
+/**
+*
+* This function drops one pin of a resident page. LFU and LRU-K keep track of the frames that become unpinned (see
+* tracksUnpinnedFrames), so for such a pool dropping the last pin is recorded in the stripe's access buffer.
+*
+*/
+RC releasePin(BufferPoolMgmt *const pool, const PageNumber pageNum)
+{
+    PageTableStripe *stripe = stripeOf(pool, pageNum);
+    pthread_mutex_lock(&stripe->latch);
+    int frameNumber = lookupPageTable(&stripe->table, pageNum);
+    PageNode *currentPageInfo = (frameNumber < 0) ? NULL : pool->queue.frames[frameNumber];
+    bool released = false;
+    if (currentPageInfo) {
+        pthread_mutex_lock(&currentPageInfo->latch);
+        released = currentPageInfo->fixCount > 0 && --currentPageInfo->fixCount == 0;
+        pthread_mutex_unlock(&currentPageInfo->latch);
+    }
+    bool recorded = !released || !tracksUnpinnedFrames(pool) || recordAccess(pool, stripe, currentPageInfo, true);
+    pthread_mutex_unlock(&stripe->latch);
+
+    if (!recorded) {
+        releaseUnrecordedPin(pool, pageNum);
+    }
+    return (frameNumber < 0) ? RC_READ_NON_EXISTING_PAGE : RC_OK;
+}
+
+/**
+*
+* This function will write a page from the buffer pool to disk. The frame is only looked up under its stripe latch;
+* while the page is written it is marked writeInProgress, like the background writer does, so pins of any page go
+* ahead and an eviction of this one waits for the write. A write already in progress is waited for first.
+*
+*/
+RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    if (page->pageNum < 0) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    pthread_rwlock_rdlock(&pool->resizeLatch);
+    PageTableStripe *stripe = stripeOf(pool, page->pageNum);
+    pthread_mutex_lock(&stripe->latch);
+    int frameNumber = lookupPageTable(&stripe->table, page->pageNum);
+    if (frameNumber < 0) {
+        pthread_mutex_unlock(&stripe->latch);
+        pthread_rwlock_unlock(&pool->resizeLatch);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    PageNode *currentPageInfo = pool->queue.frames[frameNumber];
+    pthread_mutex_lock(&currentPageInfo->latch);
+    pthread_mutex_unlock(&stripe->latch);
+
+    while (currentPageInfo->writeInProgress || currentPageInfo->ioInProgress) {
+        pthread_cond_wait(&currentPageInfo->ioDone, &currentPageInfo->latch);
+    }
+    // An unpinned page may have been evicted while we waited, it was written back then
+    bool resident = currentPageInfo->pageNum == page->pageNum;
+    if (resident) {
+        currentPageInfo->dirtyFlag = false;
+        currentPageInfo->writeInProgress = true;
+    }
+    pthread_mutex_unlock(&currentPageInfo->latch);
+    if (!resident) {
+        pthread_rwlock_unlock(&pool->resizeLatch);
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    pthread_mutex_lock(&pool->ioLatch);
+	int writeBlockOut = writeBlock(page->pageNum, &pool->fh, currentPageInfo->data);
+	pool->numOfWriteOps = (writeBlockOut)?pool->numOfWriteOps:pool->numOfWriteOps+1;
+    pthread_mutex_unlock(&pool->ioLatch);
+
+    pthread_mutex_lock(&currentPageInfo->latch);
+	if(writeBlockOut){
+        currentPageInfo->dirtyFlag = true;
+	}
+    currentPageInfo->writeInProgress = false;
+    pthread_cond_broadcast(&currentPageInfo->ioDone);
+    pthread_mutex_unlock(&currentPageInfo->latch);
+    pthread_rwlock_unlock(&pool->resizeLatch);
+
+    return writeBlockOut ? RC_WRITE_FAILED : RC_OK;
+}
+
+
+/**
+*
+* This function marks a page in the buffer pool as dirty.
+*
+*/
+RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page) {
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    if (page->pageNum < 0) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    if (pool->storageMode == BM_STORAGE_MAPPED && isMappedBlock(&pool->fh, page->data)) {
+        return RC_WRITE_FAILED; // a zero-copy read-only pin has no frame to write back
+    }
+
+    PageTableStripe *stripe = stripeOf(pool, page->pageNum);
+    pthread_mutex_lock(&stripe->latch);
+    int frameNumber = lookupPageTable(&stripe->table, page->pageNum);
+    if (frameNumber >= 0) {
+        PageNode *currentPageInfo = pool->queue.frames[frameNumber];
+        pthread_mutex_lock(&currentPageInfo->latch);
+        currentPageInfo->dirtyFlag = true;
+        pthread_mutex_unlock(&currentPageInfo->latch);
+    }
+    pthread_mutex_unlock(&stripe->latch);
+
+    return (frameNumber < 0) ? RC_READ_NON_EXISTING_PAGE : RC_OK;
+}
+
+/**
+*
+* This function fills the arrays of a snapshot (see getPoolSnapshot) with one entry per frame; the caller holds the
+* resize latch, so the number of frames stays the same meanwhile.
+*
+*/
+void fillPoolSnapshot(BufferPoolMgmt *const pool, PageNumber *const frameContents, bool *const dirtyFlags, int *const fixCounts)
+{
+    for (int i = 0; i < pool->queue.frameCount; i++) {
+        PageNode *pageNode = pool->queue.frames[i];
+        pthread_mutex_lock(&pageNode->latch);
+        if (frameContents) {
+            frameContents[i] = pageNode->pageNum;
+        }
+        if (dirtyFlags) {
+            dirtyFlags[i] = pageNode->dirtyFlag;
+        }
+        if (fixCounts) {
+            fixCounts[i] = pageNode->fixCount;
+        }
+        pthread_mutex_unlock(&pageNode->latch);
+    }
+}
+
+/**
+*
+* This function fills the caller's arrays with the page, dirty flag and fix count of every frame and stats with the
+* counters of the pool, each of them may be NULL. It visits every frame once and holds only one frame latch at a
+* time, so it can be polled while the pool is in use; the result is then not one consistent state of the pool.
+*
+*/
+RC getPoolSnapshot(BM_BufferPool *const bm, PageNumber *const frameContents, bool *const dirtyFlags,
+                   int *const fixCounts, BM_PoolStatistics *const stats)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+
+    if (frameContents || dirtyFlags || fixCounts) {
+        pthread_rwlock_rdlock(&pool->resizeLatch);
+        fillPoolSnapshot(pool, frameContents, dirtyFlags, fixCounts);
+        pthread_rwlock_unlock(&pool->resizeLatch);
+    }
+
+    if (stats) {
+        stats->hits = atomic_load_explicit(&pool->numOfHits, memory_order_relaxed);
+        stats->misses = atomic_load_explicit(&pool->numOfMisses, memory_order_relaxed);
+        stats->evictions = atomic_load_explicit(&pool->numOfEvictions, memory_order_relaxed);
+        stats->dirtyEvictions = atomic_load_explicit(&pool->numOfDirtyEvictions, memory_order_relaxed);
+        stats->pinWaits = atomic_load_explicit(&pool->numOfPinWaits, memory_order_relaxed);
+        pthread_mutex_lock(&pool->ioLatch);
+        stats->readIO = atomic_load_explicit(&pool->numOfReadOps, memory_order_relaxed);
+        stats->writeIO = pool->numOfWriteOps;
+        pthread_mutex_unlock(&pool->ioLatch);
+    }
+    return RC_OK;
+}
+
+/**
+*
+* This function returns an array of page representing the page currently held in each frame of the buffer pool.
+* The array is sized and filled under the resize latch, so a concurrent resize cannot change the number of frames
+* in between.
+*
+*/
+PageNumber *getFrameContents(BM_BufferPool *const bm)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return NULL;
+    }
+
+    pthread_rwlock_rdlock(&pool->resizeLatch);
+    PageNumber *pages = calloc(pool->queue.frameCount, sizeof(PageNumber));
+    if (pages) {
+        fillPoolSnapshot(pool, pages, NULL, NULL);
+    }
+    pthread_rwlock_unlock(&pool->resizeLatch);
+    return pages;
+}
+
+/**
+*
+* This function returns reference to a boolean array that shows which pages in a buffer pool have been marked as dirty.
+* Like getFrameContents it sizes the array under the resize latch.
+*
+*/
+bool *getDirtyFlags(BM_BufferPool *const bm)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return NULL;
+    }
+
+    pthread_rwlock_rdlock(&pool->resizeLatch);
+    bool *dirtyFlagArray = calloc(pool->queue.frameCount, sizeof(bool));
+    if (dirtyFlagArray) {
+        fillPoolSnapshot(pool, NULL, dirtyFlagArray, NULL);
+    }
+    pthread_rwlock_unlock(&pool->resizeLatch);
+    return dirtyFlagArray;
+}
+
+/**
+*
+* This function returns an array of fixCounts for each page in the buffer pool, sized under the resize latch
+*
+*/
+int *getFixCounts(BM_BufferPool *const bm) {
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return NULL;
+    }
+
+    pthread_rwlock_rdlock(&pool->resizeLatch);
+    int *fixCountsArray = calloc(pool->queue.frameCount, sizeof(int));
+    if (fixCountsArray) {
+        fillPoolSnapshot(pool, NULL, NULL, fixCountsArray);
+    }
+    pthread_rwlock_unlock(&pool->resizeLatch);
+    return fixCountsArray;
+}
+
+/**
+*
+* This function returns the number of pages that have been read from the disk.
+*
+*/
+int getNumReadIO(BM_BufferPool *const bm)
+{
+	BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+	return atomic_load_explicit(&pool->numOfReadOps, memory_order_relaxed);
+}
+
+/**
+*
+* This function returns the number of pages that have been written to the disk.
+*
+*/
+int getNumWriteIO(BM_BufferPool *const bm)
+{
+	BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+	return pool->numOfWriteOps?pool->numOfWriteOps:0;
+}
+
+/**
+*
+* This function pins a page in the buffer pool using LRU page replacement policy
+*
+*/
+RC pinPageWithLRU(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+	BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+	PageNode *pageNode = findFrame(pool, pageNum);
+
+	if (!pageNode)
+	{
+		return addBufferItem(page, pageNum, bm);
+	}
+
+	pinFrame(pageNode);
+	page->data = pageNode->data;
+	page->pageNum = pageNum;
+	TRACE_EVENT(TRACE_LEVEL_DEBUG, TRACE_LRU_HIT, pageNum, pageNode->frameNumber, 0);
+
+	// Move the page to the front of the queue, the rear always holds the least recently used page
+	if (pageNode != pool->queue.front) {
+		unlinkPageNode(&pool->queue, pageNode);
+		linkAtFront(&pool->queue, pageNode);
+	}
+	return RC_OK;
+}
+
+/**
+*
+* This function pins a page in the buffer pool using FIFO page replacement policy
+*
+*/
+RC pinPageWithFIFO(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+	BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+	PageNode *currentPageInfo = findFrame(pool, pageNum);
+
+	if (currentPageInfo)
+	{
+		pinFrame(currentPageInfo);
+		page->data = currentPageInfo->data;
+		page->pageNum = pageNum;
+		return RC_OK;
+	}
+
+	// While the pool is not yet full the next empty frame is used, otherwise the oldest unpinned page is replaced
+	RC rc = claimRingVictim(pool, &currentPageInfo);
+	if (rc != RC_OK)
+	{
+		return rc;
+	}
+	if (!currentPageInfo)
+	{
+		currentPageInfo = getEmptyFrame(&pool->queue);
+	}
+	if (!currentPageInfo)
+	{
+		currentPageInfo = pool->queue.front;
+		while(currentPageInfo){
+			if (!currentPageInfo->fixCount)
+			{
+				rc = evictFrame(pool, currentPageInfo);
+				if (rc == RC_OK)
+				{
+					break;
+				}
+				if (rc != RC_FRAME_IN_USE)
+				{
+					return rc;
+				}
+			}
+			currentPageInfo = currentPageInfo->next;
+		}
+
+		if (!currentPageInfo)
+		{
+			TRACE_EVENT(TRACE_LEVEL_WARN, TRACE_NO_FREE_FRAME, pageNum, 0, 0);
+			return RC_FULL_BUFFER;
+		}
+	}
+
+	rc = loadPageIntoFrame(pool, currentPageInfo, page, pageNum);
+	if (rc != RC_OK)
+	{
+		return rc;
+	}
+	unlinkPageNode(&pool->queue, currentPageInfo);
+	linkAtRear(&pool->queue, currentPageInfo);
+	return RC_OK;
+}
+
+/**
+*
+* This function pins a page in the buffer pool using the CLOCK (second chance) page replacement policy.
+* A hit only sets the reference bit of the frame. On a miss the hand sweeps the frames in order: a frame whose
+* reference bit is set gets a second chance (the bit is cleared), the first unpinned frame without the bit is replaced.
+* Two full turns without a victim mean that every frame is pinned.
+*
+*/
+RC pinPageWithCLOCK(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+	BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+	PageNode *currentPageInfo = findFrame(pool, pageNum);
+
+	if (currentPageInfo)
+	{
+		pinFrame(currentPageInfo);
+		page->data = currentPageInfo->data;
+		page->pageNum = pageNum;
+		return RC_OK;
+	}
+
+	RC rc = claimRingVictim(pool, &currentPageInfo);
+	if (rc != RC_OK)
+	{
+		return rc;
+	}
+	if (!currentPageInfo)
+	{
+		currentPageInfo = getEmptyFrame(&pool->queue);
+	}
+	if (!currentPageInfo)
+	{
+		int sweep = 0;
+		while (sweep < 2 * pool->queue.frameCount)
+		{
+			PageNode *candidate = pool->queue.frames[pool->queue.clockHand];
+			pool->queue.clockHand = (pool->queue.clockHand + 1) % pool->queue.frameCount;
+
+			// Hits set the reference bit without the strategy latch, so the bit is tested and cleared under the frame latch
+			pthread_mutex_lock(&candidate->latch);
+			bool replaceable = candidate->fixCount == 0 && !candidate->refBit;
+			if (candidate->fixCount == 0)
+			{
+				candidate->refBit = false;
+			}
+			pthread_mutex_unlock(&candidate->latch);
+
+			if (replaceable)
+			{
+				// A frame pinned by another thread since the check is skipped like any other pinned frame
+				rc = evictFrame(pool, candidate);
+				if (rc == RC_OK)
+				{
+					currentPageInfo = candidate;
+					break;
+				}
+				if (rc != RC_FRAME_IN_USE)
+				{
+					return rc;
+				}
+			}
+			sweep++;
+		}
+
+		if (!currentPageInfo)
+		{
+			return RC_FULL_BUFFER;
+		}
+	}
+
+	rc = loadPageIntoFrame(pool, currentPageInfo, page, pageNum);
+	if (rc == RC_OK && pool->ringMode)
+	{
+		// A page of an access ring gets no second chance
+		currentPageInfo->refBit = false;
+	}
+	return rc;
+}
+
+/**
+*
+* This function prepares the LFU bookkeeping for a pool of numPages frames. Since every frame is in at most one bucket,
+* numPages buckets are enough; they are allocated once and chained into the free list. stratData may be NULL.
+*
+*/
+RC initializeLFU(LFUState *const lfu, const int numPages, const BM_LFU_StratData *const stratData)
+{
+    lfu->buckets = calloc(numPages, sizeof(FrequencyBucket));
+    if (!lfu->buckets) {
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+
+    for (int i = 0; i < numPages; i++) {
+        lfu->buckets[i].next = (i + 1 < numPages) ? &lfu->buckets[i + 1] : NULL;
+    }
+    lfu->freeBuckets = &lfu->buckets[0];
+    lfu->lowest = NULL;
+    lfu->agingInterval = (stratData && stratData->agingInterval > 0) ? stratData->agingInterval : 0;
+    lfu->pinsSinceAging = 0;
+    return RC_OK;
+}
+
+/**
+*
+* This function takes a bucket from the free list and links it into the bucket list right after prev
+* (or at the low end of the list if prev is NULL).
+*
+*/
+FrequencyBucket *newBucketAfter(LFUState *const lfu, FrequencyBucket *const prev, const int frequency)
+{
+    FrequencyBucket *bucket = lfu->freeBuckets;
+    lfu->freeBuckets = bucket->next;
+
+    bucket->frequency = frequency;
+    bucket->numOfFrames = 0;
+    bucket->head = bucket->tail = NULL;
+    bucket->prev = prev;
+    bucket->next = prev ? prev->next : lfu->lowest;
+    if (bucket->next) {
+        bucket->next->prev = bucket;
+    }
+    if (prev) {
+        prev->next = bucket;
+    } else {
+        lfu->lowest = bucket;
+    }
+    return bucket;
+}
+
+/**
+*
+* This function returns a bucket that no longer holds any frame to the free list.
+*
+*/
+void freeBucketIfEmpty(LFUState *const lfu, FrequencyBucket *const bucket)
+{
+    if (bucket->numOfFrames > 0) {
+        return;
+    }
+    if (bucket->prev) {
+        bucket->prev->next = bucket->next;
+    } else {
+        lfu->lowest = bucket->next;
+    }
+    if (bucket->next) {
+        bucket->next->prev = bucket->prev;
+    }
+    bucket->next = lfu->freeBuckets;
+    bucket->prev = NULL;
+    lfu->freeBuckets = bucket;
+}
+
+/**
+*
+* These functions remove an unpinned frame from, or append it to, the recency list of its bucket. A frame whose
+* release has not been applied yet is not in the list, so both check first.
+*
+*/
+bool inRecencyList(PageNode *const pageNode)
+{
+    return pageNode->policyPrev || pageNode->bucket->head == pageNode;
+}
+
+void unlinkFromBucket(PageNode *const pageNode)
+{
+    FrequencyBucket *bucket = pageNode->bucket;
+
+    if (!inRecencyList(pageNode)) {
+        return;
+    }
+    if (pageNode->policyPrev) {
+        pageNode->policyPrev->policyNext = pageNode->policyNext;
+    } else {
+        bucket->head = pageNode->policyNext;
+    }
+    if (pageNode->policyNext) {
+        pageNode->policyNext->policyPrev = pageNode->policyPrev;
+    } else {
+        bucket->tail = pageNode->policyPrev;
+    }
+    pageNode->policyNext = pageNode->policyPrev = NULL;
+}
+
+void releaseLFUFrame(PageNode *const pageNode)
+{
+    FrequencyBucket *bucket = pageNode->bucket;
+
+    if (inRecencyList(pageNode)) {
+        return;
+    }
+    pageNode->policyNext = NULL;
+    pageNode->policyPrev = bucket->tail;
+    if (bucket->tail) {
+        bucket->tail->policyNext = pageNode;
+    } else {
+        bucket->head = pageNode;
+    }
+    bucket->tail = pageNode;
+}
+
+/**
+*
+* This function registers a freshly loaded (and therefore pinned) frame with a frequency of one. Only a bucket
+* of frequency zero, which can exist after aging, may precede it.
+*
+*/
+void attachLFUFrame(LFUState *const lfu, PageNode *const pageNode)
+{
+    FrequencyBucket *prev = NULL;
+    FrequencyBucket *bucket = lfu->lowest;
+
+    if (bucket && bucket->frequency < 1) {
+        prev = bucket;
+        bucket = bucket->next;
+    }
+    if (!bucket || bucket->frequency != 1) {
+        bucket = newBucketAfter(lfu, prev, 1);
+    }
+    pageNode->bucket = bucket;
+    pageNode->policyNext = pageNode->policyPrev = NULL;
+    bucket->numOfFrames++;
+}
+
+/**
+*
+* This function records a hit: the frame leaves the recency list if it is in it and moves to the bucket of the
+* next higher frequency. A frame that is alone in its bucket simply bumps the bucket's frequency when that does not
+* collide with the following bucket.
+*
+*/
+void promoteLFUFrame(LFUState *const lfu, PageNode *const pageNode)
+{
+    FrequencyBucket *bucket = pageNode->bucket;
+    int frequency = bucket->frequency + 1;
+
+    unlinkFromBucket(pageNode);
+
+    if (bucket->numOfFrames == 1 && (!bucket->next || bucket->next->frequency != frequency)) {
+        bucket->frequency = frequency;
+        return;
+    }
+
+    FrequencyBucket *target = (bucket->next && bucket->next->frequency == frequency) ? bucket->next : newBucketAfter(lfu, bucket, frequency);
+    bucket->numOfFrames--;
+    target->numOfFrames++;
+    pageNode->bucket = target;
+    freeBucketIfEmpty(lfu, bucket);
+}
+
+/**
+*
+* This function returns the least recently used frame of the lowest frequency that has an unpinned frame, or NULL
+* if every frame is pinned. Only buckets made up entirely of pinned frames are skipped, so the search does not depend
+* on the pool size.
+*
+*/
+PageNode *selectLFUVictim(LFUState *const lfu)
+{
+    FrequencyBucket *bucket = lfu->lowest;
+
+    while (bucket && !bucket->head) {
+        bucket = bucket->next;
+    }
+    return bucket ? bucket->head : NULL;
+}
+
+/**
+*
+* This function drops an evicted frame from the LFU bookkeeping.
+*
+*/
+void detachLFUFrame(LFUState *const lfu, PageNode *const pageNode)
+{
+    FrequencyBucket *bucket = pageNode->bucket;
+
+    unlinkFromBucket(pageNode);
+    bucket->numOfFrames--;
+    pageNode->bucket = NULL;
+    freeBucketIfEmpty(lfu, bucket);
+}
+
+/**
+*
+* This function halves every frequency so that pages which used to be hot can eventually be evicted. Buckets whose
+* halved frequencies coincide (2k and 2k+1) are merged: the recency lists are concatenated and the frames of the
+* merged bucket are pointed at the surviving one. Aging touches every frame once, but it only runs once every
+* agingInterval pins.
+*
+*/
+void ageLFU(LFUState *const lfu, PageNode **const frames, const int frameCount)
+{
+    FrequencyBucket *bucket = lfu->lowest;
+
+    while (bucket) {
+        FrequencyBucket *next = bucket->next;
+        FrequencyBucket *prev = bucket->prev;
+
+        bucket->frequency >>= 1;
+        if (prev && prev->frequency == bucket->frequency) {
+            for (int i = 0; i < frameCount; i++) {
+                if (frames[i]->bucket == bucket) {
+                    frames[i]->bucket = prev;
+                }
+            }
+            if (bucket->head) {
+                if (prev->tail) {
+                    prev->tail->policyNext = bucket->head;
+                    bucket->head->policyPrev = prev->tail;
+                } else {
+                    prev->head = bucket->head;
+                }
+                prev->tail = bucket->tail;
+            }
+            prev->numOfFrames += bucket->numOfFrames;
+            bucket->numOfFrames = 0;
+            freeBucketIfEmpty(lfu, bucket);
+        }
+        bucket = next;
+    }
+    lfu->pinsSinceAging = 0;
+}
+
+/**
+*
+* This function pins a page in the buffer pool using the LFU page replacement policy. Ties between pages with the same
+* frequency are broken in LRU order. With aging enabled every agingInterval pins halve all frequencies first.
+*
+*/
+RC pinPageWithLFU(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+	BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+	PageNode *currentPageInfo = findFrame(pool, pageNum);
+
+	if (pool->lfu->agingInterval && ++pool->lfu->pinsSinceAging >= pool->lfu->agingInterval)
+	{
+		ageLFU(pool->lfu, pool->queue.frames, pool->queue.frameCount);
+	}
+
+	if (currentPageInfo)
+	{
+		promoteLFUFrame(pool->lfu, currentPageInfo);
+		pinFrame(currentPageInfo);
+		page->data = currentPageInfo->data;
+		page->pageNum = pageNum;
+		return RC_OK;
+	}
+
+	currentPageInfo = pool->ringVictim ? NULL : getEmptyFrame(&pool->queue);
+	while (!currentPageInfo)
+	{
+		currentPageInfo = pool->ringVictim ? pool->ringVictim : selectLFUVictim(pool->lfu);
+		if (!currentPageInfo)
+		{
+			return RC_FULL_BUFFER;
+		}
+
+		RC rc = evictFrame(pool, currentPageInfo);
+		if (rc == RC_FRAME_IN_USE)
+		{
+			// A hit pinned the victim meanwhile; applying it takes the frame off its recency list
+			pool->ringVictim = NULL;
+			applyPageAccesses(pool, false);
+			currentPageInfo = NULL;
+			continue;
+		}
+		if (rc != RC_OK)
+		{
+			return rc;
+		}
+		detachLFUFrame(pool->lfu, currentPageInfo);
+	}
+
+	RC rc = loadPageIntoFrame(pool, currentPageInfo, page, pageNum);
+	if (rc != RC_OK)
+	{
+		return rc;
+	}
+	attachLFUFrame(pool->lfu, currentPageInfo);
+	return RC_OK;
+}
+
+/**
+*
+* This function prepares the LRU-K bookkeeping. Without stratData the pool runs LRU-2 with no correlated reference
+* period and remembers the history of as many evicted pages as it has frames.
+*
+*/
+RC initializeLRUK(LRUKState *const lruk, PageNode **const frames, const int numPages, const BM_LRU_K_StratData *const stratData)
+{
+    lruk->k = (stratData && stratData->k > 0) ? stratData->k : 2;
+    lruk->correlatedRefPeriod = (stratData && stratData->correlatedRefPeriod > 0) ? stratData->correlatedRefPeriod : 0;
+    lruk->historySize = (stratData && stratData->historySize > 0) ? stratData->historySize : numPages;
+    lruk->clock = 0;
+    lruk->nextRetained = 0;
+
+    lruk->frameHistory = calloc((size_t)numPages * lruk->k, sizeof(unsigned long));
+    lruk->retained = calloc(lruk->historySize, sizeof(RetainedHistory));
+    lruk->retainedHistory = calloc((size_t)lruk->historySize * lruk->k, sizeof(unsigned long));
+    lruk->retainedTable.slots = NULL;
+    lruk->candidates.frames = malloc(numPages * sizeof(PageNode *));
+    lruk->correlated.frames = malloc(numPages * sizeof(PageNode *));
+    lruk->candidates.size = lruk->correlated.size = 0;
+
+    if (!lruk->frameHistory || !lruk->retained || !lruk->retainedHistory || !lruk->candidates.frames
+        || !lruk->correlated.frames || initializePageTable(&lruk->retainedTable, lruk->historySize) != RC_OK) {
+        freeLRUK(lruk);
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+
+    for (int i = 0; i < numPages; i++) {
+        frames[i]->history = &lruk->frameHistory[(size_t)i * lruk->k];
+        frames[i]->lastRef = 0;
+    }
+    for (int i = 0; i < lruk->historySize; i++) {
+        lruk->retained[i].pageNum = NO_PAGE;
+        lruk->retained[i].history = &lruk->retainedHistory[(size_t)i * lruk->k];
+    }
+    return RC_OK;
+}
+
+void freeLRUK(LRUKState *const lruk)
+{
+    free(lruk->frameHistory);
+    free(lruk->retained);
+    free(lruk->retainedHistory);
+    free(lruk->retainedTable.slots);
+    free(lruk->candidates.frames);
+    free(lruk->correlated.frames);
+}
+
+/**
+*
+* These functions maintain the heaps of LRU-K victim candidates. lrukHeapBefore tells whether a frame belongs closer
+* to the top of the given heap than another one; the heap of a frame is recorded in the frame, together with its
+* position, so a frame can be taken out of the middle of its heap when it is pinned or evicted.
+*
+*/
+bool lrukHeapBefore(LRUKState *const lruk, LRUKHeap *const heap, PageNode *const first, PageNode *const second)
+{
+    int kth = lruk->k - 1;
+
+    if (heap == &lruk->correlated) {
+        return first->lastRef < second->lastRef;
+    }
+    if (first->history[kth] != second->history[kth]) {
+        return first->history[kth] < second->history[kth];
+    }
+    return first->history[0] < second->history[0];
+}
+
+void lrukHeapPlace(LRUKHeap *const heap, PageNode *const pageNode, const int index)
+{
+    heap->frames[index] = pageNode;
+    pageNode->lrukHeap = heap;
+    pageNode->heapIndex = index;
+}
+
+void lrukHeapSiftUp(LRUKState *const lruk, LRUKHeap *const heap, int index)
+{
+    PageNode *pageNode = heap->frames[index];
+
+    while (index > 0 && lrukHeapBefore(lruk, heap, pageNode, heap->frames[(index - 1) / 2])) {
+        lrukHeapPlace(heap, heap->frames[(index - 1) / 2], index);
+        index = (index - 1) / 2;
+    }
+    lrukHeapPlace(heap, pageNode, index);
+}
+
+void lrukHeapSiftDown(LRUKState *const lruk, LRUKHeap *const heap, int index)
+{
+    PageNode *pageNode = heap->frames[index];
+
+    while (2 * index + 1 < heap->size) {
+        int child = 2 * index + 1;
+        if (child + 1 < heap->size && lrukHeapBefore(lruk, heap, heap->frames[child + 1], heap->frames[child])) {
+            child++;
+        }
+        if (!lrukHeapBefore(lruk, heap, heap->frames[child], pageNode)) {
+            break;
+        }
+        lrukHeapPlace(heap, heap->frames[child], index);
+        index = child;
+    }
+    lrukHeapPlace(heap, pageNode, index);
+}
+
+void lrukHeapPush(LRUKState *const lruk, LRUKHeap *const heap, PageNode *const pageNode)
+{
+    lrukHeapPlace(heap, pageNode, heap->size++);
+    lrukHeapSiftUp(lruk, heap, pageNode->heapIndex);
+}
+
+void lrukHeapRemove(LRUKState *const lruk, PageNode *const pageNode)
+{
+    LRUKHeap *heap = pageNode->lrukHeap;
+    int index = pageNode->heapIndex;
+
+    if (!heap) {
+        return;
+    }
+    pageNode->lrukHeap = NULL;
+    PageNode *last = heap->frames[--heap->size];
+    if (last != pageNode) {
+        lrukHeapPlace(heap, last, index);
+        lrukHeapSiftDown(lruk, heap, index);
+        lrukHeapSiftUp(lruk, heap, last->heapIndex);
+    }
+}
+
+/**
+*
+* This function makes a frame that has been unpinned a victim candidate, unless it already is one. The caller holds
+* the strategy latch.
+*
+*/
+void releaseLRUKFrame(LRUKState *const lruk, PageNode *const pageNode)
+{
+    if (!pageNode->lrukHeap) {
+        lrukHeapPush(lruk, &lruk->correlated, pageNode);
+    }
+}
+
+/**
+*
+* This function records a reference to a resident page at the current time. A reference that falls within the
+* correlated reference period of the previous one only moves lastRef. Otherwise the history is shifted by one; the
+* older entries are moved forward by the length of the correlated period that just ended, so that a burst of
+* correlated references counts as a single reference at its start.
+*
+*/
+void referenceLRUKFrame(LRUKState *const lruk, PageNode *const pageNode)
+{
+    unsigned long now = lruk->clock;
+
+    if (now - pageNode->lastRef > lruk->correlatedRefPeriod) {
+        unsigned long correlationPeriod = pageNode->lastRef - pageNode->history[0];
+        for (int i = lruk->k - 1; i > 0; i--) {
+            pageNode->history[i] = pageNode->history[i - 1] ? pageNode->history[i - 1] + correlationPeriod : 0;
+        }
+        pageNode->history[0] = now;
+    }
+    pageNode->lastRef = now;
+}
+
+/**
+*
+* This function saves the history of the page just evicted from pageNode in the retained ring, overwriting the
+* oldest record.
+*
+*/
+void retainLRUKHistory(LRUKState *const lruk, const PageNumber pageNum, PageNode *const pageNode)
+{
+    RetainedHistory *record = &lruk->retained[lruk->nextRetained];
+
+    if (record->pageNum != NO_PAGE) {
+        removePageTable(&lruk->retainedTable, record->pageNum);
+    }
+    record->pageNum = pageNum;
+    record->lastRef = pageNode->lastRef;
+    memcpy(record->history, pageNode->history, lruk->k * sizeof(unsigned long));
+    insertPageTable(&lruk->retainedTable, record->pageNum, lruk->nextRetained);
+    lruk->nextRetained = (lruk->nextRetained + 1) % lruk->historySize;
+}
+
+/**
+*
+* This function initializes the history of a page that was just read into a frame. If the page was seen before its
+* retained history and most recent reference are restored and the new pin counts as a reference to a resident page,
+* so a page that comes back within its correlated reference period does not gain a reference. Otherwise only the
+* current reference is known.
+*
+*/
+void attachLRUKFrame(LRUKState *const lruk, PageNode *const pageNode)
+{
+    int index = lookupPageTable(&lruk->retainedTable, pageNode->pageNum);
+
+    if (index >= 0) {
+        RetainedHistory *record = &lruk->retained[index];
+        memcpy(pageNode->history, record->history, lruk->k * sizeof(unsigned long));
+        pageNode->lastRef = record->lastRef;
+        removePageTable(&lruk->retainedTable, record->pageNum);
+        record->pageNum = NO_PAGE;
+        referenceLRUKFrame(lruk, pageNode);
+        return;
+    }
+    memset(pageNode->history, 0, lruk->k * sizeof(unsigned long));
+    pageNode->history[0] = lruk->clock;
+    pageNode->lastRef = lruk->clock;
+}
+
+/**
+*
+* This function selects the LRU-K victim: among the unpinned frames outside their correlated reference period, the one
+* whose K-th most recent reference is oldest (an unknown reference counts as infinitely old), with ties broken by the
+* most recent reference. If every unpinned frame is still within its correlated period the least recently referenced
+* unpinned frame is used instead. Frames whose period has run out are moved to the candidates heap first. Returns
+* NULL if every frame is pinned; the victim stays in its heap until it has been evicted.
+*
+*/
+PageNode *selectLRUKVictim(LRUKState *const lruk)
+{
+    LRUKHeap *correlated = &lruk->correlated;
+
+    while (correlated->size > 0 && lruk->clock - correlated->frames[0]->lastRef > lruk->correlatedRefPeriod) {
+        PageNode *pageNode = correlated->frames[0];
+        lrukHeapRemove(lruk, pageNode);
+        lrukHeapPush(lruk, &lruk->candidates, pageNode);
+    }
+    if (lruk->candidates.size > 0) {
+        return lruk->candidates.frames[0];
+    }
+    return (correlated->size > 0) ? correlated->frames[0] : NULL;
+}
+
+/**
+*
+* This function pins a page in the buffer pool using the LRU-K page replacement policy
+*
+*/
+RC pinPageWithLRUK(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+	BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+	PageNode *currentPageInfo = findFrame(pool, pageNum);
+
+	pool->lruk->clock++;
+	if (currentPageInfo)
+	{
+		lrukHeapRemove(pool->lruk, currentPageInfo);
+		referenceLRUKFrame(pool->lruk, currentPageInfo);
+		pinFrame(currentPageInfo);
+		page->data = currentPageInfo->data;
+		page->pageNum = pageNum;
+		return RC_OK;
+	}
+
+	currentPageInfo = pool->ringVictim ? NULL : getEmptyFrame(&pool->queue);
+	while (!currentPageInfo)
+	{
+		currentPageInfo = pool->ringVictim ? pool->ringVictim : selectLRUKVictim(pool->lruk);
+		if (!currentPageInfo)
+		{
+			return RC_FULL_BUFFER;
+		}
+
+		PageNumber victimPageNum = currentPageInfo->pageNum;
+		RC rc = evictFrame(pool, currentPageInfo);
+		if (rc == RC_FRAME_IN_USE)
+		{
+			// A hit pinned the victim meanwhile; applying it takes the frame out of its heap
+			pool->ringVictim = NULL;
+			applyPageAccesses(pool, false);
+			currentPageInfo = NULL;
+			continue;
+		}
+		if (rc != RC_OK)
+		{
+			return rc;
+		}
+		lrukHeapRemove(pool->lruk, currentPageInfo);
+		retainLRUKHistory(pool->lruk, victimPageNum, currentPageInfo);
+	}
+
+	RC rc = loadPageIntoFrame(pool, currentPageInfo, page, pageNum);
+	if (rc != RC_OK)
+	{
+		return rc;
+	}
+	attachLRUKFrame(pool->lruk, currentPageInfo);
+	return RC_OK;
+}
+
+/**
+*
+* This function prepares the ARC bookkeeping for a cache of numPages frames. The ghost lists never hold more than
+* numPages entries together, one spare entry covers the moment between a ghost being added and another one dropped.
+*
+*/
+RC initializeARC(ARCState *const arc, const int numPages)
+{
+    memset(arc, 0, sizeof(ARCState));
+    arc->capacity = numPages;
+    arc->ghosts = calloc(numPages + 1, sizeof(GhostEntry));
+    if (!arc->ghosts || initializePageTable(&arc->ghostTable, numPages + 1) != RC_OK) {
+        freeARC(arc);
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+
+    for (int i = 0; i <= numPages; i++) {
+        arc->ghosts[i].next = (i < numPages) ? &arc->ghosts[i + 1] : NULL;
+    }
+    arc->freeGhosts = &arc->ghosts[0];
+    return RC_OK;
+}
+
+void freeARC(ARCState *const arc)
+{
+    free(arc->ghosts);
+    free(arc->ghostTable.slots);
+}
+
+/**
+*
+* These functions move resident frames in and out of T1 and T2.
+*
+*/
+ARCList *arcListOf(ARCState *const arc, PageNode *const pageNode)
+{
+    return (pageNode->arcList == ARC_T1) ? &arc->t1 : &arc->t2;
+}
+
+void arcListRemove(ARCState *const arc, PageNode *const pageNode)
+{
+    ARCList *list = arcListOf(arc, pageNode);
+
+    if (pageNode->policyPrev) {
+        pageNode->policyPrev->policyNext = pageNode->policyNext;
+    } else {
+        list->head = pageNode->policyNext;
+    }
+    if (pageNode->policyNext) {
+        pageNode->policyNext->policyPrev = pageNode->policyPrev;
+    } else {
+        list->tail = pageNode->policyPrev;
+    }
+    pageNode->policyNext = pageNode->policyPrev = NULL;
+    list->size--;
+}
+
+void arcListPush(ARCState *const arc, PageNode *const pageNode, const int listId)
+{
+    pageNode->arcList = listId;
+    ARCList *list = arcListOf(arc, pageNode);
+
+    pageNode->policyNext = NULL;
+    pageNode->policyPrev = list->tail;
+    if (list->tail) {
+        list->tail->policyNext = pageNode;
+    } else {
+        list->head = pageNode;
+    }
+    list->tail = pageNode;
+    list->size++;
+}
+
+/**
+*
+* These functions maintain the ghost lists B1 and B2, which only remember page numbers.
+*
+*/
+void ghostRemove(ARCState *const arc, GhostEntry *const ghost)
+{
+    GhostList *list = (ghost->list == ARC_B1) ? &arc->b1 : &arc->b2;
+
+    if (ghost->prev) {
+        ghost->prev->next = ghost->next;
+    } else {
+        list->head = ghost->next;
+    }
+    if (ghost->next) {
+        ghost->next->prev = ghost->prev;
+    } else {
+        list->tail = ghost->prev;
+    }
+    list->size--;
+
+    removePageTable(&arc->ghostTable, ghost->pageNum);
+    ghost->pageNum = NO_PAGE;
+    ghost->prev = NULL;
+    ghost->next = arc->freeGhosts;
+    arc->freeGhosts = ghost;
+}
+
+void ghostPush(ARCState *const arc, const PageNumber pageNum, const int listId)
+{
+    GhostList *list = (listId == ARC_B1) ? &arc->b1 : &arc->b2;
+    GhostEntry *ghost = arc->freeGhosts;
+
+    arc->freeGhosts = ghost->next;
+    ghost->pageNum = pageNum;
+    ghost->list = listId;
+    ghost->next = NULL;
+    ghost->prev = list->tail;
+    if (list->tail) {
+        list->tail->next = ghost;
+    } else {
+        list->head = ghost;
+    }
+    list->tail = ghost;
+    list->size++;
+    insertPageTable(&arc->ghostTable, pageNum, ghost - arc->ghosts);
+}
+
+/**
+*
+* This function returns the least recently used unpinned frame of a resident list, or NULL if all are pinned.
+*
+*/
+PageNode *arcLeastRecentUnpinned(ARCList *const list)
+{
+    PageNode *pageNode = list->head;
+
+    while (pageNode && pageNode->fixCount) {
+        pageNode = pageNode->policyNext;
+    }
+    return pageNode;
+}
+
+/**
+*
+* This function is the REPLACE step of ARC: it takes the victim from T1 when T1 exceeds its target (or meets it and
+* the requested page is a B2 ghost), otherwise from T2. When the preferred list only has pinned frames the other
+* list is used.
+*
+*/
+PageNode *selectARCVictim(ARCState *const arc, const int target, const bool inB2)
+{
+    bool fromT1 = arc->t1.size >= 1 && (arc->t1.size > target || (inB2 && arc->t1.size == target));
+    PageNode *victim = arcLeastRecentUnpinned(fromT1 ? &arc->t1 : &arc->t2);
+
+    return victim ? victim : arcLeastRecentUnpinned(fromT1 ? &arc->t2 : &arc->t1);
+}
+
+/**
+*
+* This function pins a page in the buffer pool using the ARC (Adaptive Replacement Cache) policy. Hits move the page
+* to the most recently used end of T2. A miss that hits a ghost adapts the target size of T1 before replacing; a
+* complete miss trims the ghost lists so that T1 + B1 and the whole directory stay within their bounds. New pages
+* enter T1, pages coming back from a ghost list enter T2.
+*
+*/
+RC pinPageWithARC(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+	BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+	PageNode *currentPageInfo = findFrame(pool, pageNum);
+
+	if (currentPageInfo)
+	{
+		arcListRemove(pool->arc, currentPageInfo);
+		arcListPush(pool->arc, currentPageInfo, ARC_T2);
+		pinFrame(currentPageInfo);
+		page->data = currentPageInfo->data;
+		page->pageNum = pageNum;
+		return RC_OK;
+	}
+
+	int ghostIndex = lookupPageTable(&pool->arc->ghostTable, pageNum);
+	GhostEntry *ghost = (ghostIndex >= 0) ? &pool->arc->ghosts[ghostIndex] : NULL;
+
+	currentPageInfo = pool->ringVictim ? NULL : getEmptyFrame(&pool->queue);
+	if (currentPageInfo)
+	{
+		if (ghost) {
+			ghostRemove(pool->arc, ghost);
+		}
+	}
+	while (!currentPageInfo)
+	{
+		int capacity = pool->arc->capacity;
+		int t1Size = pool->arc->t1.size;
+		int b1Size = pool->arc->b1.size;
+		int b2Size = pool->arc->b2.size;
+		int target = pool->arc->target;
+		bool discardFromT1 = false;
+
+		if (ghost && ghost->list == ARC_B1) {
+			int delta = (b2Size > b1Size) ? b2Size / b1Size : 1;
+			target = (target + delta < capacity) ? target + delta : capacity;
+		} else if (ghost) {
+			int delta = (b1Size > b2Size) ? b1Size / b2Size : 1;
+			target = (target - delta > 0) ? target - delta : 0;
+		} else if (t1Size + b1Size == capacity && t1Size == capacity) {
+			discardFromT1 = true;
+		}
+
+		if (pool->ringVictim) {
+			// The frame of an access ring is recycled without remembering its page in a ghost list
+			currentPageInfo = pool->ringVictim;
+			discardFromT1 = true;
+		} else if (discardFromT1) {
+			currentPageInfo = arcLeastRecentUnpinned(&pool->arc->t1);
+			if (!currentPageInfo) {
+				currentPageInfo = arcLeastRecentUnpinned(&pool->arc->t2);
+			}
+		} else {
+			currentPageInfo = selectARCVictim(pool->arc, target, ghost && ghost->list == ARC_B2);
+		}
+
+		if (!currentPageInfo)
+		{
+			return RC_FULL_BUFFER;
+		}
+
+		PageNumber victimPageNum = currentPageInfo->pageNum;
+		RC rc = evictFrame(pool, currentPageInfo);
+		if (rc == RC_FRAME_IN_USE)
+		{
+			// A hit pinned the victim meanwhile; once it is applied the lists are looked at again
+			pool->ringVictim = NULL;
+			applyPageAccesses(pool, false);
+			currentPageInfo = NULL;
+			continue;
+		}
+		if (rc != RC_OK)
+		{
+			return rc;
+		}
+
+		pool->arc->target = target;
+		if (!ghost && !discardFromT1) {
+			if (t1Size + b1Size == capacity) {
+				ghostRemove(pool->arc, pool->arc->b1.head);
+			} else if (t1Size + b1Size + pool->arc->t2.size + b2Size == 2 * capacity) {
+				ghostRemove(pool->arc, pool->arc->b2.head);
+			}
+		}
+		if (ghost) {
+			ghostRemove(pool->arc, ghost);
+		}
+
+		int victimList = currentPageInfo->arcList;
+		arcListRemove(pool->arc, currentPageInfo);
+		if (!discardFromT1) {
+			ghostPush(pool->arc, victimPageNum, (victimList == ARC_T1) ? ARC_B1 : ARC_B2);
+		}
+	}
+
+	RC rc = loadPageIntoFrame(pool, currentPageInfo, page, pageNum);
+	if (rc != RC_OK)
+	{
+		return rc;
+	}
+	arcListPush(pool->arc, currentPageInfo, ghost ? ARC_T2 : ARC_T1);
+	return RC_OK;
+}
+
+/**
+*
+* This function applies a recorded hit to the strategy of the pool the way the strategy's pin function treats a hit,
+* except that the pin has already been taken. The caller holds the strategy latch.
+*
+*/
+void applyPageHit(BufferPoolMgmt *const pool, PageNode *const pageNode)
+{
+    if (pool->lfu) {
+        if (pool->lfu->agingInterval && ++pool->lfu->pinsSinceAging >= pool->lfu->agingInterval) {
+            ageLFU(pool->lfu, pool->queue.frames, pool->queue.frameCount);
+        }
+        promoteLFUFrame(pool->lfu, pageNode);
+    } else if (pool->lruk) {
+        pool->lruk->clock++;
+        lrukHeapRemove(pool->lruk, pageNode);
+        referenceLRUKFrame(pool->lruk, pageNode);
+    } else if (pool->arc) {
+        arcListRemove(pool->arc, pageNode);
+        arcListPush(pool->arc, pageNode, ARC_T2);
+    } else if (pageNode != pool->queue.front) {
+        unlinkPageNode(&pool->queue, pageNode);
+        linkAtFront(&pool->queue, pageNode);
+    }
+}
+
+int comparePageAccesses(const void *first, const void *second)
+{
+    unsigned long firstSeq = ((const PageAccess *)first)->seq;
+    unsigned long secondSeq = ((const PageAccess *)second)->seq;
+    return (firstSeq > secondSeq) - (firstSeq < secondSeq);
+}
+
+/**
+*
+* This function empties the access buffers of all stripes and applies the recorded accesses in the order they were
+* recorded; the caller holds the strategy latch, and with stripesLatched every stripe latch as well. An access that
+* was recorded before its frame was given its current page is dropped. Nothing is done if no access was recorded
+* since the last call, so the check is cheap enough for every miss.
+*
+*/
+void applyPageAccesses(BufferPoolMgmt *const pool, const bool stripesLatched)
+{
+    unsigned long clock = atomic_load_explicit(&pool->accessClock, memory_order_relaxed);
+    int numOfAccesses = 0;
+
+    if (clock == pool->appliedClock) {
+        return;
+    }
+    for (int i = 0; i < PAGE_TABLE_STRIPES; i++) {
+        PageTableStripe *stripe = &pool->pageTable[i];
+        if (!stripesLatched) {
+            pthread_mutex_lock(&stripe->latch);
+        }
+        memcpy(&pool->accessBatch[numOfAccesses], stripe->accesses, stripe->numOfAccesses * sizeof(PageAccess));
+        numOfAccesses += stripe->numOfAccesses;
+        stripe->numOfAccesses = 0;
+        if (!stripesLatched) {
+            pthread_mutex_unlock(&stripe->latch);
+        }
+    }
+    pool->appliedClock = clock;
+
+    qsort(pool->accessBatch, numOfAccesses, sizeof(PageAccess), comparePageAccesses);
+    for (int i = 0; i < numOfAccesses; i++) {
+        PageAccess *access = &pool->accessBatch[i];
+        PageNode *pageNode = access->pageNode;
+        if (pageNode->pageNum == NO_PAGE || access->seq < pageNode->loadSeq) {
+            continue;
+        }
+        if (access->release) {
+            releaseStrategyFrame(pool, pageNode);
+        } else {
+            applyPageHit(pool, pageNode);
+        }
+    }
+}
+
+/**
+*
+* This function is used by the background writer to write one frame back. Only an unpinned, dirty frame that is not
+* being read is written; it is marked as being written instead of being pinned, so pins of the page go ahead and an
+* eviction of it waits for the write. Returns true if the page was written.
+*
+*/
+bool cleanFrame(BufferPoolMgmt *const pool, PageNode *const pageNode)
+{
+    pthread_mutex_lock(&pageNode->latch);
+    PageNumber pageNum = pageNode->pageNum;
+    bool writable = pageNum != NO_PAGE && pageNode->fixCount == 0 && pageNode->dirtyFlag && !pageNode->ioInProgress
+                    && !pageNode->writeInProgress;
+    if (writable) {
+        pageNode->dirtyFlag = false;
+        pageNode->writeInProgress = true;
+    }
+    pthread_mutex_unlock(&pageNode->latch);
+
+    if (!writable) {
+        return false;
+    }
+
+    pthread_mutex_lock(&pool->ioLatch);
+    RC rc = writeBlock(pageNum, &pool->fh, pageNode->data);
+    if (rc == RC_OK) {
+        pool->numOfWriteOps++;
+    }
+    pthread_mutex_unlock(&pool->ioLatch);
+
+    pthread_mutex_lock(&pageNode->latch);
+    if (rc != RC_OK) {
+        pageNode->dirtyFlag = true;
+    }
+    pageNode->writeInProgress = false;
+    pthread_cond_broadcast(&pageNode->ioDone);
+    pthread_mutex_unlock(&pageNode->latch);
+    return rc == RC_OK;
+}
+
+/**
+*
+* This function runs one round of the background writer: while more than dirtyRatio percent of the frames are dirty,
+* up to pagesPerRound unpinned dirty frames are written back, continuing from where the previous round stopped.
+*
+*/
+void runBackgroundWriterRound(BufferPoolMgmt *const pool, BackgroundWriter *const writer)
+{
+    BufferQueue *queue = &pool->queue;
+    int numOfDirtyFrames = 0;
+
+    pthread_rwlock_rdlock(&pool->resizeLatch);
+    for (int i = 0; i < queue->frameCount; i++) {
+        pthread_mutex_lock(&queue->frames[i]->latch);
+        numOfDirtyFrames += queue->frames[i]->dirtyFlag;
+        pthread_mutex_unlock(&queue->frames[i]->latch);
+    }
+
+    int toClean = numOfDirtyFrames - queue->frameCount * writer->dirtyRatio / 100;
+    if (toClean > writer->pagesPerRound) {
+        toClean = writer->pagesPerRound;
+    }
+
+    for (int i = 0; i < queue->frameCount && toClean > 0; i++) {
+        if (cleanFrame(pool, queue->frames[writer->cursor])) {
+            toClean--;
+        }
+        writer->cursor = (writer->cursor + 1) % queue->frameCount;
+    }
+    pthread_rwlock_unlock(&pool->resizeLatch);
+}
+
+/**
+*
+* This function is the main loop of the background writer thread. It sleeps for intervalMillis between rounds and
+* returns once stopBackgroundWriter asks it to.
+*
+*/
+void *backgroundWriterMain(void *arg)
+{
+    BackgroundWriter *writer = (BackgroundWriter *)arg;
+    BufferPoolMgmt *pool = writer->pool;
+
+    pthread_mutex_lock(&writer->latch);
+    while (!writer->stop) {
+        pthread_mutex_unlock(&writer->latch);
+        runBackgroundWriterRound(pool, writer);
+        pthread_mutex_lock(&writer->latch);
+
+        struct timespec wakeAt;
+        clock_gettime(CLOCK_REALTIME, &wakeAt);
+        wakeAt.tv_sec += writer->intervalMillis / 1000;
+        wakeAt.tv_nsec += (long)(writer->intervalMillis % 1000) * 1000000L;
+        if (wakeAt.tv_nsec >= 1000000000L) {
+            wakeAt.tv_sec++;
+            wakeAt.tv_nsec -= 1000000000L;
+        }
+        if (!writer->stop) {
+            pthread_cond_timedwait(&writer->wakeup, &writer->latch, &wakeAt);
+        }
+    }
+    pthread_mutex_unlock(&writer->latch);
+    return NULL;
+}
+
+/**
+*
+* This function starts the background writer of a pool. config may be NULL, which keeps at most 10% of the frames
+* dirty by writing up to 16 pages every 10 milliseconds. A pool has at most one writer.
+*
+*/
+RC startBackgroundWriter(BM_BufferPool *const bm, const BM_BackgroundWriterConfig *const config)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    if (pool->writer) {
+        return RC_BACKGROUND_WRITER_ERROR;
+    }
+
+    BackgroundWriter *writer = calloc(1, sizeof(BackgroundWriter));
+    if (!writer) {
+        return RC_BACKGROUND_WRITER_ERROR;
+    }
+    writer->dirtyRatio = (config && config->dirtyRatio >= 0 && config->dirtyRatio <= 100) ? config->dirtyRatio : 10;
+    writer->pagesPerRound = (config && config->pagesPerRound > 0) ? config->pagesPerRound : 16;
+    writer->intervalMillis = (config && config->intervalMillis > 0) ? config->intervalMillis : 10;
+    pthread_mutex_init(&writer->latch, NULL);
+    pthread_cond_init(&writer->wakeup, NULL);
+    writer->pool = pool;
+
+    if (pthread_create(&writer->thread, NULL, backgroundWriterMain, writer) != 0) {
+        pthread_mutex_destroy(&writer->latch);
+        pthread_cond_destroy(&writer->wakeup);
+        free(writer);
+        return RC_BACKGROUND_WRITER_ERROR;
+    }
+
+    pthread_mutex_lock(&pool->strategyLatch);
+    pool->writer = writer;
+    pthread_mutex_unlock(&pool->strategyLatch);
+    return RC_OK;
+}
+
+/**
+*
+* This function stops the background writer of a pool and waits for it to finish its current round. Stopping a pool
+* without a writer does nothing.
+*
+*/
+RC stopBackgroundWriter(BM_BufferPool *const bm)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    BackgroundWriter *writer = pool->writer;
+    if (!writer) {
+        return RC_OK;
+    }
+
+    // Evictions signal the writer under the strategy latch, so after this no other thread can reach it
+    pthread_mutex_lock(&pool->strategyLatch);
+    pool->writer = NULL;
+    pthread_mutex_unlock(&pool->strategyLatch);
+
+    pthread_mutex_lock(&writer->latch);
+    writer->stop = true;
+    pthread_cond_signal(&writer->wakeup);
+    pthread_mutex_unlock(&writer->latch);
+    pthread_join(writer->thread, NULL);
+
+    pthread_mutex_destroy(&writer->latch);
+    pthread_cond_destroy(&writer->wakeup);
+    free(writer);
+    return RC_OK;
+}
+
+/**
+*
+* This function is the main loop of the read-ahead thread. It takes the queued frames in batches, reads the pages of
+* a batch together (readIntoFrames), drops the pins taken for the reads, and drains the queue before it returns once
+* stopReadAhead asks it to.
+*
+*/
+void *readAheadMain(void *arg)
+{
+    ReadAhead *readAhead = (ReadAhead *)arg;
+    BufferPoolMgmt *pool = readAhead->pool;
+
+    pthread_mutex_lock(&readAhead->latch);
+    while (true) {
+        while (!readAhead->stop && readAhead->numOfPending == 0) {
+            pthread_cond_wait(&readAhead->wakeup, &readAhead->latch);
+        }
+        if (readAhead->numOfPending == 0) {
+            break;
+        }
+        PageNode *batch[ASYNC_IO_QUEUE_DEPTH];
+        int numOfFrames = 0;
+        while (readAhead->numOfPending > 0 && numOfFrames < ASYNC_IO_QUEUE_DEPTH) {
+            batch[numOfFrames++] = readAhead->pending[readAhead->head];
+            readAhead->head = (readAhead->head + 1) % readAhead->capacity;
+            readAhead->numOfPending--;
+        }
+        pthread_mutex_unlock(&readAhead->latch);
+
+        readIntoFrames(pool, batch, numOfFrames, true);
+
+        pthread_mutex_lock(&readAhead->latch);
+    }
+    pthread_mutex_unlock(&readAhead->latch);
+    return NULL;
+}
+
+/**
+*
+* This function starts the read-ahead thread of a pool unless it is already running. Only the first caller
+* creates it, later callers find it under the strategy latch.
+*
+*/
+RC startReadAhead(BufferPoolMgmt *const pool)
+{
+    pthread_mutex_lock(&pool->strategyLatch);
+    if (pool->readAhead) {
+        pthread_mutex_unlock(&pool->strategyLatch);
+        return RC_OK;
+    }
+
+    ReadAhead *readAhead = calloc(1, sizeof(ReadAhead));
+    PageNode **pending = malloc(pool->queue.frameCount * sizeof(PageNode *));
+    if (!readAhead || !pending) {
+        pthread_mutex_unlock(&pool->strategyLatch);
+        free(readAhead);
+        free(pending);
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+    readAhead->pool = pool;
+    readAhead->pending = pending;
+    readAhead->capacity = pool->queue.frameCount;
+    readAhead->lastPinned = NO_PAGE;
+    pthread_mutex_init(&readAhead->latch, NULL);
+    pthread_cond_init(&readAhead->wakeup, NULL);
+
+    if (pthread_create(&readAhead->thread, NULL, readAheadMain, readAhead) != 0) {
+        pthread_mutex_unlock(&pool->strategyLatch);
+        pthread_mutex_destroy(&readAhead->latch);
+        pthread_cond_destroy(&readAhead->wakeup);
+        free(pending);
+        free(readAhead);
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+    pool->readAhead = readAhead;
+    pthread_mutex_unlock(&pool->strategyLatch);
+    return RC_OK;
+}
+
+/**
+*
+* This function stops the read-ahead thread of a pool once every queued page has been read. It is called by
+* shutdownBufferPool, when no other thread uses the pool any more.
+*
+*/
+void stopReadAhead(BufferPoolMgmt *const pool)
+{
+    ReadAhead *readAhead = pool->readAhead;
+    if (!readAhead) {
+        return;
+    }
+
+    pthread_mutex_lock(&readAhead->latch);
+    readAhead->stop = true;
+    pthread_cond_signal(&readAhead->wakeup);
+    pthread_mutex_unlock(&readAhead->latch);
+    pthread_join(readAhead->thread, NULL);
+
+    pool->readAhead = NULL;
+    pthread_mutex_destroy(&readAhead->latch);
+    pthread_cond_destroy(&readAhead->wakeup);
+    free(readAhead->pending);
+    free(readAhead);
+}
+
+/**
+*
+* This function assigns frames to the pages startPage .. startPage + count - 1 that are not resident and queues them
+* for the read-ahead thread, without pinning them for the caller. Pages beyond the end of the file are skipped, and
+* read-ahead stops early once every frame is pinned, since it is only a hint.
+*
+*/
+RC readAheadPages(BM_BufferPool *const bm, const PageNumber startPage, const int count)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    ReadAhead *readAhead = pool->readAhead;
+
+    pthread_mutex_lock(&pool->ioLatch);
+    int totalNumPages = pool->fh.totalNumPages;
+    pthread_mutex_unlock(&pool->ioLatch);
+
+    for (PageNumber pageNum = startPage; pageNum < startPage + count && pageNum < totalNumPages; pageNum++) {
+        if (findFrame(pool, pageNum)) {
+            continue;
+        }
+
+        BM_PageHandle page;
+        PageNode *pendingLoad = NULL;
+        RC rc = runReplacementStrategy(bm, &page, pageNum, &pendingLoad);
+        if (rc == RC_FULL_BUFFER) {
+            break;
+        }
+        if (rc != RC_OK) {
+            return rc;
+        }
+        if (!pendingLoad) {
+            // Another thread loaded the page meanwhile, so the pin we got is simply dropped
+            unpinPageNumber(pool, pageNum);
+            continue;
+        }
+
+        pthread_mutex_lock(&readAhead->latch);
+        readAhead->pending[(readAhead->head + readAhead->numOfPending) % readAhead->capacity] = pendingLoad;
+        readAhead->numOfPending++;
+        pthread_cond_signal(&readAhead->wakeup);
+        pthread_mutex_unlock(&readAhead->latch);
+    }
+    return RC_OK;
+}
+
+/**
+*
+* This function hints that the pages startPage .. startPage + count - 1 will be pinned soon. The pages are read in the
+* background; pinning one of them before its read has finished waits for that read only.
+*
+*/
+RC prefetchPages(BM_BufferPool *const bm, const PageNumber startPage, const int count)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    if (startPage < 0 || count < 0) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    RC rc = startReadAhead(pool);
+    if (rc != RC_OK) {
+        return rc;
+    }
+    return readAheadPages(bm, startPage, count);
+}
+
+/**
+*
+* This function enables sequential read-ahead for a pool: once three consecutive pages have been pinned in order,
+* up to window pages following the last pinned page are read ahead, topped up whenever half of them have been
+* consumed. A window of 0 disables it again.
+*
+*/
+RC setReadAheadWindow(BM_BufferPool *const bm, const int window)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    if (window < 0) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    RC rc = startReadAhead(pool);
+    if (rc != RC_OK) {
+        return rc;
+    }
+    pthread_mutex_lock(&pool->readAhead->latch);
+    pool->readAhead->window = (window < pool->queue.frameCount) ? window : pool->queue.frameCount - 1;
+    pool->readAhead->sequentialRun = 0;
+    pthread_mutex_unlock(&pool->readAhead->latch);
+    return RC_OK;
+}
+
+/**
+*
+* This function tracks runs of consecutive pins and reads ahead when a sequential scan is detected. A scan through
+* zero-copy pins does not use frames, so for it the kernel is only asked to prefetch the pages (prefetchBlocks).
+*
+*/
+void readAheadAfterPin(BM_BufferPool *const bm, const PageNumber pageNum, const bool zeroCopy)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    ReadAhead *readAhead = pool->readAhead;
+    PageNumber from = 0;
+    int count = 0;
+
+    pthread_mutex_lock(&readAhead->latch);
+    if (pageNum == readAhead->lastPinned + 1) {
+        readAhead->sequentialRun++;
+    } else if (pageNum != readAhead->lastPinned) {
+        readAhead->sequentialRun = 0;
+        readAhead->nextPage = 0;
+    }
+    readAhead->lastPinned = pageNum;
+
+    if (readAhead->window > 0 && readAhead->sequentialRun >= 2
+        && readAhead->nextPage - pageNum - 1 <= readAhead->window / 2) {
+        from = (readAhead->nextPage > pageNum) ? readAhead->nextPage : pageNum + 1;
+        count = pageNum + readAhead->window + 1 - from;
+        readAhead->nextPage = pageNum + readAhead->window + 1;
+    }
+    pthread_mutex_unlock(&readAhead->latch);
+
+    if (count > 0 && zeroCopy) {
+        prefetchBlocks(from, count, &pool->fh);
+    } else if (count > 0) {
+        readAheadPages(bm, from, count);
+    }
+}
+
+/**
+*
+* This function prepares an access ring of size frames for a bulk scan or load on the pool. Pages pinned through the
+* ring with pinPageInRing recycle the ring's own frames once it is full, so a large scan replaces at most size pages
+* of the rest of the pool. The ring itself is not shared, every scanning caller uses its own.
+*
+*/
+RC initAccessRing(BM_BufferPool *const bm, BM_AccessRing *const ring, const int size)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    if (size <= 0) {
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+
+    AccessRing *state = malloc(sizeof(AccessRing));
+    int ringSize = (size < pool->queue.frameCount) ? size : pool->queue.frameCount;
+    if (!state || !(state->slots = malloc(ringSize * sizeof(AccessRingSlot)))) {
+        free(state);
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+    for (int i = 0; i < ringSize; i++) {
+        state->slots[i].frameNumber = -1;
+        state->slots[i].pageNum = NO_PAGE;
+    }
+    state->next = 0;
+
+    ring->size = ringSize;
+    ring->mgmtData = state;
+    return RC_OK;
+}
+
+/**
+*
+* This function releases an access ring. Pages pinned through it stay in the pool.
+*
+*/
+RC freeAccessRing(BM_AccessRing *const ring)
+{
+    AccessRing *state = (AccessRing *)ring->mgmtData;
+    if (!state) {
+        return RC_OK;
+    }
+    free(state->slots);
+    free(state);
+    ring->mgmtData = NULL;
+    return RC_OK;
+}
+
+/**
+*
+* This function pins a page through an access ring. A resident page is pinned as usual. On a miss the frame in the
+* next slot of the ring is reused if it still holds the page the ring put there and nobody has it pinned; otherwise
+* the pool's strategy finds a frame, which then joins the ring. Pages loaded this way are not promoted by LRU and
+* CLOCK, and ARC does not remember them when their frame is recycled.
+*
+*/
+RC pinPageInRing(BM_BufferPool *const bm, BM_AccessRing *const ring, BM_PageHandle *const page, const PageNumber pageNum)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    AccessRing *state = (AccessRing *)ring->mgmtData;
+    if (!pool || !state) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    if (pageNum < 0) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    AccessRingSlot *slot = &state->slots[state->next];
+    PageNode *pendingLoad = NULL;
+
+    pthread_mutex_lock(&pool->strategyLatch);
+    // A resize may have dropped or renumbered the frame, the page check below tells
+    if (slot->frameNumber >= 0 && slot->frameNumber < pool->queue.frameCount) {
+        PageNode *pageNode = pool->queue.frames[slot->frameNumber];
+        pthread_mutex_lock(&pageNode->latch);
+        if (pageNode->pageNum == slot->pageNum && pageNode->pageNum != pageNum && pageNode->fixCount == 0
+            && !pageNode->ioInProgress && !pageNode->writeInProgress) {
+            pool->ringVictim = pageNode;
+        }
+        pthread_mutex_unlock(&pageNode->latch);
+    }
+    pool->ringMode = true;
+    RC res = pinWithStrategy(bm, page, pageNum, &pendingLoad);
+    pool->ringMode = false;
+    pool->ringVictim = NULL;
+    pthread_mutex_unlock(&pool->strategyLatch);
+
+    if (res != RC_OK) {
+        return res;
+    }
+    countPin(pool, pendingLoad != NULL);
+    if (pendingLoad) {
+        slot->frameNumber = pendingLoad->frameNumber;
+        slot->pageNum = pageNum;
+        state->next = (state->next + 1) % ring->size;
+        readIntoFrame(pool, pendingLoad, false);
+    }
+    return finishPin(pool, page);
+}
+
+/**
+*
+* This function orders the frames of an LRU-K pool by their K-th most recent reference and then by their most recent
+* one, oldest first, like selectLRUKVictim does.
+*
+*/
+int compareLRUKRanks(const void *first, const void *second)
+{
+    const LRUKRank *a = (const LRUKRank *)first;
+    const LRUKRank *b = (const LRUKRank *)second;
+
+    if (a->kth != b->kth) {
+        return (a->kth > b->kth) - (a->kth < b->kth);
+    }
+    return (a->first > b->first) - (a->first < b->first);
+}
+
+/**
+*
+* This function lists the unpinned frames that hold a page in the order in which the pool's replacement strategy
+* would evict them, the first victim first, and returns their number. order must have room for every frame. ARC
+* takes its victims the way REPLACE does for a complete miss.
+*
+*/
+int orderFramesForEviction(BM_BufferPool *const bm, PageNode **const order)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    BufferQueue *queue = &pool->queue;
+    int numOfFrames = 0;
+
+    switch (bm->strategy)
+    {
+        case RS_FIFO:
+            for (PageNode *pageNode = queue->front; pageNode; pageNode = pageNode->next) {
+                if (pageNode->pageNum != NO_PAGE) {
+                    order[numOfFrames++] = pageNode;
+                }
+            }
+            break;
+        case RS_LRU:
+            for (PageNode *pageNode = queue->rear; pageNode; pageNode = pageNode->prev) {
+                if (pageNode->pageNum != NO_PAGE) {
+                    order[numOfFrames++] = pageNode;
+                }
+            }
+            break;
+        case RS_CLOCK:
+            // The hand passes the frames without a reference bit first, the others only after their second chance
+            for (int pass = 0; pass < 2; pass++) {
+                for (int i = 0; i < queue->frameCount; i++) {
+                    PageNode *pageNode = queue->frames[(queue->clockHand + i) % queue->frameCount];
+                    if (pageNode->pageNum != NO_PAGE && pageNode->refBit == (pass == 1)) {
+                        order[numOfFrames++] = pageNode;
+                    }
+                }
+            }
+            break;
+        case RS_LFU:
+            for (FrequencyBucket *bucket = pool->lfu->lowest; bucket; bucket = bucket->next) {
+                for (PageNode *pageNode = bucket->head; pageNode; pageNode = pageNode->policyNext) {
+                    order[numOfFrames++] = pageNode;
+                }
+            }
+            break;
+        case RS_LRU_K: {
+            LRUKRank *ranks = malloc(queue->frameCount * sizeof(LRUKRank));
+            if (!ranks) {
+                return -1;
+            }
+            for (int i = 0; i < queue->frameCount; i++) {
+                PageNode *pageNode = queue->frames[i];
+                if (pageNode->pageNum != NO_PAGE) {
+                    ranks[numOfFrames].kth = pageNode->history[pool->lruk->k - 1];
+                    ranks[numOfFrames].first = pageNode->history[0];
+                    ranks[numOfFrames].pageNode = pageNode;
+                    numOfFrames++;
+                }
+            }
+            qsort(ranks, numOfFrames, sizeof(LRUKRank), compareLRUKRanks);
+            for (int i = 0; i < numOfFrames; i++) {
+                order[i] = ranks[i].pageNode;
+            }
+            free(ranks);
+            break;
+        }
+        case RS_ARC: {
+            PageNode *t1 = pool->arc->t1.head;
+            PageNode *t2 = pool->arc->t2.head;
+            int t1Size = pool->arc->t1.size;
+            while (t1 || t2) {
+                if (t1 && (t1Size > pool->arc->target || !t2)) {
+                    order[numOfFrames++] = t1;
+                    t1 = t1->policyNext;
+                    t1Size--;
+                } else {
+                    order[numOfFrames++] = t2;
+                    t2 = t2->policyNext;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    // Only LFU leaves the pinned frames out by itself
+    int numOfUnpinned = 0;
+    for (int i = 0; i < numOfFrames; i++) {
+        if (order[i]->fixCount == 0) {
+            order[numOfUnpinned++] = order[i];
+        }
+    }
+    return numOfUnpinned;
+}
+
+/**
+*
+* This function carries the ARC lists over to the state allocated for the new size of a pool. Resident pages keep
+* their list and position; the most recent ghosts are kept as far as the new capacity allows.
+*
+*/
+void rebuildARC(ARCState *const arc, ARCState *const resized)
+{
+    resized->t1 = arc->t1;
+    resized->t2 = arc->t2;
+
+    int b1Room = resized->capacity - resized->t1.size;
+    int b1Kept = (arc->b1.size < b1Room) ? arc->b1.size : b1Room;
+    int b2Room = resized->capacity - b1Kept;
+    int b2Kept = (arc->b2.size < b2Room) ? arc->b2.size : b2Room;
+    for (int listId = ARC_B1; listId <= ARC_B2; listId++) {
+        GhostList *list = (listId == ARC_B1) ? &arc->b1 : &arc->b2;
+        int skip = list->size - ((listId == ARC_B1) ? b1Kept : b2Kept);
+        for (GhostEntry *ghost = list->head; ghost; ghost = ghost->next) {
+            if (skip-- <= 0) {
+                ghostPush(resized, ghost->pageNum, listId);
+            }
+        }
+    }
+    resized->target = (arc->target < resized->capacity) ? arc->target : resized->capacity;
+}
+
+/**
+*
+* This function moves the LFU buckets in use into the bucket array allocated for the new size of a pool, in
+* frequency order, and points the frames of the frame table at their new bucket. Each old bucket remembers its
+* copy in prev until the frames have followed.
+*
+*/
+void rebuildLFU(LFUState *const lfu, FrequencyBucket *const buckets, const int numOfBuckets, PageNode **const frames, const int frameCount)
+{
+    FrequencyBucket *last = NULL;
+    int numOfUsed = 0;
+
+    for (FrequencyBucket *bucket = lfu->lowest; bucket; bucket = bucket->next) {
+        buckets[numOfUsed] = *bucket;
+        buckets[numOfUsed].prev = last;
+        if (last) {
+            last->next = &buckets[numOfUsed];
+        }
+        last = &buckets[numOfUsed++];
+        bucket->prev = last;
+    }
+    if (last) {
+        last->next = NULL;
+    }
+    for (int i = 0; i < frameCount; i++) {
+        if (frames[i]->bucket) {
+            frames[i]->bucket = frames[i]->bucket->prev;
+        }
+    }
+
+    for (int i = numOfUsed; i < numOfBuckets; i++) {
+        buckets[i].next = (i + 1 < numOfBuckets) ? &buckets[i + 1] : NULL;
+    }
+    free(lfu->buckets);
+    lfu->buckets = buckets;
+    lfu->lowest = (numOfUsed > 0) ? &buckets[0] : NULL;
+    lfu->freeBuckets = (numOfUsed < numOfBuckets) ? &buckets[numOfUsed] : NULL;
+}
+
+/**
+*
+* This function takes a surplus page out of a pool that is being shrunk, after its data has been written back. The
+* page leaves the page table and the strategy state the way an eviction does, except that ARC does not remember it
+* in a ghost list, and its frame holds no page afterwards.
+*
+*/
+void dropSurplusPage(BufferPoolMgmt *const pool, PageNode *const pageNode)
+{
+    removePageTable(&stripeOf(pool, pageNode->pageNum)->table, pageNode->pageNum);
+    if (pool->lfu) {
+        detachLFUFrame(pool->lfu, pageNode);
+    } else if (pool->lruk) {
+        lrukHeapRemove(pool->lruk, pageNode);
+        retainLRUKHistory(pool->lruk, pageNode->pageNum, pageNode);
+    } else if (pool->arc) {
+        arcListRemove(pool->arc, pageNode);
+    }
+    pageNode->pageNum = NO_PAGE;
+}
+
+/**
+*
+* This function moves the unpinned page of frame from into the empty frame to of a pool that is being shrunk. The
+* two descriptors trade their place in the frame table and their page memory, so the page keeps its descriptor, and
+* with it its place in the queue and the strategy state, while its data is copied into the memory of its new frame.
+*
+*/
+void moveFrame(BufferPoolMgmt *const pool, const int from, const int to)
+{
+    PageNode **frames = pool->queue.frames;
+    PageNode *pageNode = frames[from];
+    PageNode *emptyFrame = frames[to];
+    PageTable *table = &stripeOf(pool, pageNode->pageNum)->table;
+    char *data = emptyFrame->data;
+
+    memcpy(data, pageNode->data, PAGE_SIZE);
+    emptyFrame->data = pageNode->data;
+    pageNode->data = data;
+    frames[to] = pageNode;
+    frames[from] = emptyFrame;
+    pageNode->frameNumber = to;
+    emptyFrame->frameNumber = from;
+    removePageTable(table, pageNode->pageNum);
+    insertPageTable(table, pageNode->pageNum, to);
+}
+
+/**
+*
+* This function releases what allocateResizeState allocated when the resize cannot go ahead.
+*
+*/
+void freeResizeState(BufferPoolMgmt *const pool, ResizeState *const resized, const int newNumPages)
+{
+    for (int i = pool->queue.frameCount; resized->frames && i < newNumPages; i++) {
+        if (resized->frames[i]) {
+            freeFrame(resized->frames[i]);
+        }
+    }
+    if (resized->newSegment) {
+        freeSegment(&resized->segments[resized->numOfSegments - 1]);
+    }
+    if (resized->arcReady) {
+        freeARC(&resized->arc);
+    }
+    free(resized->frames);
+    free(resized->freeFrames);
+    free(resized->segments);
+    free(resized->order);
+    free(resized->buckets);
+    free(resized->frameHistory);
+    free(resized->candidates);
+    free(resized->correlated);
+    free(resized->pending);
+}
+
+/**
+*
+* This function allocates everything a resize of a pool to newNumPages frames needs: the new frame table with the
+* frames the pool gains, memory for them if the last segment has no room left, and the strategy and read-ahead
+* arrays for the new size. Segments that lie entirely beyond the new size are left out of the new segment list.
+*
+*/
+RC allocateResizeState(BufferPoolMgmt *const pool, ResizeState *const resized, const int newNumPages)
+{
+    BufferQueue *queue = &pool->queue;
+    FrameSegment *last = &queue->segments[queue->numOfSegments - 1];
+    int room = last->firstFrame + last->numOfFrames;
+    int numOfSegments = 0;
+
+    while (numOfSegments < queue->numOfSegments && queue->segments[numOfSegments].firstFrame < newNumPages) {
+        numOfSegments++;
+    }
+
+    memset(resized, 0, sizeof(ResizeState));
+    resized->frames = calloc(newNumPages, sizeof(PageNode *));
+    resized->freeFrames = malloc(newNumPages * sizeof(int));
+    resized->segments = malloc((numOfSegments + 1) * sizeof(FrameSegment));
+    resized->order = malloc(queue->frameCount * sizeof(PageNode *));
+    bool allocated = resized->frames && resized->freeFrames && resized->segments && resized->order;
+
+    if (allocated) {
+        memcpy(resized->segments, queue->segments, numOfSegments * sizeof(FrameSegment));
+        resized->numOfSegments = numOfSegments;
+        if (newNumPages > room) {
+            allocated = allocateSegment(&resized->segments[numOfSegments], room, newNumPages - room, &pool->memory) == RC_OK;
+            resized->numOfSegments += allocated;
+            resized->newSegment = allocated;
+        }
+    }
+    for (int i = queue->frameCount; allocated && i < newNumPages; i++) {
+        resized->frames[i] = newFrame(frameData(resized->segments, resized->numOfSegments, i), i);
+        allocated = resized->frames[i] != NULL;
+    }
+
+    if (allocated && pool->lfu) {
+        allocated = (resized->buckets = calloc(newNumPages, sizeof(FrequencyBucket))) != NULL;
+    }
+    if (allocated && pool->lruk) {
+        resized->frameHistory = calloc((size_t)newNumPages * pool->lruk->k, sizeof(unsigned long));
+        resized->candidates = malloc(newNumPages * sizeof(PageNode *));
+        resized->correlated = malloc(newNumPages * sizeof(PageNode *));
+        allocated = resized->frameHistory && resized->candidates && resized->correlated;
+    }
+    if (allocated && pool->arc) {
+        // initializeARC releases what it allocated itself
+        allocated = resized->arcReady = initializeARC(&resized->arc, newNumPages) == RC_OK;
+    }
+    if (allocated && pool->readAhead) {
+        allocated = (resized->pending = malloc(newNumPages * sizeof(PageNode *))) != NULL;
+    }
+
+    if (!allocated) {
+        freeResizeState(pool, resized, newNumPages);
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+    return RC_OK;
+}
+
+/**
+*
+* This function resizes the frames of a pool in place; the caller holds the resize latch exclusively, the strategy
+* latch and every stripe latch. Growing adds frames behind the existing ones, in the room left in the last segment
+* or in a new one. Shrinking removes the frames from newNumPages on: the surplus pages, the ones the strategy would
+* evict first, are written back and dropped, and the unpinned pages left in the removed frames move into the frames
+* that became empty. Only the removed frames must not be pinned. Everything that can fail is allocated, and every
+* surplus dirty page written, before the pool is changed, so on failure the pool keeps its size and pages.
+*
+*/
+RC resizeFrames(BM_BufferPool *const bm, const int newNumPages)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    BufferQueue *queue = &pool->queue;
+    int frameCount = queue->frameCount;
+
+    // Page handles point into the frames that stay, so only the frames that are removed have to be unpinned
+    for (int i = newNumPages; i < frameCount; i++) {
+        pthread_mutex_lock(&queue->frames[i]->latch);
+        bool pinned = queue->frames[i]->fixCount > 0;
+        pthread_mutex_unlock(&queue->frames[i]->latch);
+        if (pinned) {
+            return RC_FRAME_IN_USE;
+        }
+    }
+
+    ResizeState resized;
+    if (allocateResizeState(pool, &resized, newNumPages) != RC_OK) {
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+
+    int numOfResident = 0;
+    for (int i = 0; i < frameCount; i++) {
+        numOfResident += queue->frames[i]->pageNum != NO_PAGE;
+    }
+    PageNode **order = resized.order;
+    int numOfUnpinned = orderFramesForEviction(bm, order);
+    int numOfEvicted = (numOfResident > newNumPages) ? numOfResident - newNumPages : 0;
+    RC rc = (numOfUnpinned < 0) ? RC_BUFFER_POOL_INITIALIZE_ERROR : (numOfUnpinned < numOfEvicted) ? RC_FRAME_IN_USE : RC_OK;
+
+    // The surplus pages, the first victims of the strategy, are written back in page order
+    int numOfDirtyEvictions = 0;
+    PageNode **kept = order + numOfEvicted;
+    int numOfKept = numOfUnpinned - numOfEvicted;
+    if (rc == RC_OK) {
+        qsort(order, numOfEvicted, sizeof(PageNode *), comparePageNodes);
+    }
+    for (int i = 0; i < numOfEvicted && rc == RC_OK; i++) {
+        bool written;
+        rc = writeBackFrame(pool, order[i], &written);
+        numOfDirtyEvictions += written;
+    }
+
+    if (rc != RC_OK) {
+        freeResizeState(pool, &resized, newNumPages);
+        return rc;
+    }
+
+    // From here on nothing can fail. The surplus pages leave the pool and the pages of the removed frames move into
+    // the lowest empty frames, in eviction order.
+    for (int i = 0; i < numOfEvicted; i++) {
+        dropSurplusPage(pool, order[i]);
+    }
+    int emptyFrame = 0;
+    for (int i = 0; i < numOfKept; i++) {
+        if (kept[i]->frameNumber >= newNumPages) {
+            while (queue->frames[emptyFrame]->pageNum != NO_PAGE) {
+                emptyFrame++;
+            }
+            moveFrame(pool, kept[i]->frameNumber, emptyFrame);
+        }
+    }
+    for (int i = newNumPages; i < frameCount; i++) {
+        unlinkPageNode(queue, queue->frames[i]);
+        freeFrame(queue->frames[i]);
+    }
+
+    memcpy(resized.frames, queue->frames, ((frameCount < newNumPages) ? frameCount : newNumPages) * sizeof(PageNode *));
+    for (int i = frameCount; i < newNumPages; i++) {
+        linkAtRear(queue, resized.frames[i]);
+    }
+    free(queue->frames);
+    queue->frames = resized.frames;
+    queue->numOfFreeFrames = 0;
+    for (int i = newNumPages - 1; i >= 0; i--) {
+        if (queue->frames[i]->pageNum == NO_PAGE) {
+            resized.freeFrames[queue->numOfFreeFrames++] = i;
+        }
+    }
+    free(queue->freeFrames);
+    queue->freeFrames = resized.freeFrames;
+    for (int i = resized.numOfSegments - resized.newSegment; i < queue->numOfSegments; i++) {
+        freeSegment(&queue->segments[i]);
+    }
+    free(queue->segments);
+    queue->segments = resized.segments;
+    queue->numOfSegments = resized.numOfSegments;
+    queue->frameCount = newNumPages;
+    if (queue->clockHand >= newNumPages) {
+        queue->clockHand = 0;
+    }
+
+    // The strategy state follows the frame table
+    if (pool->lfu) {
+        rebuildLFU(pool->lfu, resized.buckets, newNumPages, queue->frames, newNumPages);
+    }
+    if (pool->lruk) {
+        LRUKState *lruk = pool->lruk;
+        int k = lruk->k;
+        for (int i = 0; i < newNumPages; i++) {
+            if (i < frameCount) {
+                memcpy(&resized.frameHistory[(size_t)i * k], queue->frames[i]->history, k * sizeof(unsigned long));
+            }
+            queue->frames[i]->history = &resized.frameHistory[(size_t)i * k];
+        }
+        free(lruk->frameHistory);
+        lruk->frameHistory = resized.frameHistory;
+
+        memcpy(resized.candidates, lruk->candidates.frames, lruk->candidates.size * sizeof(PageNode *));
+        memcpy(resized.correlated, lruk->correlated.frames, lruk->correlated.size * sizeof(PageNode *));
+        free(lruk->candidates.frames);
+        free(lruk->correlated.frames);
+        lruk->candidates.frames = resized.candidates;
+        lruk->correlated.frames = resized.correlated;
+    }
+    if (pool->arc) {
+        rebuildARC(pool->arc, &resized.arc);
+        freeARC(pool->arc);
+        *pool->arc = resized.arc;
+    }
+
+    // Frames queued for read-ahead are pinned, so they are among the frames that stay
+    if (pool->readAhead) {
+        ReadAhead *readAhead = pool->readAhead;
+        pthread_mutex_lock(&readAhead->latch);
+        for (int i = 0; i < readAhead->numOfPending; i++) {
+            resized.pending[i] = readAhead->pending[(readAhead->head + i) % readAhead->capacity];
+        }
+        free(readAhead->pending);
+        readAhead->pending = resized.pending;
+        readAhead->capacity = newNumPages;
+        readAhead->head = 0;
+        if (readAhead->window >= newNumPages) {
+            readAhead->window = newNumPages - 1;
+        }
+        pthread_mutex_unlock(&readAhead->latch);
+    }
+    if (pool->writer && pool->writer->cursor >= newNumPages) {
+        pool->writer->cursor = 0;
+    }
+
+    bm->numPages = newNumPages;
+    atomic_fetch_add_explicit(&pool->numOfEvictions, numOfEvicted, memory_order_relaxed);
+    atomic_fetch_add_explicit(&pool->numOfDirtyEvictions, numOfDirtyEvictions, memory_order_relaxed);
+
+    free(order);
+    return RC_OK;
+}
+
+/**
+*
+* This function grows or shrinks a buffer pool to newNumPages frames while keeping its pages. When the pool shrinks,
+* the pages its strategy would evict first are evicted, and written back if they are dirty; every other page keeps
+* its contents, dirty flag and replacement history. Pages may stay pinned: growing adds frames without touching the
+* existing ones, and shrinking removes the frames from newNumPages on, which must not be pinned, otherwise
+* RC_FRAME_IN_USE is returned and nothing changes. Unpinned pages in the removed frames move to the frames that stay.
+* Other threads may keep using the pool, their calls wait until the resize has finished; arrays for getPoolSnapshot
+* have to be sized for the new numPages.
+*
+*/
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages)
+{
+    BufferPoolMgmt *pool = (BufferPoolMgmt *)bm->mgmtData;
+    if (!pool) {
+        return RC_BUFFER_POOL_NOT_INIT;
+    }
+    if (newNumPages <= 0) {
+        return RC_BUFFER_POOL_INITIALIZE_ERROR;
+    }
+
+    pthread_rwlock_wrlock(&pool->resizeLatch);
+    pthread_mutex_lock(&pool->strategyLatch);
+    for (int i = 0; i < PAGE_TABLE_STRIPES; i++) {
+        pthread_mutex_lock(&pool->pageTable[i].latch);
+    }
+
+    // The order of the frames has to be current before surplus pages are picked
+    applyPageAccesses(pool, true);
+    RC rc = (newNumPages == pool->queue.frameCount) ? RC_OK : resizeFrames(bm, newNumPages);
+
+    for (int i = PAGE_TABLE_STRIPES - 1; i >= 0; i--) {
+        pthread_mutex_unlock(&pool->pageTable[i].latch);
+    }
+    pthread_mutex_unlock(&pool->strategyLatch);
+    pthread_rwlock_unlock(&pool->resizeLatch);
+    return rc;
+}
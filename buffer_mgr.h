@@ -13,7 +13,8 @@ typedef enum ReplacementStrategy {
 	RS_LRU = 1,
 	RS_CLOCK = 2,
 	RS_LFU = 3,
-	RS_LRU_K = 4
+	RS_LRU_K = 4,
+	RS_ARC = 5
 } ReplacementStrategy;
 
 // Data Types and Structures
@@ -28,6 +29,91 @@ typedef struct BM_BufferPool {
 	// manager needs for a buffer pool
 } BM_BufferPool;
 
+// Optional stratData for RS_LFU: page frequencies are halved every agingInterval
+// pins so that formerly hot pages can leave the pool (0 disables aging)
+typedef struct BM_LFU_StratData {
+	int agingInterval;
+} BM_LFU_StratData;
+
+// Optional stratData for RS_LRU_K (NULL selects LRU-2). Time is counted in pins:
+// a pin within correlatedRefPeriod pins of the previous pin of the same page is
+// treated as part of the same reference. historySize bounds the number of evicted
+// pages whose reference history is remembered (0 selects the pool size).
+typedef struct BM_LRU_K_StratData {
+	int k;
+	int correlatedRefPeriod;
+	int historySize;
+} BM_LRU_K_StratData;
+
+// Settings of the optional background writer of a pool (NULL selects the defaults).
+// Every intervalMillis milliseconds the writer cleans up to pagesPerRound unpinned
+// dirty frames, as long as more than dirtyRatio percent of the frames are dirty.
+typedef struct BM_BackgroundWriterConfig {
+	int dirtyRatio;
+	int pagesPerRound;
+	int intervalMillis;
+} BM_BackgroundWriterConfig;
+
+// Backing of the frame memory of a pool. Explicit huge pages come from the
+// hugetlb pool, transparent ones are requested with madvise; a pool falls back
+// to the next weaker kind, down to ordinary pages, if a kind is unavailable.
+// lockMemory additionally locks the frames into RAM with mlock (best effort).
+typedef enum BM_HugePages {
+	BM_HUGE_PAGES_NONE = 0,
+	BM_HUGE_PAGES_TRANSPARENT = 1,
+	BM_HUGE_PAGES_EXPLICIT = 2
+} BM_HugePages;
+
+typedef struct BM_PoolMemoryConfig {
+	BM_HugePages hugePages;
+	bool lockMemory;
+} BM_PoolMemoryConfig;
+
+// Storage mode of a pool's page file. In BM_STORAGE_MAPPED mode the file is also
+// mapped into memory: misses copy pages from the mapping, and pinPageReadOnly
+// hands out pointers into it for pages that are not resident. The access pattern
+// is passed on to the kernel (madvise, posix_fadvise) to steer its read-ahead.
+typedef enum BM_StorageMode {
+	BM_STORAGE_POSITIONAL = 0,
+	BM_STORAGE_MAPPED = 1
+} BM_StorageMode;
+
+typedef enum BM_AccessPattern {
+	BM_ACCESS_NORMAL = 0,
+	BM_ACCESS_SEQUENTIAL = 1,
+	BM_ACCESS_RANDOM = 2
+} BM_AccessPattern;
+
+// Page checksums of a pool. With BM_CHECKSUM_WRITE every page the pool writes
+// carries a CRC32C in its last 4 bytes (PAGE_CHECKSUM_SIZE), which are then not
+// available for data; BM_CHECKSUM_VERIFY also checks every page the pool reads,
+// and a pin of a page that fails the check returns RC_CHECKSUM_MISMATCH.
+typedef enum BM_ChecksumMode {
+	BM_CHECKSUM_NONE = 0,
+	BM_CHECKSUM_WRITE = 1,
+	BM_CHECKSUM_VERIFY = 2
+} BM_ChecksumMode;
+
+// An access ring lets a bulk scan or load recycle a small private set of
+// frames instead of replacing the pages other callers are using
+typedef struct BM_AccessRing {
+	int size;
+	void *mgmtData;
+} BM_AccessRing;
+
+// Counters of a pool since it was initialized. A hit is a demand pin of a
+// resident page and a miss one that had to read the page; pinWaits counts the
+// pins that waited for another thread's read. Prefetches count as neither.
+typedef struct BM_PoolStatistics {
+	long hits;
+	long misses;
+	long evictions;
+	long dirtyEvictions;
+	long pinWaits;
+	int readIO;
+	int writeIO;
+} BM_PoolStatistics;
+
 typedef struct BM_PageHandle {
 	PageNumber pageNum;
 	char *data;
@@ -44,8 +130,19 @@ typedef struct BM_PageHandle {
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
 		const int numPages, ReplacementStrategy strategy,
 		void *stratData);
+RC initBufferPoolWithMemory(BM_BufferPool *const bm, const char *const pageFileName,
+		const int numPages, ReplacementStrategy strategy,
+		void *stratData, const BM_PoolMemoryConfig *const memory);
+RC getPoolMemory(BM_BufferPool *const bm, BM_PoolMemoryConfig *const memory);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages);
+RC startBackgroundWriter(BM_BufferPool *const bm, const BM_BackgroundWriterConfig *const config);
+RC stopBackgroundWriter(BM_BufferPool *const bm);
+RC setReadAheadWindow(BM_BufferPool *const bm, const int window);
+RC setPoolStorageMode(BM_BufferPool *const bm, const BM_StorageMode mode,
+		const BM_AccessPattern pattern);
+RC setPoolChecksumMode(BM_BufferPool *const bm, const BM_ChecksumMode mode);
 
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
@@ -53,6 +150,21 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
+RC pinPageReadOnly (BM_BufferPool *const bm, BM_PageHandle *const page,
+		const PageNumber pageNum);
+RC prefetchPages (BM_BufferPool *const bm, const PageNumber startPage,
+		const int count);
+RC pinPages (BM_BufferPool *const bm, const PageNumber *const pageNums,
+		BM_PageHandle *const pages, const int n);
+RC unpinPages (BM_BufferPool *const bm, BM_PageHandle *const pages,
+		const int n);
+
+// Buffer Manager Interface Access Rings
+RC initAccessRing (BM_BufferPool *const bm, BM_AccessRing *const ring,
+		const int size);
+RC freeAccessRing (BM_AccessRing *const ring);
+RC pinPageInRing (BM_BufferPool *const bm, BM_AccessRing *const ring,
+		BM_PageHandle *const page, const PageNumber pageNum);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -60,5 +172,7 @@ bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+RC getPoolSnapshot (BM_BufferPool *const bm, PageNumber *const frameContents,
+		bool *const dirtyFlags, int *const fixCounts, BM_PoolStatistics *const stats);
 
 #endif
@@ -1,11 +1,18 @@
 #include "buffer_mgr_stat.h"
 #include "buffer_mgr.h"
+#include "latency_stat.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// a histogram line without its operation name, with all six counters at their full 20 digits
+#define LATENCY_LINE_FORMAT "%s count=%lu meanNs=%lu p50Ns=%lu p99Ns=%lu p999Ns=%lu maxNs=%lu\n"
+#define LATENCY_LINE_LENGTH (sizeof(" count= meanNs= p50Ns= p99Ns= p999Ns= maxNs=\n") + 6 * 20)
 
 // local functions
 static void printStrat (BM_BufferPool *const bm);
+static int sprintLatencyHistogram (char *message, size_t size, LatencyOp op);
 
 // external functions
 void 
@@ -78,6 +85,64 @@ sprintPageContent (BM_PageHandle *const page)
 	return message;
 }
 
+void
+printLatencyHistograms (void)
+{
+	char *message = sprintLatencyHistograms();
+
+	if (message)
+		printf("%s", message);
+	free(message);
+}
+
+// returns NULL if there is not enough memory
+char *
+sprintLatencyHistograms (void)
+{
+	char *message;
+	size_t size = 1;
+	size_t pos = 0;
+	int op;
+
+	for (op = 0; op < LATENCY_NUM_OPS; op++)
+		size += strlen(latencyOpName(op)) + LATENCY_LINE_LENGTH;
+	message = (char *) malloc(size);
+	if (!message)
+		return NULL;
+
+	message[0] = '\0';
+	for (op = 0; op < LATENCY_NUM_OPS; op++)
+	{
+		int len = sprintLatencyHistogram(message + pos, size - pos, op);
+		if (len < 0)
+		{
+			free(message);
+			return NULL;
+		}
+		pos += ((size_t)len < size - pos) ? (size_t)len : size - pos - 1;
+	}
+
+	return message;
+}
+
+// writes at most size bytes, like snprintf, and returns the length of the line or -1
+int
+sprintLatencyHistogram (char *message, size_t size, LatencyOp op)
+{
+	LatencyHistogram *hist = malloc(sizeof(LatencyHistogram));
+	int len;
+
+	if (!hist)
+		return -1;
+	getLatencyHistogram(op, hist);
+	len = snprintf(message, size, LATENCY_LINE_FORMAT,
+		latencyOpName(op), hist->count, hist->count ? hist->sumNanos / hist->count : 0,
+		latencyPercentile(hist, 50), latencyPercentile(hist, 99), latencyPercentile(hist, 99.9), hist->maxNanos);
+	free(hist);
+
+	return len;
+}
+
 void
 printStrat (BM_BufferPool *const bm)
 {
@@ -98,6 +163,9 @@ printStrat (BM_BufferPool *const bm)
 	case RS_LRU_K:
 		printf("LRU-K");
 		break;
+	case RS_ARC:
+		printf("ARC");
+		break;
 	default:
 		printf("%i", bm->strategy);
 		break;
@@ -9,4 +9,8 @@ void printPageContent (BM_PageHandle *const page);
 char *sprintPoolContent (BM_BufferPool *const bm);
 char *sprintPageContent (BM_PageHandle *const page);
 
+// latency histograms, one line per operation (sprintLatencyHistograms returns NULL if memory runs out)
+void printLatencyHistograms (void);
+char *sprintLatencyHistograms (void);
+
 #endif
@@ -35,8 +35,16 @@ typedef int RC;
 #define RC_INVALID_PAGE_RANGE 95
 #define RC_BUFFER_POOL_INITIALIZE_ERROR 94
 #define RC_INVALID_STRATEGY 93
-#define RC_EMPTY_QUEUE 92;
-#define RC_FULL_BUFFER 91;
+#define RC_EMPTY_QUEUE 92
+#define RC_FULL_BUFFER 91
+#define RC_BUFFER_POOL_NOT_INIT 90
+#define RC_FRAME_IN_USE 89
+#define RC_BACKGROUND_WRITER_ERROR 88
+#define RC_IO_QUEUE_FULL 87
+#define RC_READ_FAILED 86
+#define RC_MAP_FAILED 85
+#define RC_CHECKSUM_MISMATCH 84
+#define RC_CORRUPT_PAGE_FILE 83
 
 /* holder for error messages */
 extern char *RC_message;
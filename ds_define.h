@@ -1,10 +1,22 @@
+#include <pthread.h>
+#include <stdatomic.h>
+
 #include "buffer_mgr.h"
+#include "storage_mgr.h"
 /*
-This code defines data structures and two functions (pinPageWithLRU and pinPageWithFIFO) that are used in buffer management. 
-The purpose of these functions is to manage the buffer pool, which is a portion of the memory used to store frequently accessed 
+This code defines data structures and the functions (pinPageWithLRU, pinPageWithFIFO, pinPageWithCLOCK, pinPageWithLFU, pinPageWithLRUK
+and pinPageWithARC) that are used in buffer management.
+The purpose of these functions is to manage the buffer pool, which is a portion of the memory used to store frequently accessed
 data pages in order to improve performance. pinPageWithLRU uses the Least Recently Used algorithm to replace the page that has not been accessed
 for the longest time, while pinPageWithFIFO uses the First-In, First-Out algorithm to replace the page that was first added to the buffer pool.
+pinPageWithCLOCK approximates LRU with a reference bit per frame and a rotating hand, so a hit only sets a bit.
+pinPageWithLFU replaces the least frequently used page, keeping frames in frequency buckets so every operation is constant time.
+pinPageWithLRUK replaces the page whose K-th most recent reference lies furthest in the past.
+pinPageWithARC adaptively balances a recency list and a frequency list using the history of recently evicted pages.
 */
+struct FrequencyBucket;
+struct LRUKHeap;
+
 typedef struct PageNode
 {
    char *data;
@@ -12,18 +24,366 @@ typedef struct PageNode
    int frameNumber;
    int fixCount;
    bool dirtyFlag;
+   bool refBit; // second-chance bit used by the CLOCK strategy
    struct PageNode *next;
    struct PageNode *prev;
+   struct FrequencyBucket *bucket; // LFU bucket of the frame
+   int arcList;                    // ARC list (T1 or T2) holding the frame
+   struct PageNode *policyNext;    // links of the strategy's own lists (LFU bucket, ARC T1/T2)
+   struct PageNode *policyPrev;
+   unsigned long *history; // LRU-K: times of the last K uncorrelated references, most recent first
+   unsigned long lastRef;  // LRU-K: time of the most recent reference, correlated or not
+   struct LRUKHeap *lrukHeap; // LRU-K: heap of victim candidates holding the unpinned frame, NULL while it is pinned
+   int heapIndex;             // LRU-K: position of the frame in that heap
+   unsigned long loadSeq;  // accessClock when the page was loaded; recorded accesses older than that were to its previous page
+   pthread_mutex_t latch;  // protects fixCount, dirtyFlag, ioInProgress and corrupt
+   pthread_cond_t ioDone;  // signalled when the page has been read into the frame
+   bool ioInProgress;
+   bool writeInProgress; // the page is being written back without a pin (background writer, flush, forcePage); its data stays readable
+   bool corrupt;         // the page read into the frame failed its checksum
 } PageNode;
 
+/*
+The page data of the frames lives in segments of page-aligned memory. A segment holds the data of a run of
+consecutive frames: frame firstFrame + i starts at memory + i * PAGE_SIZE. A pool starts out with one segment, and a
+resize that grows it beyond the room of its segments adds another one.
+*/
+typedef struct FrameSegment
+{
+   char *memory;
+   size_t size;
+   int firstFrame;
+   int numOfFrames; // frames the segment has room for, a huge page backed one may have more than it was asked for
+   bool mapped;       // the memory was mapped with mmap rather than allocated
+   BM_HugePages pages; // kind of pages the memory actually got
+   bool locked;       // the memory is locked into RAM
+} FrameSegment;
+
 typedef struct BufferQueue
 {
    PageNode *front;
    PageNode *rear;
-   int numOfFilledFrames;
+   PageNode **frames; // frame descriptors indexed by frame number
+   FrameSegment *segments; // memory of the frames, ordered by frame number
+   int numOfSegments;
+   int *freeFrames;     // stack of the frames that hold no page, the lowest frame number on top
+   int numOfFreeFrames;
    int frameCount;
+   int clockHand; // next frame inspected by the CLOCK strategy
 } BufferQueue;
 
+/*
+The page table maps a page number to the number of the frame currently holding it. It is an open-addressing hash table
+with linear probing; the capacity is a power of two and at least twice the number of entries, so probe sequences stay short.
+Empty slots hold NO_PAGE. LRU-K uses a second table of the same kind to find the history it retains for evicted pages.
+*/
+typedef struct PageTableSlot
+{
+   PageNumber pageNum;
+   int index;
+} PageTableSlot;
+
+typedef struct PageTable
+{
+   PageTableSlot *slots;
+   int capacity;
+   int shift; // 32 - log2(capacity), used by the multiplicative hash
+   int numOfEntries;
+} PageTable;
+
+/*
+The page table of a pool is split into stripes by page number, each with its own latch, so that threads working on
+different pages rarely wait for each other. A stripe grows when it becomes half full.
+*/
+#define PAGE_TABLE_STRIPES 64
+
+/*
+A hit of an LRU, LFU, LRU-K or ARC pool, and for LFU and LRU-K the unpin that leaves a frame unpinned, is not applied
+to the strategy right away. It is recorded in the access buffer of the page's stripe, under the stripe latch the pin
+or unpin holds anyway, so threads working on different pages do not meet on the strategy latch. Whoever takes the
+strategy latch applies the recorded accesses first (applyPageAccesses), in the order of their sequence numbers. A hit
+that finds its stripe's buffer full goes through the strategy latch instead.
+*/
+#define ACCESS_BUFFER_SIZE 32
+
+typedef struct PageAccess
+{
+   PageNode *pageNode;
+   unsigned long seq; // taken from accessClock of the pool
+   bool release;      // the last pin of the frame was dropped, rather than a pin taken
+} PageAccess;
+
+typedef struct PageTableStripe
+{
+   pthread_mutex_t latch;
+   PageTable table;
+   PageAccess accesses[ACCESS_BUFFER_SIZE];
+   int numOfAccesses;
+} PageTableStripe;
+
+/*
+LFU keeps one bucket per distinct access frequency, in a list ordered by increasing frequency. Each bucket links
+its unpinned frames from least to most recently used, while pinned frames are only counted, so the victim is always
+the head of the first bucket that has an unpinned frame. Buckets are preallocated (one per frame) and recycled
+through a free list.
+*/
+typedef struct FrequencyBucket
+{
+   int frequency;
+   int numOfFrames; // pinned and unpinned frames in this bucket
+   PageNode *head;
+   PageNode *tail;
+   struct FrequencyBucket *next;
+   struct FrequencyBucket *prev;
+} FrequencyBucket;
+
+typedef struct LFUState
+{
+   FrequencyBucket *buckets;
+   FrequencyBucket *freeBuckets;
+   FrequencyBucket *lowest;
+   int agingInterval;
+   int pinsSinceAging;
+} LFUState;
+
+/*
+LRU-K measures time in pins. Every frame owns K history slots in frameHistory; a time of 0 means the reference is
+unknown, i.e. an infinite backward distance. When a page is evicted its history is kept in a bounded ring of
+RetainedHistory records, found through retainedTable, and restored if the page is pinned again.
+
+The unpinned frames are the victim candidates and are kept in two binary min-heaps: correlated holds the frames
+that may still be within their correlated reference period, ordered by their most recent reference, and candidates
+the frames past it, ordered by their K-th most recent reference and then by their most recent one. A frame enters
+correlated when it is unpinned and moves over to candidates once its period has run out; a frame's keys only change
+when it is pinned, which takes it out of its heap. So a victim is found in logarithmic time.
+*/
+typedef struct RetainedHistory
+{
+   PageNumber pageNum;
+   unsigned long lastRef;
+   unsigned long *history;
+} RetainedHistory;
+
+typedef struct LRUKHeap
+{
+   PageNode **frames;
+   int size;
+} LRUKHeap;
+
+typedef struct LRUKState
+{
+   int k;
+   unsigned long correlatedRefPeriod;
+   unsigned long clock;
+   unsigned long *frameHistory;
+   RetainedHistory *retained;
+   unsigned long *retainedHistory;
+   int historySize;
+   int nextRetained;
+   PageTable retainedTable;
+   LRUKHeap candidates;
+   LRUKHeap correlated;
+} LRUKState;
+
+/*
+ARC splits the resident pages into T1 (seen once recently) and T2 (seen at least twice) and remembers the page
+numbers of pages recently evicted from them in the ghost lists B1 and B2. A hit in B1 grows the target size of T1,
+a hit in B2 shrinks it. All lists run from the least recently used entry (head) to the most recently used (tail).
+Ghost entries are preallocated and found through ghostTable, which maps a page number to its entry.
+*/
+#define ARC_T1 1
+#define ARC_T2 2
+#define ARC_B1 3
+#define ARC_B2 4
+
+typedef struct ARCList
+{
+   PageNode *head;
+   PageNode *tail;
+   int size;
+} ARCList;
+
+typedef struct GhostEntry
+{
+   PageNumber pageNum;
+   int list;
+   struct GhostEntry *next;
+   struct GhostEntry *prev;
+} GhostEntry;
+
+typedef struct GhostList
+{
+   GhostEntry *head;
+   GhostEntry *tail;
+   int size;
+} GhostList;
+
+typedef struct ARCState
+{
+   int capacity;
+   int target; // desired size of T1
+   ARCList t1;
+   ARCList t2;
+   GhostList b1;
+   GhostList b2;
+   GhostEntry *ghosts;
+   GhostEntry *freeGhosts;
+   PageTable ghostTable;
+} ARCState;
+
+/*
+The background writer is a thread that periodically writes unpinned dirty frames back, so that the replacement
+strategies mostly find clean victims. It walks the frames with its own cursor, much like a clock hand.
+*/
+typedef struct BackgroundWriter
+{
+   struct BufferPoolMgmt *pool;
+   pthread_t thread;
+   pthread_mutex_t latch;
+   pthread_cond_t wakeup;
+   bool stop;
+   int dirtyRatio;
+   int pagesPerRound;
+   int intervalMillis;
+   int cursor;
+} BackgroundWriter;
+
+/*
+Read-ahead assigns frames to pages that are expected to be pinned soon, the same way a miss does, and hands the
+frames to a reader thread that reads the pages and then drops the pin taken for the read. Pins of such a page wait
+for its read like they wait for any other miss. A run of consecutive pins (lastPinned, sequentialRun) triggers it
+automatically once a window is set; nextPage is the first page not yet read ahead. pending is a ring with one
+slot per frame (capacity), which is enough since a frame is queued at most once.
+*/
+typedef struct ReadAhead
+{
+   struct BufferPoolMgmt *pool;
+   pthread_t thread;
+   pthread_mutex_t latch;
+   pthread_cond_t wakeup;
+   bool stop;
+   PageNode **pending;
+   int capacity;
+   int head;
+   int numOfPending;
+   int window;
+   PageNumber lastPinned;
+   int sequentialRun;
+   PageNumber nextPage;
+} ReadAhead;
+
+/*
+An access ring remembers, per slot, the frame it loaded a page into and that page. The frame is only reused while
+it still holds that page, since the pool may have given the frame to another page in the meantime.
+*/
+typedef struct AccessRingSlot
+{
+   int frameNumber;
+   PageNumber pageNum;
+} AccessRingSlot;
+
+typedef struct AccessRing
+{
+   AccessRingSlot *slots;
+   int next;
+} AccessRing;
+
+/*
+A resize lists the pages of an LRU-K pool by their K-th and most recent reference, oldest first.
+*/
+typedef struct LRUKRank
+{
+   unsigned long kth;
+   unsigned long first;
+   PageNode *pageNode;
+} LRUKRank;
+
+/*
+A resize allocates everything it may need before it changes the pool, so that it can still give up and leave the
+pool as it was. frames is the new frame table; when the pool grows, the descriptors of the added frames are already
+in it, and segments ends with the segment allocated for them if the pool had no room left.
+*/
+typedef struct ResizeState
+{
+   PageNode **frames;
+   int *freeFrames;
+   FrameSegment *segments;
+   int numOfSegments;
+   bool newSegment;
+   PageNode **order;
+   FrequencyBucket *buckets;
+   unsigned long *frameHistory;
+   PageNode **candidates;
+   PageNode **correlated;
+   ARCState arc;
+   bool arcReady;
+   PageNode **pending;
+} ResizeState;
+
+/*
+Everything a buffer pool needs is reachable from BM_BufferPool.mgmtData, which points at a BufferPoolMgmt, so
+several pools (each with its own page file, size and strategy) can be used side by side. Only the state of the
+pool's replacement strategy is allocated.
+
+Latching: strategyLatch protects the buffer queue and the strategy state and is held while a miss picks its frame;
+a page table stripe latch is held while a page is looked up, inserted or removed, and while an access is recorded in
+the stripe's access buffer; the frame latch protects the pin count, dirty flag and I/O state of one frame. They are always taken in that order. ioLatch serializes writes to
+the page file and the use of the asynchronous I/O queue; a demand miss reads its page at its offset without it.
+resizeLatch comes before all of them: a resize holds it exclusively, while the code that walks the frames without
+the strategy latch or a stripe latch (flushing, forcePage, snapshots, the background writer) holds it shared.
+*/
+typedef struct BufferPoolMgmt
+{
+   SM_FileHandle fh;
+   BufferQueue queue;
+   SM_AsyncIO aio; // used by batch reads, read-ahead and flushes, under ioLatch
+   PageTableStripe pageTable[PAGE_TABLE_STRIPES];
+   LFUState *lfu;
+   LRUKState *lruk;
+   ARCState *arc;
+   BackgroundWriter *writer;
+   ReadAhead *readAhead;
+   pthread_mutex_t strategyLatch;
+   pthread_mutex_t ioLatch;
+   pthread_rwlock_t resizeLatch;
+   BM_PoolMemoryConfig memory; // requested backing of the frame memory, also used when the pool is resized
+   BM_StorageMode storageMode;
+   bool verifyChecksums; // pages read into frames or pinned zero-copy are checked against their checksums
+   atomic_int numOfMappedPins; // read-only pins that point into the mapping of the page file
+   PageNode *pendingLoad; // frame claimed by the current miss, read after strategyLatch is released
+   PageNode *ringVictim;  // frame of an access ring that the current miss must reuse
+   bool ringMode;         // the current pin goes through an access ring
+   PageAccess *accessBatch; // room for the accesses of all stripes, NULL if the strategy does not record accesses
+   atomic_ulong accessClock; // sequence number of the next recorded access
+   unsigned long appliedClock; // accessClock when the recorded accesses were last applied, under strategyLatch
+   atomic_int numOfReadOps; // demand misses count their reads without a latch
+   int numOfWriteOps;
+   atomic_long numOfHits; // statistics counters, updated without a latch
+   atomic_long numOfMisses;
+   atomic_long numOfEvictions;
+   atomic_long numOfDirtyEvictions;
+   atomic_long numOfPinWaits;
+} BufferPoolMgmt;
+
+RC insertPageTable(PageTable *const table, const PageNumber pageNum, const int index);
+RC unpinPageNumber(BufferPoolMgmt *const pool, const PageNumber pageNum);
+RC releasePin(BufferPoolMgmt *const pool, const PageNumber pageNum);
+void applyPageAccesses(BufferPoolMgmt *const pool, const bool stripesLatched);
+void stopReadAhead(BufferPoolMgmt *const pool);
+void readAheadAfterPin(BM_BufferPool *const bm, const PageNumber pageNum, const bool zeroCopy);
 
 RC pinPageWithLRU(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum);
-RC pinPageWithFIFO(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum);
\ No newline at end of file
+RC pinPageWithFIFO(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum);
+RC pinPageWithCLOCK(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum);
+RC pinPageWithLFU(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum);
+
+RC pinPageWithLRUK(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum);
+RC pinPageWithARC(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum);
+
+RC initializeLFU(LFUState *const lfu, const int numPages, const BM_LFU_StratData *const stratData);
+void releaseLFUFrame(PageNode *const pageNode);
+RC initializeLRUK(LRUKState *const lruk, PageNode **const frames, const int numPages, const BM_LRU_K_StratData *const stratData);
+void releaseLRUKFrame(LRUKState *const lruk, PageNode *const pageNode);
+void freeLRUK(LRUKState *const lruk);
+RC initializeARC(ARCState *const arc, const int numPages);
+void freeARC(ARCState *const arc);
@@ -0,0 +1,263 @@
+#include "latency_stat.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+Every thread records into its own histograms, so recording takes no latch and no locked instruction: a counter has a
+single writer and is only read by other threads. The per-thread histograms are linked into a registry so readers can
+sum them, and when a thread exits its counts are folded into the retired histograms.
+*/
+typedef struct AtomicHistogram {
+	atomic_ulong count;
+	atomic_ulong sumNanos;
+	atomic_ulong maxNanos;
+	atomic_ulong buckets[LATENCY_NUM_BUCKETS];
+} AtomicHistogram;
+
+typedef struct ThreadHistograms {
+	AtomicHistogram hist[LATENCY_NUM_OPS];
+	struct ThreadHistograms *next;
+	struct ThreadHistograms *prev;
+} ThreadHistograms;
+
+static pthread_mutex_t registryLatch = PTHREAD_MUTEX_INITIALIZER;
+static ThreadHistograms *registry;
+static LatencyHistogram retired[LATENCY_NUM_OPS];
+static pthread_once_t threadKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t threadKey;
+static _Thread_local ThreadHistograms *localHistograms;
+
+static const char *opNames[LATENCY_NUM_OPS] = { "pinHit", "pinMiss", "unpin", "readBlock", "writeBlock" };
+
+/**
+*
+* This function adds one counter of a thread's histogram, which only that thread writes.
+*
+*/
+static void addCounter(atomic_ulong *const counter, const unsigned long value)
+{
+	atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+/**
+*
+* This function adds the counts of a thread's histogram to hist.
+*
+*/
+static void sumHistogram(LatencyHistogram *const hist, AtomicHistogram *const from)
+{
+	hist->count += atomic_load_explicit(&from->count, memory_order_relaxed);
+	hist->sumNanos += atomic_load_explicit(&from->sumNanos, memory_order_relaxed);
+	unsigned long max = atomic_load_explicit(&from->maxNanos, memory_order_relaxed);
+	if (max > hist->maxNanos) {
+		hist->maxNanos = max;
+	}
+	for (int i = 0; i < LATENCY_NUM_BUCKETS; i++) {
+		hist->buckets[i] += atomic_load_explicit(&from->buckets[i], memory_order_relaxed);
+	}
+}
+
+/**
+*
+* This function runs when a thread that recorded latencies exits and moves its counts to the retired histograms.
+*
+*/
+static void retireThreadHistograms(void *arg)
+{
+	ThreadHistograms *local = arg;
+
+	pthread_mutex_lock(&registryLatch);
+	for (int op = 0; op < LATENCY_NUM_OPS; op++) {
+		sumHistogram(&retired[op], &local->hist[op]);
+	}
+	if (local->prev) {
+		local->prev->next = local->next;
+	} else {
+		registry = local->next;
+	}
+	if (local->next) {
+		local->next->prev = local->prev;
+	}
+	pthread_mutex_unlock(&registryLatch);
+	free(local);
+}
+
+static void createThreadKey(void)
+{
+	pthread_key_create(&threadKey, retireThreadHistograms);
+}
+
+/**
+*
+* This function returns the histograms of the calling thread, registering them on the thread's first recording.
+*
+*/
+static ThreadHistograms *threadHistograms(void)
+{
+	if (localHistograms) {
+		return localHistograms;
+	}
+
+	ThreadHistograms *local = calloc(1, sizeof(ThreadHistograms));
+	if (!local) {
+		return NULL;
+	}
+	pthread_once(&threadKeyOnce, createThreadKey);
+	pthread_setspecific(threadKey, local);
+
+	pthread_mutex_lock(&registryLatch);
+	local->next = registry;
+	if (registry) {
+		registry->prev = local;
+	}
+	registry = local;
+	pthread_mutex_unlock(&registryLatch);
+
+	localHistograms = local;
+	return local;
+}
+
+/**
+*
+* This function maps a latency to its bucket: the value itself below 16, otherwise 16 buckets per power of two.
+*
+*/
+static int latencyBucket(const unsigned long nanos)
+{
+	if (nanos < LATENCY_SUB_BUCKETS) {
+		return (int)nanos;
+	}
+	int exponent = 63 - __builtin_clzl(nanos);
+	return (exponent - 3) * LATENCY_SUB_BUCKETS + (int)((nanos >> (exponent - 4)) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+/**
+*
+* This function returns the largest latency that falls into a bucket.
+*
+*/
+static unsigned long bucketUpperBound(const int bucket)
+{
+	if (bucket < LATENCY_SUB_BUCKETS) {
+		return (unsigned long)bucket;
+	}
+	int exponent = bucket / LATENCY_SUB_BUCKETS + 3;
+	unsigned long lower = (unsigned long)(LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS) << (exponent - 4);
+	return lower + (1UL << (exponent - 4)) - 1;
+}
+
+/**
+*
+* This function returns the current time of the monotonic clock in nanoseconds.
+*
+*/
+unsigned long latencyNow(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long)now.tv_sec * 1000000000UL + (unsigned long)now.tv_nsec;
+}
+
+/**
+*
+* This function records one latency of an operation in the histograms of the calling thread.
+*
+*/
+void recordLatency(const LatencyOp op, const unsigned long nanos)
+{
+	ThreadHistograms *local = threadHistograms();
+	if (!local || op < 0 || op >= LATENCY_NUM_OPS) {
+		return;
+	}
+
+	AtomicHistogram *hist = &local->hist[op];
+	addCounter(&hist->count, 1);
+	addCounter(&hist->sumNanos, nanos);
+	addCounter(&hist->buckets[latencyBucket(nanos)], 1);
+	if (nanos > atomic_load_explicit(&hist->maxNanos, memory_order_relaxed)) {
+		atomic_store_explicit(&hist->maxNanos, nanos, memory_order_relaxed);
+	}
+}
+
+/**
+*
+* This function fills hist with the latencies of an operation recorded by all threads so far.
+*
+*/
+void getLatencyHistogram(const LatencyOp op, LatencyHistogram *const hist)
+{
+	memset(hist, 0, sizeof(LatencyHistogram));
+	if (op < 0 || op >= LATENCY_NUM_OPS) {
+		return;
+	}
+
+	pthread_mutex_lock(&registryLatch);
+	memcpy(hist, &retired[op], sizeof(LatencyHistogram));
+	for (ThreadHistograms *local = registry; local; local = local->next) {
+		sumHistogram(hist, &local->hist[op]);
+	}
+	pthread_mutex_unlock(&registryLatch);
+}
+
+/**
+*
+* This function returns the latency below which the given percentage of the recorded latencies lie, rounded up to
+* the end of its bucket but never beyond the largest latency recorded. It returns 0 for an empty histogram.
+*
+*/
+unsigned long latencyPercentile(const LatencyHistogram *const hist, const double percentile)
+{
+	if (hist->count == 0) {
+		return 0;
+	}
+
+	double exactRank = percentile / 100.0 * hist->count;
+	unsigned long rank = (unsigned long)exactRank;
+	if (rank < exactRank) {
+		rank++;
+	}
+	if (rank < 1) {
+		rank = 1;
+	}
+	if (rank > hist->count) {
+		rank = hist->count;
+	}
+
+	unsigned long seen = 0;
+	for (int i = 0; i < LATENCY_NUM_BUCKETS; i++) {
+		seen += hist->buckets[i];
+		if (seen >= rank) {
+			unsigned long upper = bucketUpperBound(i);
+			return (upper < hist->maxNanos) ? upper : hist->maxNanos;
+		}
+	}
+	return hist->maxNanos;
+}
+
+/**
+*
+* This function returns the name of an operation as it appears in the latency dump.
+*
+*/
+const char *latencyOpName(const LatencyOp op)
+{
+	return (op >= 0 && op < LATENCY_NUM_OPS) ? opNames[op] : "unknown";
+}
+
+/**
+*
+* This function tells whether latency recording was compiled in.
+*
+*/
+bool latencyHistogramsEnabled(void)
+{
+#ifdef BM_LATENCY_HISTOGRAMS
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,50 @@
+#ifndef LATENCY_STAT_H
+#define LATENCY_STAT_H
+
+#include "dt.h"
+
+/************************************************************
+ *                    latency histograms                    *
+ ************************************************************/
+/* Latencies are recorded in nanoseconds into log-linear buckets (as in HDR
+ * histograms): values below 16 get a bucket each, every larger power of two is
+ * split into 16 buckets, so a bucket is at most 1/16 wider than its lower bound.
+ * Each thread counts into its own histograms; reading them sums all threads.
+ *
+ * Recording is compiled in only if BM_LATENCY_HISTOGRAMS is defined; otherwise
+ * LATENCY_START and LATENCY_RECORD expand to nothing and the histograms stay empty. */
+typedef enum LatencyOp {
+	LATENCY_PIN_HIT = 0,
+	LATENCY_PIN_MISS = 1,
+	LATENCY_UNPIN = 2,
+	LATENCY_READ_BLOCK = 3,
+	LATENCY_WRITE_BLOCK = 4
+} LatencyOp;
+
+#define LATENCY_NUM_OPS 5
+#define LATENCY_SUB_BUCKETS 16
+#define LATENCY_NUM_BUCKETS ((64 - 3) * LATENCY_SUB_BUCKETS)
+
+typedef struct LatencyHistogram {
+	unsigned long count;
+	unsigned long sumNanos;
+	unsigned long maxNanos;
+	unsigned long buckets[LATENCY_NUM_BUCKETS];
+} LatencyHistogram;
+
+#ifdef BM_LATENCY_HISTOGRAMS
+#define LATENCY_START(start) unsigned long start = latencyNow()
+#define LATENCY_RECORD(op, start) recordLatency((op), latencyNow() - (start))
+#else
+#define LATENCY_START(start)
+#define LATENCY_RECORD(op, start)
+#endif
+
+unsigned long latencyNow (void);
+void recordLatency (const LatencyOp op, const unsigned long nanos);
+void getLatencyHistogram (const LatencyOp op, LatencyHistogram *const hist);
+unsigned long latencyPercentile (const LatencyHistogram *const hist, const double percentile);
+const char *latencyOpName (const LatencyOp op);
+bool latencyHistogramsEnabled (void);
+
+#endif
@@ -0,0 +1,201 @@
+#include "lz_codec.h"
+#include "dt.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+The compressor finds matches through a hash table of the last position at which each 4-byte sequence (hashed to
+LZ_HASH_BITS bits) was seen, and takes the first match it finds (greedy parsing). Where nothing matches it moves
+ahead in growing steps, so data that does not compress is skipped over quickly.
+*/
+#define LZ_HASH_BITS 12
+#define LZ_SKIP_SHIFT 5
+
+static uint32_t read32(const unsigned char *const p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static uint32_t hashSequence(const uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/**
+*
+* This function writes the part of a length beyond what its nibble holds (15 or more) as bytes of 255 and a
+* final byte below 255. It returns false if the bytes do not fit.
+*
+*/
+static bool writeLength(unsigned char *const dest, int *const op, const int destCapacity, int length)
+{
+	for (; length >= 255; length -= 255) {
+		if (*op >= destCapacity) {
+			return false;
+		}
+		dest[(*op)++] = 255;
+	}
+	if (*op >= destCapacity) {
+		return false;
+	}
+	dest[(*op)++] = (unsigned char)length;
+	return true;
+}
+
+/**
+*
+* This function writes one sequence: the literals from source + anchor up to literalEnd and, unless matchLength is
+* 0 (the last sequence), a match of matchLength bytes at offset. It returns false if the sequence does not fit.
+*
+*/
+static bool writeSequence(const unsigned char *const source, const int anchor, const int literalEnd, const int offset,
+						 const int matchLength, unsigned char *const dest, int *const op, const int destCapacity)
+{
+	int literals = literalEnd - anchor;
+	int matchCode = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+	if (*op >= destCapacity) {
+		return false;
+	}
+	dest[(*op)++] = (unsigned char)(((literals < 15) ? literals : 15) << 4 | ((matchCode < 15) ? matchCode : 15));
+	if (literals >= 15 && !writeLength(dest, op, destCapacity, literals - 15)) {
+		return false;
+	}
+	if (*op + literals > destCapacity) {
+		return false;
+	}
+	memcpy(dest + *op, source + anchor, literals);
+	*op += literals;
+	if (!matchLength) {
+		return true;
+	}
+
+	if (*op + 2 > destCapacity) {
+		return false;
+	}
+	dest[(*op)++] = (unsigned char)(offset & 0xFF);
+	dest[(*op)++] = (unsigned char)(offset >> 8);
+	return matchCode < 15 || writeLength(dest, op, destCapacity, matchCode - 15);
+}
+
+/**
+*
+* This function compresses sourceSize bytes of source into dest, see lz_codec.h.
+*
+*/
+int lzCompress(const char *const source, const int sourceSize, char *const dest, const int destCapacity)
+{
+	const unsigned char *src = (const unsigned char *)source;
+	unsigned char *dst = (unsigned char *)dest;
+	int table[1 << LZ_HASH_BITS];
+	int ip = 0;
+	int anchor = 0;
+	int op = 0;
+
+	if (sourceSize < 0 || sourceSize > LZ_MAX_INPUT) {
+		return 0;
+	}
+	for (int i = 0; i < (1 << LZ_HASH_BITS); i++) {
+		table[i] = -1;
+	}
+
+	while (ip + LZ_MIN_MATCH <= sourceSize) {
+		uint32_t sequence = read32(src + ip);
+		uint32_t hash = hashSequence(sequence);
+		int candidate = table[hash];
+		table[hash] = ip;
+
+		if (candidate < 0 || read32(src + candidate) != sequence) {
+			ip += 1 + ((ip - anchor) >> LZ_SKIP_SHIFT);
+			continue;
+		}
+
+		int matchLength = LZ_MIN_MATCH;
+		while (ip + matchLength < sourceSize && src[candidate + matchLength] == src[ip + matchLength]) {
+			matchLength++;
+		}
+		if (!writeSequence(src, anchor, ip, ip - candidate, matchLength, dst, &op, destCapacity)) {
+			return 0;
+		}
+		ip += matchLength;
+		anchor = ip;
+		if (ip - 2 + LZ_MIN_MATCH <= sourceSize) {
+			table[hashSequence(read32(src + ip - 2))] = ip - 2;
+		}
+	}
+
+	return writeSequence(src, anchor, sourceSize, 0, 0, dst, &op, destCapacity) ? op : 0;
+}
+
+/**
+*
+* This function reads the bytes that extend a length whose nibble was 15. It returns false if the input ends first.
+*
+*/
+static bool readLength(const unsigned char *const source, int *const ip, const int sourceSize, int *const length)
+{
+	unsigned char byte;
+	do {
+		if (*ip >= sourceSize) {
+			return false;
+		}
+		byte = source[(*ip)++];
+		*length += byte;
+	} while (byte == 255);
+	return true;
+}
+
+/**
+*
+* This function decompresses sourceSize bytes of source into dest, checking every length and offset against the
+* bounds of both buffers, so a damaged input cannot make it read or write outside them.
+*
+*/
+int lzDecompress(const char *const source, const int sourceSize, char *const dest, const int destCapacity)
+{
+	const unsigned char *src = (const unsigned char *)source;
+	unsigned char *dst = (unsigned char *)dest;
+	int ip = 0;
+	int op = 0;
+
+	while (ip < sourceSize) {
+		int token = src[ip++];
+		int literals = token >> 4;
+		if (literals == 15 && !readLength(src, &ip, sourceSize, &literals)) {
+			return -1;
+		}
+		if (literals > sourceSize - ip || literals > destCapacity - op) {
+			return -1;
+		}
+		memcpy(dst + op, src + ip, literals);
+		ip += literals;
+		op += literals;
+		if (ip == sourceSize) {
+			break; // the last sequence has no match
+		}
+
+		if (sourceSize - ip < 2) {
+			return -1;
+		}
+		int offset = src[ip] | src[ip + 1] << 8;
+		ip += 2;
+		int matchLength = (token & 15) + LZ_MIN_MATCH;
+		if ((token & 15) == 15 && !readLength(src, &ip, sourceSize, &matchLength)) {
+			return -1;
+		}
+		if (offset == 0 || offset > op || matchLength > destCapacity - op) {
+			return -1;
+		}
+		if (offset >= matchLength) {
+			memcpy(dst + op, dst + op - offset, matchLength);
+		} else {
+			for (int i = 0; i < matchLength; i++) { // the match overlaps the bytes it produces
+				dst[op + i] = dst[op + i - offset];
+			}
+		}
+		op += matchLength;
+	}
+	return op;
+}
@@ -0,0 +1,25 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+/************************************************************
+ *                    LZ page codec                         *
+ ************************************************************/
+/* A byte-oriented LZ77 codec in the style of LZ4, fast enough to compress pages
+ * on every write. The output is a series of sequences, each a token byte (literal
+ * run length in the high nibble, match length minus LZ_MIN_MATCH in the low one,
+ * 15 meaning that more length bytes follow), the literals, and a two-byte offset
+ * back into the output plus any further match length bytes. The last sequence
+ * has literals only. Inputs are at most LZ_MAX_INPUT bytes, so offsets fit in
+ * 16 bits. */
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_INPUT 65535
+
+/* Compresses sourceSize bytes into dest and returns the compressed size, or 0 if
+ * the result would not fit into destCapacity bytes (the data does not compress). */
+int lzCompress (const char *const source, const int sourceSize, char *const dest, const int destCapacity);
+
+/* Decompresses sourceSize bytes into dest and returns the decompressed size, or
+ * -1 if the input is malformed or would not fit into destCapacity bytes. */
+int lzDecompress (const char *const source, const int sourceSize, char *const dest, const int destCapacity);
+
+#endif
@@ -9,24 +9,721 @@
 *  create, open, and close files. It is responsible for maintaining
 *  various information related to an open file such as the total
 *  number of pages, the current page position for reading/writing,
-*  the file name, and either a POSIX file descriptor or a FILE pointer.
+*  the file name, and the POSIX file descriptor the pages are read and
+*  written through.
 *
 *  @author Rushikesh Kadam (A20517258) - rkadam7@hawk.iit.edu
 *  @author Haren Amal (A20513547) - hamal@hawk.iit.edu
 *  @author Gabriel Baranes (A20521263) - gbaranes@hawk.iit.edu
 */
 
+// fallocate and FALLOC_FL_KEEP_SIZE, used to reserve space beyond the end of a file
+#define _GNU_SOURCE
+
 // user-defined libraries
 #include "storage_mgr.h"
 #include "dberror.h"
+#include "latency_stat.h"
+#include "trace_log.h"
+#include "lz_codec.h"
 
 // system-defined libraries
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdbool.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// io_uring is used for asynchronous I/O where the kernel headers provide it; -DSM_NO_IO_URING leaves it out
+#if defined(__linux__) && !defined(SM_NO_IO_URING) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define SM_IO_URING
+#endif
+
+// CRC32C instructions: SSE4.2 on x86-64 (chosen at run time), the CRC extension on ARMv8 (chosen at compile time)
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define SM_CRC32C_SSE42
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define SM_CRC32C_ARM
+#endif
+
+// Largest number of buffers a single vectored write may take, if the headers do not tell
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/*
+Every open page file has its own descriptor, kept in a PageFile that the mgmtInfo of its handle points to. Pages are
+read and written at their offset (pread, pwrite), so the descriptor has no position that threads could race on, and
+several threads may read pages of the same handle at once. The page count and position of a handle are therefore
+read and updated atomically, while writes to a handle still have to come from one thread at a time.
+*/
+typedef struct PageFile {
+	int fd;
+	char *map;                // read-only mapping of the file (see mapPageFile), NULL if the handle is not mapped
+	size_t mapReserved;       // address space reserved for the mapping
+	int mappedPages;          // pages mapped so far, read atomically
+	int advice;               // madvise advice for the mapping, applied again when it grows
+	pthread_mutex_t mapLatch; // serializes growing the mapping
+	SM_GrowthPolicy growthPolicy;
+	int reservedPages; // pages the file has space allocated for, including space reserved beyond its end
+	SM_ChecksumMode checksumMode;
+	struct CompressedFile *compressed; // indirection map of a compressed page file, NULL for a plain one
+	unsigned char *blankPages;  // a bit for each page the handle added to the file and has not written (see isBlankPage)
+	int blankCapacity;          // pages blankPages has bits for
+	pthread_mutex_t blankLatch; // guards blankPages
+} PageFile;
+
+// Address space a mapping reserves: MAP_RESERVE_FACTOR times the file, but at least MAP_MIN_RESERVE bytes
+#define MAP_RESERVE_FACTOR 4
+#define MAP_MIN_RESERVE ((size_t)1 << 30)
+
+static int pageFileDescriptor(SM_FileHandle *fHandle)
+{
+	return (fHandle && fHandle->mgmtInfo) ? ((PageFile *)fHandle->mgmtInfo)->fd : -1;
+}
+
+static int pageCount(SM_FileHandle *fHandle)
+{
+	return __atomic_load_n(&fHandle->totalNumPages, __ATOMIC_ACQUIRE);
+}
+
+static void setPageCount(SM_FileHandle *fHandle, int totalNumPages)
+{
+	__atomic_store_n(&fHandle->totalNumPages, totalNumPages, __ATOMIC_RELEASE);
+}
+
+static void setPagePos(SM_FileHandle *fHandle, int pageNum)
+{
+	__atomic_store_n(&fHandle->curPagePos, pageNum, __ATOMIC_RELAXED);
+}
+
+/*
+A file that grows geometrically gets space allocated beyond its end whenever it outgrows the space it has: as many
+pages again as it holds, at least SM_MIN_GROWTH_PAGES and at most SM_MAX_GROWTH_PAGES. The space is allocated with
+FALLOC_FL_KEEP_SIZE, so the size of the file, and with it the number of pages, stays what was written or asked for;
+appending pages only moves the end of the file into space that is already allocated. Where the kernel cannot reserve
+space this way the file simply grows exactly.
+*/
+static void reserveGrowth(SM_FileHandle *fHandle, int numberOfPages)
+{
+	PageFile *pageFile = fHandle->mgmtInfo;
+	if (pageFile->growthPolicy != SM_GROWTH_GEOMETRIC || pageFile->compressed || numberOfPages <= pageFile->reservedPages)
+		return;
+
+	int total = pageCount(fHandle);
+	int growth = (total < SM_MIN_GROWTH_PAGES) ? SM_MIN_GROWTH_PAGES : (total > SM_MAX_GROWTH_PAGES) ? SM_MAX_GROWTH_PAGES : total;
+	int reserve = (numberOfPages > INT_MAX - growth) ? INT_MAX : numberOfPages + growth;
+#ifdef FALLOC_FL_KEEP_SIZE
+	int from = (pageFile->reservedPages > total) ? pageFile->reservedPages : total;
+	if (fallocate(pageFile->fd, FALLOC_FL_KEEP_SIZE, (off_t)from * PAGE_SIZE, (off_t)(reserve - from) * PAGE_SIZE) == 0)
+		pageFile->reservedPages = reserve;
+#endif
+}
+
+/**
+*
+* This function reads or writes the page buffers described by pages at offset, with as many vectored calls as it
+* takes: a short transfer is continued from the first byte not transferred. A read stops at the end of the file.
+* It returns the number of bytes transferred, or -errno if nothing could be transferred. The iovecs are consumed.
+*
+*/
+static ssize_t transferPages(int fd, struct iovec *pages, int count, off_t offset, bool isWrite)
+{
+	struct iovec *next = pages;
+	int remaining = count;
+	ssize_t total = 0;
+
+	while (remaining > 0)
+	{
+		ssize_t bytes = isWrite ? pwritev(fd, next, remaining, offset) : preadv(fd, next, remaining, offset);
+		if (bytes < 0 && errno == EINTR)
+			continue;
+		if (bytes < 0)
+			return (total > 0) ? total : -errno;
+		if (bytes == 0)
+			break;
+		total += bytes;
+		offset += bytes;
+		while (remaining > 0 && (size_t)bytes >= next->iov_len)
+		{
+			bytes -= next->iov_len;
+			next++;
+			remaining--;
+		}
+		if (remaining > 0)
+		{
+			next->iov_base = (char *)next->iov_base + bytes;
+			next->iov_len -= bytes;
+		}
+	}
+	return total;
+}
+
+/*
+Page checksums are CRC32C (Castagnoli polynomial). Where the CPU has CRC32C instructions a page takes 512 of them,
+8 bytes each, which runs at several GB/s per core; elsewhere the slicing-by-8 tables below, built on first use,
+handle 8 bytes per step with table lookups. The implementation is picked once.
+*/
+#define CRC32C_POLYNOMIAL 0x82F63B78u // bit-reversed
+
+static uint32_t crc32cTable[8][256];
+static pthread_once_t crc32cOnce = PTHREAD_ONCE_INIT;
+static uint32_t (*crc32cUpdate)(uint32_t crc, const unsigned char *data, size_t length);
+
+static uint32_t crc32cSoftware(uint32_t crc, const unsigned char *data, size_t length)
+{
+	for (; length >= 8; data += 8, length -= 8)
+	{
+		uint32_t low = crc ^ ((uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24);
+		crc = crc32cTable[7][low & 0xFF] ^ crc32cTable[6][(low >> 8) & 0xFF] ^ crc32cTable[5][(low >> 16) & 0xFF]
+			^ crc32cTable[4][low >> 24] ^ crc32cTable[3][data[4]] ^ crc32cTable[2][data[5]] ^ crc32cTable[1][data[6]]
+			^ crc32cTable[0][data[7]];
+	}
+	for (; length > 0; data++, length--)
+		crc = crc32cTable[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+#if defined(SM_CRC32C_SSE42)
+__attribute__((target("sse4.2")))
+static uint32_t crc32cHardware(uint32_t crc, const unsigned char *data, size_t length)
+{
+#if defined(__x86_64__)
+	uint64_t crc64 = crc;
+	for (; length >= 8; data += 8, length -= 8)
+	{
+		uint64_t word;
+		memcpy(&word, data, sizeof(word));
+		crc64 = _mm_crc32_u64(crc64, word);
+	}
+	crc = (uint32_t)crc64;
+#endif
+	for (; length >= 4; data += 4, length -= 4)
+	{
+		uint32_t word;
+		memcpy(&word, data, sizeof(word));
+		crc = _mm_crc32_u32(crc, word);
+	}
+	for (; length > 0; data++, length--)
+		crc = _mm_crc32_u8(crc, *data);
+	return crc;
+}
+#elif defined(SM_CRC32C_ARM)
+static uint32_t crc32cHardware(uint32_t crc, const unsigned char *data, size_t length)
+{
+	for (; length >= 8; data += 8, length -= 8)
+	{
+		uint64_t word;
+		memcpy(&word, data, sizeof(word));
+		crc = __crc32cd(crc, word);
+	}
+	for (; length > 0; data++, length--)
+		crc = __crc32cb(crc, *data);
+	return crc;
+}
+#endif
+
+static void initCRC32C(void)
+{
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		uint32_t crc = i;
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLYNOMIAL : 0);
+		crc32cTable[0][i] = crc;
+	}
+	for (int k = 1; k < 8; k++)
+		for (int i = 0; i < 256; i++)
+			crc32cTable[k][i] = (crc32cTable[k - 1][i] >> 8) ^ crc32cTable[0][crc32cTable[k - 1][i] & 0xFF];
+
+	crc32cUpdate = crc32cSoftware;
+#if defined(SM_CRC32C_SSE42)
+	if (__builtin_cpu_supports("sse4.2"))
+		crc32cUpdate = crc32cHardware;
+#elif defined(SM_CRC32C_ARM)
+	crc32cUpdate = crc32cHardware;
+#endif
+}
+
+/**
+*
+* This function returns the CRC32C of length bytes of data.
+*
+*/
+unsigned int computeCRC32C(const char *data, int length)
+{
+	pthread_once(&crc32cOnce, initCRC32C);
+	return ~crc32cUpdate(~0u, (const unsigned char *)data, (size_t)length);
+}
+
+/**
+*
+* This function stores the checksum of a page in its last PAGE_CHECKSUM_SIZE bytes, least significant byte first.
+*
+*/
+static void stampChecksum(SM_PageHandle memPage)
+{
+	uint32_t checksum = computeCRC32C(memPage, PAGE_CHECKSUM_OFFSET);
+	for (int i = 0; i < PAGE_CHECKSUM_SIZE; i++)
+		memPage[PAGE_CHECKSUM_OFFSET + i] = (char)(checksum >> (8 * i));
+}
+
+/**
+*
+* This function checks the checksum stored in a page. Only a page whose checksum matches passes, a page of zeros
+* does not; verifyPage makes that exception for pages the file never wrote.
+*
+*/
+RC verifyBlock(SM_PageHandle memPage)
+{
+	uint32_t stored = 0;
+	for (int i = 0; i < PAGE_CHECKSUM_SIZE; i++)
+		stored |= (uint32_t)(unsigned char)memPage[PAGE_CHECKSUM_OFFSET + i] << (8 * i);
+	return (stored == computeCRC32C(memPage, PAGE_CHECKSUM_OFFSET)) ? RC_OK : RC_CHECKSUM_MISMATCH;
+}
+
+static SM_ChecksumMode checksumMode(SM_FileHandle *fHandle)
+{
+	return (fHandle && fHandle->mgmtInfo) ? ((PageFile *)fHandle->mgmtInfo)->checksumMode : SM_CHECKSUM_NONE;
+}
+
+/**
+*
+* This function selects whether a handle stores checksums in the pages it writes and whether it verifies those of
+* the pages it reads.
+*
+*/
+RC setChecksumMode(SM_FileHandle *fHandle, SM_ChecksumMode mode)
+{
+	if (pageFileDescriptor(fHandle) < 0)
+		return RC_FILE_HANDLE_NOT_INIT;
+	((PageFile *)fHandle->mgmtInfo)->checksumMode = mode;
+	return RC_OK;
+}
+
+/*
+A compressed page file starts with a header page, followed by the indirection map and the slots holding the pages.
+Every page is compressed on its own (lz_codec) into a slot of a multiple of COMPRESSED_SLOT_UNIT bytes; the map has
+one CompressedSlot per page giving where its slot is, how large it is and how many bytes of it the page takes. A
+page that was never written has no slot (length 0) and reads as zeros, one that does not compress to less than
+COMPRESSED_MAX_LENGTH bytes is stored as it is (length PAGE_SIZE). A rewritten page stays in its slot if it fits,
+otherwise it moves to another one and its old slot is kept, by size, for reuse. When the map outgrows its region it
+moves to the end of the file with twice the room. Opening the file loads the map and finds the space not taken by
+the map or a slot, so space freed in earlier sessions is reused too. The header ends with a CRC32C of its fields:
+only the magic together with a matching checksum marks a compressed file, so a plain page file whose first page
+merely starts with the magic is still opened as the plain file it is.
+
+The map is read under a shared latch and changed under an exclusive one, so pages can be read while others are
+written; like for a plain file, writes to a handle come from one thread at a time, and a compressed file is
+written through one handle at a time.
+*/
+#define COMPRESSED_MAGIC "SMLZPGF1"
+#define COMPRESSED_SLOT_UNIT 256
+#define COMPRESSED_SLOT_CLASSES (PAGE_SIZE / COMPRESSED_SLOT_UNIT)
+#define COMPRESSED_MAX_LENGTH (PAGE_SIZE - COMPRESSED_SLOT_UNIT)
+#define COMPRESSED_INITIAL_MAP 1024 // entries; a multiple of 16 so the map region is a multiple of the slot unit
+
+typedef struct CompressedHeader {
+	char magic[8];
+	uint32_t numOfPages;
+	uint32_t mapCapacity;
+	uint64_t mapOffset;
+	uint32_t checksum; // CRC32C of the header up to here
+	uint32_t unused;
+} CompressedHeader;
+
+typedef struct CompressedSlot {
+	uint64_t offset;
+	uint32_t length;   // bytes of the slot the page takes: 0 for a page of zeros, PAGE_SIZE if it is not compressed
+	uint32_t capacity; // bytes of the slot, a multiple of COMPRESSED_SLOT_UNIT
+} CompressedSlot;
+
+typedef struct FreeSlots {
+	uint64_t *offsets;
+	int count;
+	int capacity;
+} FreeSlots;
+
+typedef struct CompressedFile {
+	CompressedSlot *map;
+	int numOfPages;
+	int mapCapacity;
+	uint64_t mapOffset;
+	uint64_t dataEnd; // end of the space taken by the map and the slots
+	FreeSlots freeSlots[COMPRESSED_SLOT_CLASSES]; // free slots of 1 to COMPRESSED_SLOT_CLASSES units
+	pthread_rwlock_t latch;
+} CompressedFile;
+
+static int compareSlots(const void *first, const void *second)
+{
+	uint64_t firstOffset = ((const CompressedSlot *)first)->offset;
+	uint64_t secondOffset = ((const CompressedSlot *)second)->offset;
+	return (firstOffset > secondOffset) - (firstOffset < secondOffset);
+}
+
+/**
+*
+* This function hands the space from offset on, units slot units long, to the free slots, cut into slots of at most
+* COMPRESSED_SLOT_CLASSES units. Space that cannot be remembered for lack of memory is simply not reused.
+*
+*/
+static void releaseSpace(CompressedFile *compressed, uint64_t offset, uint64_t units)
+{
+	while (units > 0)
+	{
+		int slotUnits = (units < COMPRESSED_SLOT_CLASSES) ? (int)units : COMPRESSED_SLOT_CLASSES;
+		FreeSlots *freeSlots = &compressed->freeSlots[slotUnits - 1];
+		if (freeSlots->count == freeSlots->capacity)
+		{
+			int capacity = freeSlots->capacity ? 2 * freeSlots->capacity : 16;
+			uint64_t *offsets = realloc(freeSlots->offsets, capacity * sizeof(uint64_t));
+			if (!offsets)
+				return;
+			freeSlots->offsets = offsets;
+			freeSlots->capacity = capacity;
+		}
+		freeSlots->offsets[freeSlots->count++] = offset;
+		offset += (uint64_t)slotUnits * COMPRESSED_SLOT_UNIT;
+		units -= slotUnits;
+	}
+}
+
+/**
+*
+* This function returns the offset of a slot of the given number of units, a free one if there is one of that size.
+*
+*/
+static uint64_t allocateSlot(CompressedFile *compressed, int units)
+{
+	FreeSlots *freeSlots = &compressed->freeSlots[units - 1];
+	if (freeSlots->count > 0)
+		return freeSlots->offsets[--freeSlots->count];
+	uint64_t offset = compressed->dataEnd;
+	compressed->dataEnd += (uint64_t)units * COMPRESSED_SLOT_UNIT;
+	return offset;
+}
+
+static bool writeAt(int fd, const void *data, size_t length, uint64_t offset)
+{
+	struct iovec iov = { (void *)data, length };
+	return transferPages(fd, &iov, 1, (off_t)offset, true) == (ssize_t)length;
+}
+
+static bool writeCompressedHeader(int fd, CompressedFile *compressed)
+{
+	CompressedHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, COMPRESSED_MAGIC, sizeof(header.magic));
+	header.numOfPages = compressed->numOfPages;
+	header.mapCapacity = compressed->mapCapacity;
+	header.mapOffset = compressed->mapOffset;
+	header.checksum = computeCRC32C((const char *)&header, offsetof(CompressedHeader, checksum));
+	return writeAt(fd, &header, sizeof(header), 0);
+}
 
-FILE *file;
+/**
+*
+* This function loads the header and the map of a compressed page file into loaded. A file that does not start with
+* the magic followed by fields matching their checksum is a plain page file and leaves loaded NULL. A header that does not make sense fails with
+* RC_CORRUPT_PAGE_FILE, a map that cannot be read, or read in full, with RC_READ_FAILED: such a file must not be
+* opened as a plain one, whose first write would overwrite its header and map.
+*
+*/
+static RC loadCompressedFile(int fd, CompressedFile **loaded)
+{
+	*loaded = NULL;
+	CompressedHeader header;
+	struct iovec iov = { &header, sizeof(header) };
+	ssize_t bytes = transferPages(fd, &iov, 1, 0, false);
+	if (bytes < 0)
+		return RC_READ_FAILED;
+	if (bytes != (ssize_t)sizeof(header) || memcmp(header.magic, COMPRESSED_MAGIC, sizeof(header.magic)) != 0
+		|| header.checksum != computeCRC32C((const char *)&header, offsetof(CompressedHeader, checksum)))
+		return RC_OK;
+	if (header.mapOffset < PAGE_SIZE || header.numOfPages > header.mapCapacity || header.mapCapacity > INT_MAX / sizeof(CompressedSlot))
+		return RC_CORRUPT_PAGE_FILE;
+
+	CompressedFile *compressed = calloc(1, sizeof(CompressedFile));
+	CompressedSlot *sorted = malloc((header.numOfPages + 1) * sizeof(CompressedSlot));
+	if (compressed)
+		compressed->map = calloc(header.mapCapacity, sizeof(CompressedSlot));
+	if (!compressed || !compressed->map || !sorted)
+	{
+		if (compressed)
+			free(compressed->map);
+		free(compressed);
+		free(sorted);
+		return RC_FILE_HANDLE_NOT_INIT;
+	}
+	compressed->numOfPages = header.numOfPages;
+	compressed->mapCapacity = header.mapCapacity;
+	compressed->mapOffset = header.mapOffset;
+	iov.iov_base = compressed->map;
+	iov.iov_len = header.numOfPages * sizeof(CompressedSlot);
+	if (transferPages(fd, &iov, 1, (off_t)header.mapOffset, false) != (ssize_t)(header.numOfPages * sizeof(CompressedSlot)))
+	{
+		free(compressed->map);
+		free(compressed);
+		free(sorted);
+		return RC_READ_FAILED;
+	}
+	pthread_rwlock_init(&compressed->latch, NULL);
+
+	// the space between the header, the map and the slots is free
+	int numOfRegions = 0;
+	sorted[numOfRegions].offset = header.mapOffset;
+	sorted[numOfRegions++].capacity = header.mapCapacity * sizeof(CompressedSlot);
+	for (int i = 0; i < compressed->numOfPages; i++)
+		if (compressed->map[i].capacity > 0)
+			sorted[numOfRegions++] = compressed->map[i];
+	qsort(sorted, numOfRegions, sizeof(CompressedSlot), compareSlots);
+	uint64_t end = PAGE_SIZE;
+	for (int i = 0; i < numOfRegions; i++)
+	{
+		if (sorted[i].offset > end)
+			releaseSpace(compressed, end, (sorted[i].offset - end) / COMPRESSED_SLOT_UNIT);
+		if (sorted[i].offset + sorted[i].capacity > end)
+			end = sorted[i].offset + sorted[i].capacity;
+	}
+	compressed->dataEnd = end;
+	free(sorted);
+	*loaded = compressed;
+	return RC_OK;
+}
+
+static void freeCompressedFile(CompressedFile *compressed)
+{
+	for (int i = 0; i < COMPRESSED_SLOT_CLASSES; i++)
+		free(compressed->freeSlots[i].offsets);
+	pthread_rwlock_destroy(&compressed->latch);
+	free(compressed->map);
+	free(compressed);
+}
+
+/**
+*
+* This function makes the map of a compressed file hold numberOfPages pages; new pages have no slot and read as
+* zeros. A map that outgrows its region moves to the end of the file. The caller holds the map latch exclusively.
+*
+*/
+static bool growCompressedFile(int fd, CompressedFile *compressed, int numberOfPages)
+{
+	if (numberOfPages <= compressed->numOfPages)
+		return true;
+
+	if (numberOfPages > compressed->mapCapacity)
+	{
+		int capacity = 2 * compressed->mapCapacity;
+		while (capacity < numberOfPages)
+			capacity *= 2;
+		CompressedSlot *map = realloc(compressed->map, capacity * sizeof(CompressedSlot));
+		if (!map)
+			return false;
+		memset(map + compressed->mapCapacity, 0, (capacity - compressed->mapCapacity) * sizeof(CompressedSlot));
+		compressed->map = map;
+
+		uint64_t oldOffset = compressed->mapOffset;
+		uint64_t oldUnits = (uint64_t)compressed->mapCapacity * sizeof(CompressedSlot) / COMPRESSED_SLOT_UNIT;
+		uint64_t offset = compressed->dataEnd;
+		if (!writeAt(fd, map, compressed->numOfPages * sizeof(CompressedSlot), offset))
+			return false;
+		compressed->dataEnd += (uint64_t)capacity * sizeof(CompressedSlot);
+		compressed->mapOffset = offset;
+		compressed->mapCapacity = capacity;
+		if (!writeCompressedHeader(fd, compressed))
+			return false;
+		releaseSpace(compressed, oldOffset, oldUnits);
+	}
+
+	int oldPages = compressed->numOfPages;
+	memset(compressed->map + oldPages, 0, (numberOfPages - oldPages) * sizeof(CompressedSlot));
+	if (!writeAt(fd, compressed->map + oldPages, (numberOfPages - oldPages) * sizeof(CompressedSlot),
+				 compressed->mapOffset + (uint64_t)oldPages * sizeof(CompressedSlot)))
+		return false;
+	compressed->numOfPages = numberOfPages;
+	return writeCompressedHeader(fd, compressed);
+}
+
+/**
+*
+* This function reads and decompresses one page of a compressed file. It returns PAGE_SIZE, 0 beyond the last page
+* or -errno.
+*
+*/
+static ssize_t readCompressedPage(int fd, CompressedFile *compressed, int pageNum, char *memPage)
+{
+	pthread_rwlock_rdlock(&compressed->latch);
+	bool exists = pageNum < compressed->numOfPages;
+	CompressedSlot slot = exists ? compressed->map[pageNum] : (CompressedSlot){ 0, 0, 0 };
+	pthread_rwlock_unlock(&compressed->latch);
+	if (!exists)
+		return 0;
+
+	if (slot.length == 0)
+	{
+		memset(memPage, 0, PAGE_SIZE);
+		return PAGE_SIZE;
+	}
+	char buffer[PAGE_SIZE];
+	struct iovec iov = { (slot.length == PAGE_SIZE) ? memPage : buffer, slot.length };
+	ssize_t bytes = transferPages(fd, &iov, 1, (off_t)slot.offset, false);
+	if (bytes < 0)
+		return bytes;
+	if (bytes != (ssize_t)slot.length || slot.length > PAGE_SIZE
+		|| (slot.length < PAGE_SIZE && lzDecompress(buffer, slot.length, memPage, PAGE_SIZE) != PAGE_SIZE))
+		return -EIO;
+	return PAGE_SIZE;
+}
+
+/**
+*
+* This function compresses one page and writes it to its slot, moving it to another slot if it no longer fits, and
+* then records the slot in the map. It returns PAGE_SIZE or -errno.
+*
+*/
+static ssize_t writeCompressedPage(int fd, CompressedFile *compressed, int pageNum, const char *memPage)
+{
+	char buffer[COMPRESSED_MAX_LENGTH];
+	int length = lzCompress(memPage, PAGE_SIZE, buffer, COMPRESSED_MAX_LENGTH);
+	const char *data = length ? buffer : memPage;
+	if (!length)
+		length = PAGE_SIZE;
+	int units = (length + COMPRESSED_SLOT_UNIT - 1) / COMPRESSED_SLOT_UNIT;
+
+	pthread_rwlock_wrlock(&compressed->latch);
+	if (!growCompressedFile(fd, compressed, pageNum + 1))
+	{
+		pthread_rwlock_unlock(&compressed->latch);
+		return -EIO;
+	}
+	CompressedSlot slot = compressed->map[pageNum];
+	CompressedSlot outgrown = slot;
+	if (slot.capacity < (uint32_t)units * COMPRESSED_SLOT_UNIT)
+	{
+		slot.offset = allocateSlot(compressed, units);
+		slot.capacity = units * COMPRESSED_SLOT_UNIT;
+	}
+	else
+		outgrown.capacity = 0;
+	slot.length = length;
+	pthread_rwlock_unlock(&compressed->latch);
+
+	if (!writeAt(fd, data, length, slot.offset))
+		return -EIO;
+
+	pthread_rwlock_wrlock(&compressed->latch);
+	compressed->map[pageNum] = slot;
+	bool recorded = writeAt(fd, &slot, sizeof(slot), compressed->mapOffset + (uint64_t)pageNum * sizeof(CompressedSlot));
+	if (outgrown.capacity > 0)
+		releaseSpace(compressed, outgrown.offset, outgrown.capacity / COMPRESSED_SLOT_UNIT);
+	pthread_rwlock_unlock(&compressed->latch);
+	return recorded ? PAGE_SIZE : -EIO;
+}
+
+/**
+*
+* This function reads or writes count consecutive pages from startPage on, like transferPages does for the offsets
+* of a plain file; a compressed file transfers them one page at a time. A read stops at the last page.
+*
+*/
+static ssize_t transferFilePages(PageFile *pageFile, struct iovec *pages, int count, int startPage, bool isWrite)
+{
+	if (!pageFile->compressed)
+		return transferPages(pageFile->fd, pages, count, (off_t)startPage * PAGE_SIZE, isWrite);
+
+	ssize_t total = 0;
+	for (int i = 0; i < count; i++)
+	{
+		ssize_t bytes = isWrite ? writeCompressedPage(pageFile->fd, pageFile->compressed, startPage + i, pages[i].iov_base)
+								: readCompressedPage(pageFile->fd, pageFile->compressed, startPage + i, pages[i].iov_base);
+		if (bytes <= 0)
+			return (total > 0 || bytes == 0) ? total : bytes;
+		total += bytes;
+	}
+	return total;
+}
+
+/*
+A page the handle added to the file (appendEmptyBlock, ensureCapacity) is allocated rather than written and reads as
+zeros without a checksum until it is written. blankPages has a bit for each such page, cleared as soon as a write of
+the page is issued, so that a page of zeros only passes verification if it is known never to have been written; a
+written page that reads as zeros was lost or torn. Pages the file had when the handle opened it count as written. A
+compressed file knows for itself: a page that holds no data has no slot in its map.
+*/
+static void markBlankPages(PageFile *pageFile, int from, int to, bool blank)
+{
+	pthread_mutex_lock(&pageFile->blankLatch);
+	if (blank && to > pageFile->blankCapacity)
+	{
+		int capacity = (to > 2 * pageFile->blankCapacity) ? to : 2 * pageFile->blankCapacity;
+		unsigned char *blankPages = realloc(pageFile->blankPages, (size_t)(capacity + 7) / 8);
+		if (blankPages) // without the room the pages count as written, which only makes verification stricter
+		{
+			memset(blankPages + (pageFile->blankCapacity + 7) / 8, 0, (size_t)(capacity + 7) / 8 - (pageFile->blankCapacity + 7) / 8);
+			pageFile->blankPages = blankPages;
+			pageFile->blankCapacity = capacity;
+		}
+	}
+	if (to > pageFile->blankCapacity)
+		to = pageFile->blankCapacity;
+	for (int pageNum = from; pageNum < to; pageNum++)
+	{
+		if (blank)
+			pageFile->blankPages[pageNum / 8] |= (unsigned char)(1 << (pageNum % 8));
+		else
+			pageFile->blankPages[pageNum / 8] &= (unsigned char)~(1 << (pageNum % 8));
+	}
+	pthread_mutex_unlock(&pageFile->blankLatch);
+}
+
+static bool isBlankPage(SM_FileHandle *fHandle, int pageNum)
+{
+	PageFile *pageFile = fHandle->mgmtInfo;
+	if (pageNum >= pageCount(fHandle))
+		return true;
+	if (pageFile->compressed)
+	{
+		pthread_rwlock_rdlock(&pageFile->compressed->latch);
+		bool blank = pageNum < pageFile->compressed->numOfPages && pageFile->compressed->map[pageNum].length == 0;
+		pthread_rwlock_unlock(&pageFile->compressed->latch);
+		return blank;
+	}
+	pthread_mutex_lock(&pageFile->blankLatch);
+	bool blank = pageNum < pageFile->blankCapacity && (pageFile->blankPages[pageNum / 8] & (1 << (pageNum % 8)));
+	pthread_mutex_unlock(&pageFile->blankLatch);
+	return blank;
+}
+
+/**
+*
+* This function checks page pageNum of a file as read into memPage: its checksum has to match, unless the page is
+* all zeros and the file never wrote it (see isBlankPage), or it lies beyond the end of the file.
+*
+*/
+RC verifyPage(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
+{
+	if (verifyBlock(memPage) == RC_OK)
+		return RC_OK;
+	if (pageFileDescriptor(fHandle) < 0)
+		return RC_FILE_HANDLE_NOT_INIT;
+
+	int i = 0;
+	while (i < PAGE_SIZE && memPage[i] == 0)
+		i++;
+	return (i == PAGE_SIZE && isBlankPage(fHandle, pageNum)) ? RC_OK : RC_CHECKSUM_MISMATCH;
+}
 
 // Here we are initializing the Storage manager
 void initStorageManager(void)
@@ -36,60 +733,102 @@ void initStorageManager(void)
 
 /**
 *
-*  This function creates a page file, that file is opened in write mode "w+",
-*  If the file is successfully opened, a block of memory with PAGE_SIZE is
-*  allocated and initialized with the null character. The block is then
-*  written to the file using fwrite. Finally, the memory is freed and the
-*  file is closed. If the file can not be opened, the function returns the
-*  error code as RC_FILE_NOT_FOUND.
+*  This function creates a page file. The file is created (or truncated) and
+*  opened for reading and writing, a block of memory with PAGE_SIZE is
+*  allocated and initialized with the null character and written to the
+*  file as its first page. Finally, the memory is freed and the file is
+*  closed. If the file can not be opened, the function returns the error
+*  code as RC_FILE_NOT_FOUND.
 *
 */
 RC createPageFile(char *fName)
 {
-	file = fopen(fName, "w+");
-	if (file)
+	int fd = open(fName, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd >= 0)
 	{
-		char *emptyBlock = malloc(PAGE_SIZE * sizeof(char));
-		memset(emptyBlock, '\0', PAGE_SIZE);
-		fwrite(emptyBlock, sizeof(char), PAGE_SIZE, file);
+		char *emptyBlock = calloc(PAGE_SIZE, sizeof(char));
+		bool written = emptyBlock && pwrite(fd, emptyBlock, PAGE_SIZE, 0) == PAGE_SIZE;
 		free(emptyBlock);
-		printf("\ncreatePageFile() Executed successfully!\n");
-		fclose(file);
+		close(fd);
+		if (!written)
+		{
+			TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_CREATE_FILE, RC_WRITE_FAILED, 0, 0);
+			return RC_WRITE_FAILED;
+		}
+		TRACE_EVENT(TRACE_LEVEL_INFO, TRACE_CREATE_FILE, RC_OK, 0, 0);
 		return RC_OK;
 	}
-    printf("\nDesired file can not be accessed due to an Error!!!\n");
-    printf("\nERROR CODE : RC_FILE_NOT_FOUND\n");
-
+	TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_CREATE_FILE, RC_FILE_NOT_FOUND, 0, 0);
 	return RC_FILE_NOT_FOUND;
 }
 
 /**
 *
-* This function opens the desired Page File with the name as fName.
+* This function creates a compressed page file holding one empty page. Once created it is opened and used like any
+* other page file; openPageFile recognizes the format by its header.
 *
 */
-RC openPageFile(char *fName, SM_FileHandle *fHandle)
+RC createCompressedPageFile(char *fName)
 {
-	file = fopen(fName, "r+");
-	if (file)
+	int fd = open(fName, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
 	{
-		fseek(file, 0, SEEK_END); //moving the file pointer to end of the file
-		int lastByte = ftell(file); //assigning the current pointer of the file to the lastByte
-		int fileLength = lastByte + 1; //calculating the total length of the file
-		int nPages = fileLength / PAGE_SIZE;
+		TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_CREATE_FILE, RC_FILE_NOT_FOUND, 1, 0);
+		return RC_FILE_NOT_FOUND;
+	}
+
+	CompressedFile compressed;
+	memset(&compressed, 0, sizeof(compressed));
+	compressed.numOfPages = 1;
+	compressed.mapCapacity = COMPRESSED_INITIAL_MAP;
+	compressed.mapOffset = PAGE_SIZE;
+	char *empty = calloc(PAGE_SIZE + COMPRESSED_INITIAL_MAP * sizeof(CompressedSlot), sizeof(char));
+	bool written = empty && writeAt(fd, empty, PAGE_SIZE + COMPRESSED_INITIAL_MAP * sizeof(CompressedSlot), 0)
+		&& writeCompressedHeader(fd, &compressed);
+	free(empty);
+	close(fd);
+	TRACE_EVENT(written ? TRACE_LEVEL_INFO : TRACE_LEVEL_ERROR, TRACE_CREATE_FILE, written ? RC_OK : RC_WRITE_FAILED, 1, 0);
+	return written ? RC_OK : RC_WRITE_FAILED;
+}
 
+/**
+*
+* This function opens the desired Page File with the name as fName. Each handle gets a descriptor of its own, kept
+* in a PageFile that mgmtInfo points to, so several page files (or the same one several times) can be open at the
+* same time. The number of pages follows from the size of the file, or from the header of a compressed file. A
+* compressed file whose header or map cannot be loaded is not opened; the error of loadCompressedFile is returned.
+*
+*/
+RC openPageFile(char *fName, SM_FileHandle *fHandle)
+{
+	int fd = open(fName, O_RDWR);
+	PageFile *pageFile = (fd >= 0) ? malloc(sizeof(PageFile)) : NULL;
+	struct stat fileStat;
+	RC rc = RC_FILE_NOT_FOUND;
+	if (pageFile && fstat(fd, &fileStat) == 0)
+	{
+		memset(pageFile, 0, sizeof(PageFile));
+		rc = loadCompressedFile(fd, &pageFile->compressed);
+	}
+	if (rc == RC_OK)
+	{
+		pageFile->fd = fd;
+		pthread_mutex_init(&pageFile->mapLatch, NULL);
+		pthread_mutex_init(&pageFile->blankLatch, NULL);
 		fHandle->fileName = fName;
-		fHandle->totalNumPages = nPages;
+		fHandle->totalNumPages = pageFile->compressed ? pageFile->compressed->numOfPages : fileStat.st_size / PAGE_SIZE;
+		pageFile->reservedPages = fHandle->totalNumPages;
 		fHandle->curPagePos = 0;
+		fHandle->mgmtInfo = pageFile;
 
-		rewind(file); // Moving the file pointer back to the beginning of the file
-		printf("\nopenPageFile() Executed successfully!\n");
+		TRACE_EVENT(TRACE_LEVEL_INFO, TRACE_OPEN_FILE, RC_OK, fHandle->totalNumPages, 0);
 		return RC_OK;
 	}
-    printf("\nDesired file can not be accesses due to an Error!!!\n");
-    printf("\nERROR CODE : RC_FILE_NOT_FOUND\n");
-
-	return RC_FILE_NOT_FOUND;
+	free(pageFile);
+	if (fd >= 0)
+		close(fd);
+	TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_OPEN_FILE, rc, 0, 0);
+	return rc;
 }
 
 /**
@@ -99,29 +838,37 @@ RC openPageFile(char *fName, SM_FileHandle *fHandle)
 */
 RC closePageFile(SM_FileHandle *fHandle)
 {
-	RC fileOpenCloseFlag = fclose(file);
-    file = NULL;
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+	PageFile *pageFile = fHandle->mgmtInfo;
+	unmapPageFile(fHandle);
+	if (pageFile->compressed)
+		freeCompressedFile(pageFile->compressed);
+	RC fileOpenCloseFlag = close(pageFile->fd);
+	pthread_mutex_destroy(&pageFile->mapLatch);
+	pthread_mutex_destroy(&pageFile->blankLatch);
+	free(pageFile->blankPages);
+	free(pageFile);
+    fHandle->mgmtInfo = NULL;
 	return (fileOpenCloseFlag == 0) ? RC_OK : RC_FAILED_CLOSE;
 }
 
 /**
 *
-* This function distroys the page file associated with the file name fileName
+* This function distroys the page file associated with the file name fileName. Handles are
+* independent of each other, so callers are responsible for closing theirs first.
 *
 */
 RC destroyPageFile(char *fileName)
 {
-    if(file == NULL){
-        return (remove(fileName) == 0) ? RC_OK : RC_FAILED_REMOVAL;
-    }
-    printf("File can only be destroyed if it is CLOSED");
-    return RC_FILE_NOT_CLOSED;
-	
+    return (remove(fileName) == 0) ? RC_OK : RC_FAILED_REMOVAL;
 }
 
 /**
 *
-* This function reads the block associated with the SM_FileHandle fHandle
+* This function reads the block associated with the SM_FileHandle fHandle. The page is read at its offset, so
+* several threads may read pages of the same handle at once. A mapped handle copies the page from the mapping.
 *
 */
 RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
@@ -130,19 +877,36 @@ RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
         return RC_FILE_NOT_FOUND;
     }
 
-	if (fHandle->totalNumPages < pageNum) //If page number is out of range, it will throw an error
+	if (pageNum < 0 || pageCount(fHandle) < pageNum) //If page number is out of range, it will throw an error
 	{
-        // printf("\nThere is an Error in reading a Block!!!\n");
-        // printf("\nERROR CODE : RC_READ_NON_EXISTING_PAGE\n");  
+		TRACE_EVENT(TRACE_LEVEL_WARN, TRACE_READ_BLOCK, pageNum, RC_READ_NON_EXISTING_PAGE, 0);
 		return RC_READ_NON_EXISTING_PAGE;
 	}
-    if(file){
-        fseek(file, pageNum * PAGE_SIZE, SEEK_SET);
-	    fread(memPage, sizeof(char), PAGE_SIZE, file); //reading the stream from file and to memPage
-	    fHandle->curPagePos = pageNum; //updating the current page position to page number
-        printf("\nRead operation completed successfully for the desired block!\n");
+    int fd = pageFileDescriptor(fHandle);
+    if(fd >= 0){
+        LATENCY_START(start);
+        SM_PageHandle mappedPage;
+        if (getMappedBlock(pageNum, fHandle, &mappedPage) == RC_OK) {
+            memcpy(memPage, mappedPage, PAGE_SIZE); // a mapped handle copies the page without a system call
+        } else {
+            struct iovec page = { memPage, PAGE_SIZE };
+            ssize_t bytes = transferFilePages(fHandle->mgmtInfo, &page, 1, pageNum, false);
+            if (bytes < 0) {
+                TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_READ_BLOCK, pageNum, RC_READ_FAILED, 0);
+                return RC_READ_FAILED;
+            }
+            memset(memPage + bytes, 0, PAGE_SIZE - bytes); // the part of the page beyond the end of the file reads as zeros
+        }
+	    setPagePos(fHandle, pageNum); //updating the current page position to page number
+        LATENCY_RECORD(LATENCY_READ_BLOCK, start);
+        if (checksumMode(fHandle) == SM_CHECKSUM_VERIFY && verifyPage(pageNum, fHandle, memPage) != RC_OK) {
+            TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_READ_BLOCK, pageNum, RC_CHECKSUM_MISMATCH, 0);
+            return RC_CHECKSUM_MISMATCH;
+        }
+        TRACE_EVENT(TRACE_LEVEL_DEBUG, TRACE_READ_BLOCK, pageNum, RC_OK, 0);
         return RC_OK;
     }
+    TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_READ_BLOCK, pageNum, RC_FILE_NOT_OPENED, 0);
     return RC_FILE_NOT_OPENED;
 }
 
@@ -153,8 +917,9 @@ RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 */
 int getBlockPos(SM_FileHandle *fHandle)
 {
-    printf("\nCurrent position of the block returned successfully!\n");
-	return fHandle?(fHandle->curPagePos):RC_FILE_NOT_FOUND;
+	int pagePos = fHandle?(fHandle->curPagePos):RC_FILE_NOT_FOUND;
+	TRACE_EVENT(TRACE_LEVEL_DEBUG, TRACE_GET_BLOCK_POS, pagePos, 0, 0);
+	return pagePos;
 }
 
 /**
@@ -181,15 +946,11 @@ RC readPreviousBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
 		previousBlockPosition = fHandle->curPagePos - 1;
 
 		if (previousBlockPosition < 0){
-            printf("\nPosition of the previous block can not be accessed due to an Error!!!\n");
-            printf("\nERROR CODE : RC_READ_NON_EXISTING_PAGE\n");
+			TRACE_EVENT(TRACE_LEVEL_WARN, TRACE_READ_BLOCK, previousBlockPosition, RC_READ_NON_EXISTING_PAGE, 0);
 			return RC_READ_NON_EXISTING_PAGE;
 		}
-        printf("\nRead operation completed successfully for the previous block!\n");
 		return readBlock(previousBlockPosition, fHandle, memPage);
 	}
-    printf("\nRead operation can not be completed due to an Error!!!\n");
-    printf("\nERROR CODE : RC_FILE_NOT_FOUND\n");
 	return RC_FILE_NOT_FOUND;
 }
 
@@ -206,11 +967,8 @@ RC readCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
 	if (fHandle){
 		RC currentBlockPosition = getBlockPos(fHandle);
 		readBlock(currentBlockPosition, fHandle, memPage);
-        printf("\nRead operation completed successfully for the current block!\n");
 		return RC_OK;
 	}
-    printf("\nRead operation can not be completed due to an Error!!!\n");
-    printf("\nERROR CODE : RC_FILE_HANDLE_NOT_INIT\n");
 	return RC_FILE_HANDLE_NOT_INIT;
 }
 
@@ -223,11 +981,8 @@ RC readNextBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
 	if (fHandle){
 		RC nextBlockPosition = fHandle->curPagePos + 1;
-        printf("\nRead operation completed successfully for the previous block!\n");
 		return readBlock(nextBlockPosition, fHandle, memPage);
 	}
-    printf("\nRead operation can not be completed due to an Error!!!\n");
-    printf("\nERROR CODE : RC_FILE_HANDLE_NOT_INIT\n");
 	return RC_FILE_HANDLE_NOT_INIT;
 }
 
@@ -242,110 +997,960 @@ RC readLastBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
 
 	if (fHandle){
 		RC endBlockPosition = fHandle->totalNumPages - 1;
-        printf("\nRead operation completed successfully for the previous block!\n");
 		return readBlock(endBlockPosition, fHandle, memPage);
 	}
-    printf("\nRead operation can not be completed due to an Error!!!\n");
-    printf("\nERROR CODE : RC_FILE_NOT_FOUND\n");
 	return RC_FILE_NOT_FOUND;
 }
 
 /**
 *
-* This function writes stream of data to the 'file'
+* This function writes stream of data to the 'file'. Writing the page right after the last one
+* extends the file by that page, so the number of pages is known without seeking to the end.
+* A checksum is stamped into a copy of the page, so memPage is not modified.
 *
 */
 RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
 	if (pageNum < 0 || pageNum > fHandle->totalNumPages) //If page number is not within a valid range it will throw an error
-        {
-        printf("\nWriting failed due to an error!!!\n");
-        printf("\nERROR CODE : RC_INVALID_PAGE_RANGE\n");
+	{
+		TRACE_EVENT(TRACE_LEVEL_WARN, TRACE_WRITE_BLOCK, pageNum, RC_INVALID_PAGE_RANGE, 0);
 		return RC_INVALID_PAGE_RANGE;
-        }
+	}
 
-	if (file)
+	int fd = pageFileDescriptor(fHandle);
+	if (fd >= 0)
 	{
-		bool isFailed = fseek(file, (PAGE_SIZE * pageNum), SEEK_SET);
-		if (!isFailed)
+		LATENCY_START(start);
+		if (pageNum == fHandle->totalNumPages)
+			reserveGrowth(fHandle, pageNum + 1);
+		char stamped[PAGE_SIZE];
+		struct iovec page = { memPage, PAGE_SIZE };
+		if (checksumMode(fHandle) != SM_CHECKSUM_NONE)
 		{
-			fwrite(memPage, sizeof(char), PAGE_SIZE, file); //It will write the stream into 'file' from memePage
-			fHandle->curPagePos = pageNum;
-			fseek(file, 0, SEEK_END);
-			fHandle->totalNumPages = ftell(file) / PAGE_SIZE;
-            printf("\nWrite operation completed successfully for desired block!\n");
-			return RC_OK;
+			memcpy(stamped, memPage, PAGE_SIZE); // a page that changes while it is written cannot outdate its checksum
+			stampChecksum(stamped);
+			page.iov_base = stamped;
 		}
-        printf("\nWriting failed due to an error!!!\n");
-        printf("\nERROR CODE : RC_WRITE_FAILED\n");
-		return RC_WRITE_FAILED;
-
+		markBlankPages(fHandle->mgmtInfo, pageNum, pageNum + 1, false);
+		if (transferFilePages(fHandle->mgmtInfo, &page, 1, pageNum, true) != PAGE_SIZE) //It will write the page into the file from memPage
+		{
+			TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_WRITE_BLOCK, pageNum, RC_WRITE_FAILED, 0);
+			return RC_WRITE_FAILED;
+		}
+		setPagePos(fHandle, pageNum);
+		if (pageNum == fHandle->totalNumPages)
+			setPageCount(fHandle, pageNum + 1);
+		LATENCY_RECORD(LATENCY_WRITE_BLOCK, start);
+		TRACE_EVENT(TRACE_LEVEL_DEBUG, TRACE_WRITE_BLOCK, pageNum, RC_OK, 0);
+		return RC_OK;
 	}
-    printf("\nRead operation can not be completed due to an Error!!!\n");
-    printf("\nERROR CODE : RC_FILE_NOT_OPENED\n");
+	TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_WRITE_BLOCK, pageNum, RC_FILE_NOT_OPENED, 0);
 	return RC_FILE_NOT_OPENED;
 }
 
 /**
 *
-* This function writes stream of data to the 'file' into the current block
+* This function reads count consecutive pages, starting at startPage, into the buffers in memPages with vectored
+* reads (preadv), so a run of adjacent pages lands in as many separate buffers (frames, say) with one system call.
+* All pages must exist. A mapped handle copies the pages from the mapping instead.
 *
 */
-RC writeCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
+RC readBlocks(int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *memPages)
 {
-	RC currentBlockPosition = getBlockPos(fHandle); //For writing into current block it will get the current posotion of the block
-	return writeBlock(currentBlockPosition, fHandle, memPage); //It will just call writeBlock() with target position as current block position
-}
+	if (fHandle == NULL)
+		return RC_FILE_NOT_FOUND;
+	if (startPage < 0 || count < 0 || startPage > pageCount(fHandle) - count)
+	{
+		TRACE_EVENT(TRACE_LEVEL_WARN, TRACE_READ_BLOCKS, startPage, count, RC_READ_NON_EXISTING_PAGE);
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+
+	int fd = pageFileDescriptor(fHandle);
+	if (fd < 0)
+		return RC_FILE_NOT_OPENED;
+
+	LATENCY_START(start);
+	SM_PageHandle mappedPage, firstPage;
+	if (count > 0 && getMappedBlock(startPage + count - 1, fHandle, &mappedPage) == RC_OK
+		&& getMappedBlock(startPage, fHandle, &firstPage) == RC_OK)
+	{
+		for (int i = 0; i < count; i++) // the mapping is contiguous, so the run is mapped if its last page is
+			memcpy(memPages[i], firstPage + (size_t)i * PAGE_SIZE, PAGE_SIZE);
+	}
+	else
+	{
+		struct iovec iov[IOV_MAX];
+		int read = 0;
+		while (read < count)
+		{
+			int batch = (count - read < IOV_MAX) ? count - read : IOV_MAX;
+			for (int i = 0; i < batch; i++)
+			{
+				iov[i].iov_base = memPages[read + i];
+				iov[i].iov_len = PAGE_SIZE;
+			}
+			ssize_t bytes = transferFilePages(fHandle->mgmtInfo, iov, batch, startPage + read, false);
+			if (bytes < 0)
+			{
+				TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_READ_BLOCKS, startPage, count, RC_READ_FAILED);
+				return RC_READ_FAILED;
+			}
+			for (int i = bytes / PAGE_SIZE; i < batch; i++) // the part of a page beyond the end of the file reads as zeros
+			{
+				int from = (i == bytes / PAGE_SIZE) ? bytes % PAGE_SIZE : 0;
+				memset(memPages[read + i] + from, 0, PAGE_SIZE - from);
+			}
+			read += batch;
+		}
+	}
+
+	if (count > 0)
+		setPagePos(fHandle, startPage + count - 1);
+	LATENCY_RECORD(LATENCY_READ_BLOCK, start);
+	for (int i = 0; i < count && checksumMode(fHandle) == SM_CHECKSUM_VERIFY; i++)
+	{
+		if (verifyPage(startPage + i, fHandle, memPages[i]) != RC_OK)
+		{
+			TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_READ_BLOCKS, startPage + i, count, RC_CHECKSUM_MISMATCH);
+			return RC_CHECKSUM_MISMATCH;
+		}
+	}
+	TRACE_EVENT(TRACE_LEVEL_DEBUG, TRACE_READ_BLOCKS, startPage, count, RC_OK);
+	return RC_OK;
+}
+
+/**
+*
+* This function writes count consecutive pages, starting at startPage, from the buffers in memPages with vectored
+* writes (pwritev), so a run of adjacent pages costs one system call instead of a seek and a write per page. Like
+* writeBlock it may extend the file, but only if the run starts at or before its end, and it stamps checksums into
+* copies of the pages.
+*
+*/
+RC writeBlocks(int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *memPages)
+{
+	if (startPage < 0 || count < 0 || startPage > fHandle->totalNumPages)
+		return RC_INVALID_PAGE_RANGE;
+
+	int fd = pageFileDescriptor(fHandle);
+	if (fd < 0)
+		return RC_FILE_NOT_OPENED;
+
+	LATENCY_START(start);
+	char *stamped = NULL;
+	if (checksumMode(fHandle) != SM_CHECKSUM_NONE && count > 0)
+	{
+		stamped = malloc((size_t)((count < IOV_MAX) ? count : IOV_MAX) * PAGE_SIZE);
+		if (!stamped)
+		{
+			TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_WRITE_BLOCKS, startPage, count, RC_WRITE_FAILED);
+			return RC_WRITE_FAILED;
+		}
+	}
+	if (startPage + count > fHandle->totalNumPages)
+		reserveGrowth(fHandle, startPage + count);
+	markBlankPages(fHandle->mgmtInfo, startPage, startPage + count, false);
+	struct iovec iov[IOV_MAX];
+	int written = 0;
+	while (written < count)
+	{
+		int batch = (count - written < IOV_MAX) ? count - written : IOV_MAX;
+		for (int i = 0; i < batch; i++)
+		{
+			iov[i].iov_base = memPages[written + i];
+			iov[i].iov_len = PAGE_SIZE;
+			if (stamped)
+			{
+				iov[i].iov_base = stamped + (size_t)i * PAGE_SIZE;
+				memcpy(iov[i].iov_base, memPages[written + i], PAGE_SIZE);
+				stampChecksum(iov[i].iov_base);
+			}
+		}
+		if (transferFilePages(fHandle->mgmtInfo, iov, batch, startPage + written, true) != (ssize_t)batch * PAGE_SIZE)
+		{
+			free(stamped);
+			TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_WRITE_BLOCKS, startPage, count, RC_WRITE_FAILED);
+			return RC_WRITE_FAILED;
+		}
+		written += batch;
+	}
+	free(stamped);
+
+	if (count > 0)
+		setPagePos(fHandle, startPage + count - 1);
+	if (startPage + count > fHandle->totalNumPages)
+		setPageCount(fHandle, startPage + count);
+	LATENCY_RECORD(LATENCY_WRITE_BLOCK, start);
+	TRACE_EVENT(TRACE_LEVEL_DEBUG, TRACE_WRITE_BLOCKS, startPage, count, RC_OK);
+	return RC_OK;
+}
 
 /**
 *
-* This function appends an empty block after given block location
+* This function writes stream of data to the 'file' into the current block
+*
+*/
+RC writeCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage)
+{
+	RC currentBlockPosition = getBlockPos(fHandle); //For writing into current block it will get the current posotion of the block
+	return writeBlock(currentBlockPosition, fHandle, memPage); //It will just call writeBlock() with target position as current block position
+}
+
+/**
+*
+* This function makes the file numberOfPages pages long with one call: posix_fallocate allocates the new pages, which
+* read as zeros, and where the file system does not support that ftruncate extends the file sparsely. A compressed
+* file only adds empty entries to its map.
+*
+*/
+static RC extendPageFile(SM_FileHandle *fHandle, int numberOfPages)
+{
+	PageFile *pageFile = fHandle->mgmtInfo;
+	int total = pageCount(fHandle);
+	if (numberOfPages <= total)
+		return RC_OK;
+
+	if (pageFile->compressed)
+	{
+		pthread_rwlock_wrlock(&pageFile->compressed->latch);
+		bool grown = growCompressedFile(pageFile->fd, pageFile->compressed, numberOfPages);
+		pthread_rwlock_unlock(&pageFile->compressed->latch);
+		if (!grown)
+			return RC_WRITE_FAILED;
+		setPageCount(fHandle, numberOfPages);
+		return RC_OK;
+	}
+
+	reserveGrowth(fHandle, numberOfPages);
+	int error = posix_fallocate(pageFile->fd, (off_t)total * PAGE_SIZE, (off_t)(numberOfPages - total) * PAGE_SIZE);
+	if (error == EINVAL || error == EOPNOTSUPP)
+		error = (ftruncate(pageFile->fd, (off_t)numberOfPages * PAGE_SIZE) == 0) ? 0 : errno;
+	if (error != 0)
+		return RC_WRITE_FAILED;
+	if (numberOfPages > pageFile->reservedPages)
+		pageFile->reservedPages = numberOfPages;
+	markBlankPages(pageFile, total, numberOfPages, true);
+	setPageCount(fHandle, numberOfPages);
+	return RC_OK;
+}
+
+/**
+*
+* This function appends an empty block at the end of the file and makes it the current block. The block is allocated
+* rather than written, so appending costs no 4 KB write.
 *
 */
 RC appendEmptyBlock(SM_FileHandle *fHandle)
 {
+	int fd = pageFileDescriptor(fHandle);
 
-	if (file)
+	if (fd >= 0)
 	{
-		char *newBlock = (char *)calloc(PAGE_SIZE, sizeof(char)); //creating a new block and allocating the memory
-		fseek(file, 0, SEEK_END);
-		if (fwrite(newBlock, 1, PAGE_SIZE, file) == PAGE_SIZE)
+		int pageNum = pageCount(fHandle);
+		if (extendPageFile(fHandle, pageNum + 1) == RC_OK)
 		{
-			(*fHandle).totalNumPages = ftell(file) / PAGE_SIZE; //updating the total number of pages
-			(*fHandle).curPagePos = fHandle->totalNumPages - 1; //setting the current page position
-            free(newBlock);
-            printf("\nAppended an empty block successfully!\n");
+			setPagePos(fHandle, pageNum); //setting the current page position
+			TRACE_EVENT(TRACE_LEVEL_DEBUG, TRACE_APPEND_BLOCK, pageNum, RC_OK, 0);
 			return RC_OK;
 		}
-        printf("\nAn empty block can not be appended due to an Error!!!\n");
-        printf("\nERROR CODE : RC_WRITE_FAILED\n");
+		TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_APPEND_BLOCK, pageNum, RC_WRITE_FAILED, 0);
 		return RC_WRITE_FAILED;	
 	}
-    printf("\nAn empty block can not be appended due to an Error!!!\n");
-    printf("\nERROR CODE : RC_FILE_NOT_FOUND\n");
+	TRACE_EVENT(TRACE_LEVEL_ERROR, TRACE_APPEND_BLOCK, -1, RC_FILE_NOT_FOUND, 0);
 	return RC_FILE_NOT_FOUND; //it will throw an error if file is not accessible
 	
 }
 
 /**
 *
-* This function ensures if total number of pages are greater than the required number of pages, else add more pages
+* This function makes sure the file has at least numberOfPages pages, extending it with a single preallocation if it
+* is shorter. A file that is long enough is left alone.
 *
 */
 RC ensureCapacity(int numberOfPages, SM_FileHandle *fHandle)
 {
-	int pageIndex = (*fHandle).totalNumPages; //getting the total number of pages as a current page index
-	if (numberOfPages > pageIndex) 
+	if (pageFileDescriptor(fHandle) < 0)
+		return RC_FILE_NOT_FOUND;
+
+	RC rc = extendPageFile(fHandle, numberOfPages);
+	TRACE_EVENT((rc == RC_OK) ? TRACE_LEVEL_DEBUG : TRACE_LEVEL_ERROR, TRACE_ENSURE_CAPACITY, numberOfPages, pageCount(fHandle), rc);
+	return rc;
+}
+
+/**
+*
+* This function selects how the file grows when pages are appended or written beyond its end (see reserveGrowth).
+*
+*/
+RC setGrowthPolicy(SM_FileHandle *fHandle, SM_GrowthPolicy policy)
+{
+	if (pageFileDescriptor(fHandle) < 0)
+		return RC_FILE_HANDLE_NOT_INIT;
+	((PageFile *)fHandle->mgmtInfo)->growthPolicy = policy;
+	return RC_OK;
+}
+
+/*
+A mapped handle maps the page file read-only (MAP_SHARED) into a range of address space reserved when it is mapped,
+so the mapping can grow with the file without moving: pages handed out by getMappedBlock stay valid until the
+handle is unmapped. Only pages that exist in the file are mapped, since touching a mapped page beyond the end of the
+file raises SIGBUS. Writes still go through the descriptor; the mapping shares the page cache and sees them.
+*/
+
+/**
+*
+* This function maps the pages of the file up to numOfPages into the reserved range, as far as the file and the
+* reservation reach, and returns whether the first numOfPages pages are mapped now.
+*
+*/
+static bool growMapping(PageFile *pageFile, int numOfPages)
+{
+	if (__atomic_load_n(&pageFile->mappedPages, __ATOMIC_ACQUIRE) >= numOfPages)
+		return true;
+
+	pthread_mutex_lock(&pageFile->mapLatch);
+	int mapped = pageFile->mappedPages;
+	struct stat fileStat;
+	if (mapped < numOfPages && fstat(pageFile->fd, &fileStat) == 0)
 	{
-		int morePage = numberOfPages - pageIndex;
-		while (morePage > 0) //it will append empty blocks until file reaches its required capacity
+		long long available = fileStat.st_size / PAGE_SIZE;
+		long long reserved = pageFile->mapReserved / PAGE_SIZE;
+		int target = (int)((available < reserved) ? available : reserved);
+		if (target > mapped)
 		{
-			appendEmptyBlock(fHandle);
-			morePage--;
+			char *start = pageFile->map + (size_t)mapped * PAGE_SIZE;
+			size_t length = (size_t)(target - mapped) * PAGE_SIZE;
+			if (mmap(start, length, PROT_READ, MAP_SHARED | MAP_FIXED, pageFile->fd, (off_t)mapped * PAGE_SIZE) != MAP_FAILED)
+			{
+				madvise(start, length, pageFile->advice);
+				mapped = target;
+				__atomic_store_n(&pageFile->mappedPages, mapped, __ATOMIC_RELEASE);
+			}
 		}
+	}
+	pthread_mutex_unlock(&pageFile->mapLatch);
+	return mapped >= numOfPages;
+}
+
+/**
+*
+* This function maps the page file of a handle into memory. Afterwards readBlock copies pages from the mapping and
+* getMappedBlock hands out pointers into it. It fails with RC_MAP_FAILED if the file cannot be mapped, e.g. because
+* PAGE_SIZE is not a multiple of the system page size. No other thread may use the handle meanwhile.
+*
+*/
+RC mapPageFile(SM_FileHandle *fHandle)
+{
+	PageFile *pageFile = fHandle ? fHandle->mgmtInfo : NULL;
+	if (!pageFile)
+		return RC_FILE_NOT_OPENED;
+	if (pageFile->map)
 		return RC_OK;
+	if (pageFile->compressed)
+		return RC_MAP_FAILED; // its pages are not where a mapping could show them
+
+	long systemPage = sysconf(_SC_PAGESIZE);
+	if (systemPage <= 0 || PAGE_SIZE % systemPage != 0)
+		return RC_MAP_FAILED;
+
+	size_t reserve = (size_t)fHandle->totalNumPages * PAGE_SIZE * MAP_RESERVE_FACTOR;
+	if (reserve < MAP_MIN_RESERVE)
+		reserve = MAP_MIN_RESERVE;
+	char *map = mmap(NULL, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (map == MAP_FAILED)
+		return RC_MAP_FAILED;
+
+	pageFile->map = map;
+	pageFile->mapReserved = reserve;
+	pageFile->mappedPages = 0;
+	if (!growMapping(pageFile, fHandle->totalNumPages))
+	{
+		munmap(map, reserve);
+		pageFile->map = NULL;
+		return RC_MAP_FAILED;
+	}
+	return RC_OK;
+}
+
+/**
+*
+* This function removes the mapping of a handle; pointers handed out by getMappedBlock become invalid. Unmapping a
+* handle that is not mapped does nothing.
+*
+*/
+RC unmapPageFile(SM_FileHandle *fHandle)
+{
+	PageFile *pageFile = fHandle ? fHandle->mgmtInfo : NULL;
+	if (!pageFile)
+		return RC_FILE_NOT_OPENED;
+	if (pageFile->map)
+	{
+		munmap(pageFile->map, pageFile->mapReserved);
+		pageFile->map = NULL;
+		pageFile->mapReserved = 0;
+		pageFile->mappedPages = 0;
+	}
+	return RC_OK;
+}
+
+/**
+*
+* This function points page at a page of a mapped handle, without copying it. The memory is read-only and stays
+* valid until the handle is unmapped or closed; later writes to the page show through it. It fails if the handle is
+* not mapped or the page does not exist (yet) in the file.
+*
+*/
+RC getMappedBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle *page)
+{
+	PageFile *pageFile = fHandle ? fHandle->mgmtInfo : NULL;
+	if (!pageFile || !pageFile->map)
+		return RC_FILE_NOT_OPENED;
+	if (pageNum < 0 || pageNum >= pageCount(fHandle) || !growMapping(pageFile, pageNum + 1))
+		return RC_READ_NON_EXISTING_PAGE;
+
+	*page = pageFile->map + (size_t)pageNum * PAGE_SIZE;
+	setPagePos(fHandle, pageNum);
+	return RC_OK;
+}
+
+/**
+*
+* This function tells whether page points into the mapping of a handle, i.e. was handed out by getMappedBlock.
+*
+*/
+bool isMappedBlock(SM_FileHandle *fHandle, SM_PageHandle page)
+{
+	PageFile *pageFile = fHandle ? fHandle->mgmtInfo : NULL;
+	return pageFile && pageFile->map && page >= pageFile->map && page < pageFile->map + pageFile->mapReserved;
+}
+
+/**
+*
+* This function tells the kernel how the pages of a handle are going to be accessed, so that it reads ahead
+* aggressively for sequential access and not at all for random access. The hint applies to reads through the
+* descriptor (posix_fadvise) and to the mapping (madvise), including the part mapped later.
+*
+*/
+RC adviseAccessPattern(SM_FileHandle *fHandle, SM_AccessPattern pattern)
+{
+	PageFile *pageFile = fHandle ? fHandle->mgmtInfo : NULL;
+	if (!pageFile)
+		return RC_FILE_NOT_OPENED;
+
+	int fileAdvice = POSIX_FADV_NORMAL;
+	int mapAdvice = MADV_NORMAL;
+	if (pattern == SM_ACCESS_SEQUENTIAL)
+	{
+		fileAdvice = POSIX_FADV_SEQUENTIAL;
+		mapAdvice = MADV_SEQUENTIAL;
+	}
+	else if (pattern == SM_ACCESS_RANDOM)
+	{
+		fileAdvice = POSIX_FADV_RANDOM;
+		mapAdvice = MADV_RANDOM;
+	}
+
+	posix_fadvise(pageFile->fd, 0, 0, fileAdvice);
+	pthread_mutex_lock(&pageFile->mapLatch);
+	pageFile->advice = mapAdvice;
+	if (pageFile->map && pageFile->mappedPages > 0)
+		madvise(pageFile->map, (size_t)pageFile->mappedPages * PAGE_SIZE, mapAdvice);
+	pthread_mutex_unlock(&pageFile->mapLatch);
+	return RC_OK;
+}
+
+/**
+*
+* This function asks the kernel to start reading count pages from startPage into the page cache, without waiting
+* for them: madvise(MADV_WILLNEED) on the mapping of a mapped handle, posix_fadvise(POSIX_FADV_WILLNEED) otherwise.
+*
+*/
+RC prefetchBlocks(int startPage, int count, SM_FileHandle *fHandle)
+{
+	PageFile *pageFile = fHandle ? fHandle->mgmtInfo : NULL;
+	if (!pageFile)
+		return RC_FILE_NOT_OPENED;
+
+	int totalNumPages = pageCount(fHandle);
+	if (startPage < 0 || count <= 0 || startPage >= totalNumPages)
+		return RC_INVALID_PAGE_RANGE;
+	if (startPage + count > totalNumPages)
+		count = totalNumPages - startPage;
+
+	if (pageFile->map && growMapping(pageFile, startPage + count))
+		madvise(pageFile->map + (size_t)startPage * PAGE_SIZE, (size_t)count * PAGE_SIZE, MADV_WILLNEED);
+	else if (!pageFile->compressed)
+		posix_fadvise(pageFile->fd, (off_t)startPage * PAGE_SIZE, (off_t)count * PAGE_SIZE, POSIX_FADV_WILLNEED);
+	return RC_OK;
+}
+
+/*
+Asynchronous I/O keeps one slot per request that may be outstanding, so submitting does not allocate (except for the
+room a slot keeps for checksummed pages, once it first needs it) and a completion can be found by the slot index the
+kernel hands back (user_data). With io_uring, requests are queued in the
+submission ring and only passed to the kernel by reapCompletions, so a batch of submissions costs a single system
+call. Without it, submitRead and submitWrite transfer the pages right away and queue the slot in ready.
+*/
+typedef struct AsyncIOSlot {
+	struct iovec iov[SM_MAX_ASYNC_PAGES];
+	void *tag;
+	int fd;
+	PageFile *pageFile;
+	SM_FileHandle *fHandle; // its page count grows once a write that extends the file has completed
+	int startPage;
+	int count;
+	bool isWrite;
+	bool verify; // a read whose pages have to pass their checksums
+	bool inUse;
+	ssize_t result;
+	unsigned long submitTime;
+	char *stamped;     // copies of the pages of a checksummed write, with their checksums
+	int stampedPages;  // pages stamped has room for
+} AsyncIOSlot;
+
+typedef struct AsyncIOState {
+	AsyncIOSlot *slots;
+	int *freeSlots;
+	int numOfFreeSlots;
+	int *ready;
+	int readyHead;
+	int numOfReady;
+	int ringFd;
+	unsigned numOfUnsubmitted;
+	void *sqRing;
+	size_t sqRingSize;
+	void *cqRing;
+	size_t cqRingSize;
+	void *sqes;
+	size_t sqesSize;
+	unsigned *sqTail;
+	unsigned *sqMask;
+	unsigned *sqArray;
+	unsigned *cqHead;
+	unsigned *cqTail;
+	unsigned *cqMask;
+	void *cqes;
+} AsyncIOState;
+
+#ifdef SM_IO_URING
+/**
+*
+* This function maps the submission and completion rings of a new io_uring instance. It returns false if the kernel
+* does not offer io_uring, in which case the queue falls back to synchronous transfers.
+*
+*/
+static bool setupIoUring(AsyncIOState *state, unsigned entries)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+	if (fd < 0)
+		return false;
+
+	state->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	state->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		if (state->cqRingSize > state->sqRingSize)
+			state->sqRingSize = state->cqRingSize;
+		state->cqRingSize = 0;
+	}
+	state->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	state->sqRing = mmap(NULL, state->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	state->cqRing = state->sqRing;
+	if (state->sqRing != MAP_FAILED && state->cqRingSize > 0)
+		state->cqRing = mmap(NULL, state->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+	state->sqes = mmap(NULL, state->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (state->sqRing == MAP_FAILED || state->cqRing == MAP_FAILED || state->sqes == MAP_FAILED)
+	{
+		if (state->sqes != MAP_FAILED)
+			munmap(state->sqes, state->sqesSize);
+		if (state->cqRingSize > 0 && state->cqRing != MAP_FAILED && state->sqRing != MAP_FAILED)
+			munmap(state->cqRing, state->cqRingSize);
+		if (state->sqRing != MAP_FAILED)
+			munmap(state->sqRing, state->sqRingSize);
+		close(fd);
+		return false;
+	}
+
+	char *sq = state->sqRing;
+	char *cq = state->cqRing;
+	state->sqTail = (unsigned *)(sq + params.sq_off.tail);
+	state->sqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+	state->sqArray = (unsigned *)(sq + params.sq_off.array);
+	state->cqHead = (unsigned *)(cq + params.cq_off.head);
+	state->cqTail = (unsigned *)(cq + params.cq_off.tail);
+	state->cqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+	state->cqes = cq + params.cq_off.cqes;
+	state->ringFd = fd;
+	return true;
+}
+
+/**
+*
+* This function puts the request of a slot into the submission ring; the kernel sees it at the next io_uring_enter.
+* The ring has at least as many entries as there are slots, so there is always room.
+*
+*/
+static void queueSubmission(AsyncIOState *state, int slotIndex)
+{
+	AsyncIOSlot *slot = &state->slots[slotIndex];
+	unsigned tail = *state->sqTail;
+	unsigned index = tail & *state->sqMask;
+	struct io_uring_sqe *sqe = &((struct io_uring_sqe *)state->sqes)[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = slot->isWrite ? IORING_OP_WRITEV : IORING_OP_READV;
+	sqe->fd = slot->fd;
+	sqe->off = (unsigned long long)slot->startPage * PAGE_SIZE;
+	sqe->addr = (unsigned long long)(uintptr_t)slot->iov;
+	sqe->len = slot->count;
+	sqe->user_data = slotIndex;
+	state->sqArray[index] = index;
+	__atomic_store_n(state->sqTail, tail + 1, __ATOMIC_RELEASE);
+	state->numOfUnsubmitted++;
+}
+
+/**
+*
+* This function passes the queued submissions to the kernel and, if waitFor is positive, waits until that many
+* completions are available.
+*
+*/
+static RC enterIoUring(AsyncIOState *state, unsigned waitFor)
+{
+	while (true)
+	{
+		int submitted = (int)syscall(__NR_io_uring_enter, state->ringFd, state->numOfUnsubmitted, waitFor,
+									 waitFor > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+		if (submitted >= 0)
+		{
+			state->numOfUnsubmitted -= submitted;
+			return RC_OK;
+		}
+		if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			return RC_READ_FAILED;
+	}
+}
+#endif
+
+/**
+*
+* This function carries out the request of a slot with vectored positional I/O. It is used when the queue is not
+* backed by io_uring, and for compressed files, whose pages are decompressed or compressed one by one.
+*
+*/
+static ssize_t transferSlot(AsyncIOSlot *slot)
+{
+	struct iovec iov[SM_MAX_ASYNC_PAGES];
+	memcpy(iov, slot->iov, slot->count * sizeof(struct iovec));
+	return transferFilePages(slot->pageFile, iov, slot->count, slot->startPage, slot->isWrite);
+}
+
+/**
+*
+* This function creates an asynchronous I/O queue for up to queueDepth outstanding requests. It uses io_uring if
+* the kernel allows it and falls back to synchronous transfers otherwise, so it only fails if memory runs out.
+*
+*/
+RC initAsyncIO(SM_AsyncIO *aio, int queueDepth)
+{
+	if (aio == NULL || queueDepth <= 0)
+		return RC_FILE_HANDLE_NOT_INIT;
+
+	AsyncIOState *state = calloc(1, sizeof(AsyncIOState));
+	if (!state)
+		return RC_FILE_HANDLE_NOT_INIT;
+	state->slots = calloc(queueDepth, sizeof(AsyncIOSlot));
+	state->freeSlots = malloc(queueDepth * sizeof(int));
+	state->ready = malloc(queueDepth * sizeof(int));
+	if (!state->slots || !state->freeSlots || !state->ready)
+	{
+		free(state->slots);
+		free(state->freeSlots);
+		free(state->ready);
+		free(state);
+		return RC_FILE_HANDLE_NOT_INIT;
+	}
+	for (int i = 0; i < queueDepth; i++)
+		state->freeSlots[i] = queueDepth - 1 - i;
+	state->numOfFreeSlots = queueDepth;
+	state->ringFd = -1;
+
+	aio->queueDepth = queueDepth;
+	aio->kernelQueue = false;
+#ifdef SM_IO_URING
+	aio->kernelQueue = setupIoUring(state, (unsigned)queueDepth);
+#endif
+	aio->mgmtInfo = state;
+	return RC_OK;
+}
+
+/**
+*
+* This function returns the number of pages a file will have once the writes outstanding in the queue have completed.
+* A write may start there, so a run of writes can be submitted before the first of them is reaped.
+*
+*/
+static int pendingPageCount(SM_AsyncIO *aio, SM_FileHandle *fHandle)
+{
+	AsyncIOState *state = aio->mgmtInfo;
+	int numOfPages = pageCount(fHandle);
+
+	for (int i = 0; i < aio->queueDepth; i++)
+	{
+		AsyncIOSlot *slot = &state->slots[i];
+		if (slot->inUse && slot->isWrite && slot->fHandle == fHandle && slot->startPage + slot->count > numOfPages)
+			numOfPages = slot->startPage + slot->count;
+	}
+	return numOfPages;
+}
+
+/**
+*
+* This function takes a free slot for a request on count pages from startPage. The page buffers are remembered in
+* the slot, so memPages itself only has to live until the call returns, while the buffers must stay valid until the
+* request completes. A checksummed write is the exception: its pages are copied into the slot, which keeps the room
+* for later writes, and stamped there, so its buffers may change as soon as it is submitted.
+*
+*/
+static RC submitAsync(SM_AsyncIO *aio, SM_FileHandle *fHandle, int startPage, int count, SM_PageHandle *memPages,
+					  void *tag, bool isWrite)
+{
+	if (aio == NULL || aio->mgmtInfo == NULL || fHandle == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+	if (startPage < 0 || count <= 0 || count > SM_MAX_ASYNC_PAGES)
+		return RC_INVALID_PAGE_RANGE;
+
+	int fd = pageFileDescriptor(fHandle);
+	if (fd < 0)
+		return RC_FILE_NOT_OPENED;
+	AsyncIOState *state = aio->mgmtInfo;
+	if (isWrite && startPage > pendingPageCount(aio, fHandle))
+		return RC_INVALID_PAGE_RANGE;
+	if (state->numOfFreeSlots == 0)
+		return RC_IO_QUEUE_FULL;
+
+	int slotIndex = state->freeSlots[state->numOfFreeSlots - 1];
+	AsyncIOSlot *slot = &state->slots[slotIndex];
+	SM_ChecksumMode mode = checksumMode(fHandle);
+	bool stamp = isWrite && mode != SM_CHECKSUM_NONE;
+	if (stamp && slot->stampedPages < count)
+	{
+		char *stamped = realloc(slot->stamped, (size_t)count * PAGE_SIZE);
+		if (!stamped)
+			return RC_WRITE_FAILED;
+		slot->stamped = stamped;
+		slot->stampedPages = count;
+	}
+	state->numOfFreeSlots--;
+	for (int i = 0; i < count; i++)
+	{
+		slot->iov[i].iov_base = memPages[i];
+		slot->iov[i].iov_len = PAGE_SIZE;
+		if (stamp)
+		{
+			slot->iov[i].iov_base = slot->stamped + (size_t)i * PAGE_SIZE;
+			memcpy(slot->iov[i].iov_base, memPages[i], PAGE_SIZE);
+			stampChecksum(slot->iov[i].iov_base);
+		}
+	}
+	if (isWrite)
+		markBlankPages(fHandle->mgmtInfo, startPage, startPage + count, false);
+	slot->verify = !isWrite && mode == SM_CHECKSUM_VERIFY;
+	slot->tag = tag;
+	slot->fd = fd;
+	slot->pageFile = fHandle->mgmtInfo;
+	slot->fHandle = fHandle;
+	slot->startPage = startPage;
+	slot->count = count;
+	slot->isWrite = isWrite;
+	slot->inUse = true;
+#ifdef BM_LATENCY_HISTOGRAMS
+	slot->submitTime = latencyNow();
+#endif
+
+#ifdef SM_IO_URING
+	if (aio->kernelQueue && !slot->pageFile->compressed)
+	{
+		queueSubmission(state, slotIndex);
+		return RC_OK;
+	}
+#endif
+	slot->result = transferSlot(slot);
+	state->ready[(state->readyHead + state->numOfReady) % aio->queueDepth] = slotIndex;
+	state->numOfReady++;
+	return RC_OK;
+}
+
+/**
+*
+* These functions submit a read or a write of count consecutive pages, starting at startPage, to or from the buffers
+* in memPages. Pages are addressed by position, so the current page position of the handle is left alone. A write
+* may start at most at the end of the file, where the writes still outstanding in the queue count as written; the
+* page count of the handle only grows when such a write is reaped, so the handle must stay open until then. A read
+* may reach past the end, its completion then tells how many pages were there. RC_IO_QUEUE_FULL means queueDepth
+* requests are outstanding and some must be reaped first.
+*
+*/
+RC submitRead(SM_AsyncIO *aio, SM_FileHandle *fHandle, int startPage, int count, SM_PageHandle *memPages, void *tag)
+{
+	return submitAsync(aio, fHandle, startPage, count, memPages, tag, false);
+}
+
+RC submitWrite(SM_AsyncIO *aio, SM_FileHandle *fHandle, int startPage, int count, SM_PageHandle *memPages, void *tag)
+{
+	return submitAsync(aio, fHandle, startPage, count, memPages, tag, true);
+}
+
+/**
+*
+* This function fills in the completion of a finished request and frees its slot. A write that completed in full
+* and reaches past the end of the file extends its page count; a failed one leaves the count as it was.
+*
+*/
+static void completeSlot(AsyncIOState *state, int slotIndex, ssize_t result, SM_IOCompletion *completion)
+{
+	AsyncIOSlot *slot = &state->slots[slotIndex];
+	int numOfPages = (result > 0) ? (int)(result / PAGE_SIZE) : 0;
+	if (numOfPages > slot->count)
+		numOfPages = slot->count;
+
+	completion->tag = slot->tag;
+	completion->startPage = slot->startPage;
+	completion->numOfPages = numOfPages;
+	if (numOfPages == slot->count)
+		completion->rc = RC_OK;
+	else if (slot->isWrite)
+		completion->rc = RC_WRITE_FAILED;
+	else
+		completion->rc = (result >= 0) ? RC_READ_NON_EXISTING_PAGE : RC_READ_FAILED;
+	for (int i = 0; i < numOfPages && slot->verify; i++)
+	{
+		if (verifyPage(slot->startPage + i, slot->fHandle, slot->iov[i].iov_base) != RC_OK)
+			completion->rc = RC_CHECKSUM_MISMATCH;
+	}
+	if (slot->isWrite && completion->rc == RC_OK && slot->startPage + slot->count > pageCount(slot->fHandle))
+		setPageCount(slot->fHandle, slot->startPage + slot->count);
+	slot->inUse = false;
+#ifdef BM_LATENCY_HISTOGRAMS
+	recordLatency(slot->isWrite ? LATENCY_WRITE_BLOCK : LATENCY_READ_BLOCK, latencyNow() - slot->submitTime);
+#endif
+	state->freeSlots[state->numOfFreeSlots++] = slotIndex;
+}
+
+/**
+*
+* This function submits the queued requests and collects up to maxCompletions finished ones into completions,
+* waiting until at least minCompletions have finished (or all outstanding ones, if there are fewer). The number
+* collected is stored in numOfCompletions.
+*
+*/
+RC reapCompletions(SM_AsyncIO *aio, SM_IOCompletion *completions, int maxCompletions, int minCompletions, int *numOfCompletions)
+{
+	if (aio == NULL || aio->mgmtInfo == NULL || numOfCompletions == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+
+	AsyncIOState *state = aio->mgmtInfo;
+	int outstanding = aio->queueDepth - state->numOfFreeSlots;
+	if (minCompletions > outstanding)
+		minCompletions = outstanding;
+	if (minCompletions > maxCompletions)
+		minCompletions = maxCompletions;
+
+	int reaped = 0;
+	while (reaped < maxCompletions && state->numOfReady > 0)
+	{
+		int slotIndex = state->ready[state->readyHead];
+		state->readyHead = (state->readyHead + 1) % aio->queueDepth;
+		state->numOfReady--;
+		completeSlot(state, slotIndex, state->slots[slotIndex].result, &completions[reaped++]);
+	}
+
+#ifdef SM_IO_URING
+	if (aio->kernelQueue)
+	{
+		while (true)
+		{
+			unsigned head = *state->cqHead;
+			unsigned tail = __atomic_load_n(state->cqTail, __ATOMIC_ACQUIRE);
+			for (; head != tail && reaped < maxCompletions; head++)
+			{
+				struct io_uring_cqe *cqe = &((struct io_uring_cqe *)state->cqes)[head & *state->cqMask];
+				completeSlot(state, (int)cqe->user_data, cqe->res, &completions[reaped++]);
+			}
+			__atomic_store_n(state->cqHead, head, __ATOMIC_RELEASE);
+
+			if (reaped >= minCompletions && (state->numOfUnsubmitted == 0 || reaped >= maxCompletions))
+				break;
+			unsigned waitFor = (reaped < minCompletions) ? 1 : 0;
+			if (enterIoUring(state, waitFor) != RC_OK)
+			{
+				*numOfCompletions = reaped;
+				return RC_READ_FAILED;
+			}
+			if (waitFor == 0 && reaped >= minCompletions)
+				break;
+		}
+		if (state->numOfUnsubmitted > 0 && enterIoUring(state, 0) != RC_OK)
+		{
+			*numOfCompletions = reaped;
+			return RC_READ_FAILED;
+		}
+	}
+#endif
+	*numOfCompletions = reaped;
+	return RC_OK;
+}
+
+/**
+*
+* This function returns the number of requests submitted but not yet reaped.
+*
+*/
+int pendingAsyncIO(SM_AsyncIO *aio)
+{
+	if (aio == NULL || aio->mgmtInfo == NULL)
+		return 0;
+	return aio->queueDepth - ((AsyncIOState *)aio->mgmtInfo)->numOfFreeSlots;
+}
+
+/**
+*
+* This function waits for all outstanding requests, dropping their completions, and releases the queue.
+*
+*/
+RC shutdownAsyncIO(SM_AsyncIO *aio)
+{
+	if (aio == NULL || aio->mgmtInfo == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+
+	AsyncIOState *state = aio->mgmtInfo;
+	SM_IOCompletion completions[16];
+	while (pendingAsyncIO(aio) > 0)
+	{
+		int reaped;
+		if (reapCompletions(aio, completions, 16, 1, &reaped) != RC_OK || reaped == 0)
+			break;
+	}
+
+#ifdef SM_IO_URING
+	if (aio->kernelQueue)
+	{
+		munmap(state->sqes, state->sqesSize);
+		if (state->cqRingSize > 0)
+			munmap(state->cqRing, state->cqRingSize);
+		munmap(state->sqRing, state->sqRingSize);
+		close(state->ringFd);
 	}
-    printf("\nOperation unsuccessful!!!\n");
-    printf("\nERROR CODE : RC_WRITE_FAILED\n");
-	return RC_WRITE_FAILED;
+#endif
+	for (int i = 0; i < aio->queueDepth; i++)
+		free(state->slots[i].stamped);
+	free(state->slots);
+	free(state->freeSlots);
+	free(state->ready);
+	free(state);
+	aio->mgmtInfo = NULL;
+	return RC_OK;
 }
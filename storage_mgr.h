@@ -2,6 +2,7 @@
 #define STORAGE_MGR_H
 
 #include "dberror.h"
+#include "dt.h"
 
 /************************************************************
  *                    handle data structures                *
@@ -15,12 +16,75 @@ typedef struct SM_FileHandle {
 
 typedef char* SM_PageHandle;
 
+/* An asynchronous I/O queue. Reads and writes are submitted with a tag and complete later, in any order; up to
+ * queueDepth of them can be outstanding. kernelQueue tells whether the queue is backed by io_uring; without it
+ * every request is carried out synchronously when it is submitted and only its completion is deferred. */
+typedef struct SM_AsyncIO {
+	int queueDepth;
+	bool kernelQueue;
+	void *mgmtInfo;
+} SM_AsyncIO;
+
+/* The outcome of one submitted request: numOfPages is the number of pages, from startPage on, that were fully
+ * transferred; rc is RC_OK only if all of them were (and, for a verifying handle, passed their checksums). */
+typedef struct SM_IOCompletion {
+	void *tag;
+	int startPage;
+	int numOfPages;
+	RC rc;
+} SM_IOCompletion;
+
+/* How the pages of a file are going to be accessed, a hint for the kernel's read-ahead */
+typedef enum SM_AccessPattern {
+	SM_ACCESS_NORMAL = 0,
+	SM_ACCESS_SEQUENTIAL = 1,
+	SM_ACCESS_RANDOM = 2
+} SM_AccessPattern;
+
+/* How a page file grows: exactly to the pages written or asked for, or geometrically, with space for about as many
+ * pages again allocated beyond its end so that appends rarely have to allocate */
+typedef enum SM_GrowthPolicy {
+	SM_GROWTH_EXACT = 0,
+	SM_GROWTH_GEOMETRIC = 1
+} SM_GrowthPolicy;
+
+/* Bounds of the space a geometrically growing file reserves beyond its end, in pages */
+#define SM_MIN_GROWTH_PAGES 16
+#define SM_MAX_GROWTH_PAGES 65536
+
+/* Page checksums. A handle that writes checksums stores a CRC32C of the rest of each page it writes in the last
+ * PAGE_CHECKSUM_SIZE bytes of the page, which are therefore not available for data; the checksum goes into a copy
+ * of the page, so the caller's buffer is left as it was. A handle that verifies them also checks every page it reads
+ * and reports a mismatch with RC_CHECKSUM_MISMATCH. verifyBlock passes only a matching checksum; verifyPage also
+ * passes a page of zeros that the file never wrote: one the handle added (appendEmptyBlock, ensureCapacity) and has
+ * not written since, one beyond the end of the file, or, in a compressed file, one without data. Pages a plain file
+ * had when it was opened count as written, so a page of zeros among them is reported. */
+typedef enum SM_ChecksumMode {
+	SM_CHECKSUM_NONE = 0,
+	SM_CHECKSUM_WRITE = 1,
+	SM_CHECKSUM_VERIFY = 2
+} SM_ChecksumMode;
+
+#define PAGE_CHECKSUM_SIZE 4
+#define PAGE_CHECKSUM_OFFSET (PAGE_SIZE - PAGE_CHECKSUM_SIZE)
+
+/* Compressed page files. createCompressedPageFile creates a page file whose pages are stored compressed, each on
+ * its own, behind a map from page numbers to their place in the file; it is opened, read and written like any
+ * other page file, only slower per page and smaller on disc. It cannot be memory-mapped (mapPageFile fails with
+ * RC_MAP_FAILED), and its asynchronous requests are carried out synchronously. It must be written through one
+ * handle at a time. openPageFile refuses one whose header makes no sense (RC_CORRUPT_PAGE_FILE) or whose map cannot
+ * be read in full (RC_READ_FAILED) rather than open it as a plain page file. */
+
+/* Largest number of pages a single asynchronous request may cover */
+#define SM_MAX_ASYNC_PAGES 256
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
 /* manipulating page files */
 extern void initStorageManager (void);
 extern RC createPageFile (char *fileName);
+extern RC createCompressedPageFile (char *fileName);
 extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
 extern RC closePageFile (SM_FileHandle *fHandle);
 extern RC destroyPageFile (char *fileName);
@@ -33,11 +97,36 @@ extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 
 /* writing blocks to a page file */
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
+extern RC setGrowthPolicy (SM_FileHandle *fHandle, SM_GrowthPolicy policy);
+
+/* page checksums */
+extern RC setChecksumMode (SM_FileHandle *fHandle, SM_ChecksumMode mode);
+extern RC verifyBlock (SM_PageHandle memPage);
+extern RC verifyPage (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern unsigned int computeCRC32C (const char *data, int length);
+
+/* memory-mapped access to a page file */
+extern RC mapPageFile (SM_FileHandle *fHandle);
+extern RC unmapPageFile (SM_FileHandle *fHandle);
+extern RC getMappedBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle *page);
+extern bool isMappedBlock (SM_FileHandle *fHandle, SM_PageHandle page);
+extern RC adviseAccessPattern (SM_FileHandle *fHandle, SM_AccessPattern pattern);
+extern RC prefetchBlocks (int startPage, int count, SM_FileHandle *fHandle);
+
+/* asynchronous reading and writing of blocks */
+extern RC initAsyncIO (SM_AsyncIO *aio, int queueDepth);
+extern RC submitRead (SM_AsyncIO *aio, SM_FileHandle *fHandle, int startPage, int count, SM_PageHandle *memPages, void *tag);
+extern RC submitWrite (SM_AsyncIO *aio, SM_FileHandle *fHandle, int startPage, int count, SM_PageHandle *memPages, void *tag);
+extern RC reapCompletions (SM_AsyncIO *aio, SM_IOCompletion *completions, int maxCompletions, int minCompletions, int *numOfCompletions);
+extern int pendingAsyncIO (SM_AsyncIO *aio);
+extern RC shutdownAsyncIO (SM_AsyncIO *aio);
 
 #endif
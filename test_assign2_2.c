@@ -0,0 +1,2011 @@
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "latency_stat.h"
+#include "trace_log.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+// var to store the current test's name
+char *testName;
+
+// check whether two the content of a buffer pool is the same as an expected content
+// (given in the format produced by sprintPoolContent)
+#define ASSERT_EQUALS_POOL(expected,bm,message)			        \
+  do {									\
+    char *real;								\
+    char *_exp = (char *) (expected);                                   \
+    real = sprintPoolContent(bm);					\
+    if (strcmp((_exp),real) != 0)					\
+      {									\
+	printf("[%s-%s-L%i-%s] FAILED: expected <%s> but was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+	free(real);							\
+	exit(1);							\
+      }									\
+    printf("[%s-%s-L%i-%s] OK: expected <%s> and was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+    free(real);								\
+  } while(0)
+
+// check which page each frame of a buffer pool holds (given as a comma separated list)
+#define ASSERT_EQUALS_FRAMES(bm,numFrames,expected,message)		\
+  do {									\
+    char _real[512] = "";						\
+    PageNumber *_frames = getFrameContents(bm);				\
+    int _i;								\
+    for (_i = 0; _i < (numFrames); _i++)				\
+      sprintf(_real + strlen(_real), "%s%i", _i ? "," : "", _frames[_i]); \
+    free(_frames);							\
+    ASSERT_EQUALS_STRING((expected), _real, message);			\
+  } while(0)
+
+// test and helper methods
+static void createDummyPages(BM_BufferPool *bm, int num);
+
+static void testCLOCK (void);
+static void testLFU (void);
+static void testLFUAging (void);
+static void testLRU_K (void);
+static void testLRU_KCorrelatedReferences (void);
+static void testARC (void);
+static void testMultiplePools (void);
+static void testConcurrentPins (void);
+static void *concurrentPinWorker (void *arg);
+static void testBackgroundWriter (void);
+static void testReadAhead (void);
+static void testBatchPins (void);
+static void testSortedFlush (void);
+static void testAccessRing (void);
+static void testPoolStatistics (void);
+static void testLatencyHistograms (void);
+static void testResizePool (void);
+static void testPoolMemory (void);
+static void testAsyncIO (void);
+static void testConcurrentReads (void);
+static void *concurrentReadWorker (void *arg);
+static void testMappedStorage (void);
+static void testTracing (void);
+static void testFileGrowth (void);
+static void testVectoredBlocks (void);
+static void testPageChecksums (void);
+static void testCompressedPages (void);
+static void corruptPage (int pageNum);
+static void zeroPage (int pageNum);
+
+// main method
+int
+main (void)
+{
+  initStorageManager();
+  testName = "";
+
+  testCLOCK();
+  testLFU();
+  testLFUAging();
+  testLRU_K();
+  testLRU_KCorrelatedReferences();
+  testARC();
+  testMultiplePools();
+  testConcurrentPins();
+  testBackgroundWriter();
+  testReadAhead();
+  testBatchPins();
+  testSortedFlush();
+  testAccessRing();
+  testPoolStatistics();
+  testLatencyHistograms();
+  testResizePool();
+  testPoolMemory();
+  testAsyncIO();
+  testConcurrentReads();
+  testMappedStorage();
+  testTracing();
+  testFileGrowth();
+  testVectoredBlocks();
+  testPageChecksums();
+  testCompressedPages();
+}
+
+void
+createDummyPages(BM_BufferPool *bm, int num)
+{
+  int i;
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+  for (i = 0; i < num; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(h->data, "%s-%i", "Page", h->pageNum);
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm,h));
+    }
+
+  CHECK(shutdownBufferPool(bm));
+
+  free(h);
+}
+
+// test the CLOCK page replacement strategy
+void
+testCLOCK (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    // read first three pages and directly unpin them
+    "[0 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0]",
+    "[0 0],[1 0],[2 0]",
+    // a full turn clears all reference bits, the hand stops at frame 0
+    "[3 0],[1 0],[2 0]",
+    // page 1 gets referenced again, so page 2 is replaced next
+    "[3 0],[1 0],[2 0]",
+    "[3 0],[1 0],[4 0]",
+    "[3 0],[5 0],[4 0]",
+    "[6 0],[5 0],[4 0]"
+  };
+  const int requests[] = {0,1,2,3,1,4,5,6};
+  const int numRequests = 8;
+
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing CLOCK page replacement";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_CLOCK, NULL));
+
+  for(i = 0; i < numRequests; i++)
+  {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+      ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+  }
+
+  // a pinned page is never chosen as victim
+  CHECK(pinPage(bm, h, 6));
+  CHECK(pinPage(bm, h, 7));
+  ASSERT_EQUALS_POOL("[6 1],[5 0],[7 1]", bm, "pinned page survives a sweep");
+  CHECK(pinPage(bm, h, 8));
+  ASSERT_EQUALS_POOL("[6 1],[8 1],[7 1]", bm, "remaining unpinned frame is replaced");
+  ASSERT_ERROR(pinPage(bm, h, 9), "every frame is pinned");
+
+  // check number of write IOs
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(9, getNumReadIO(bm), "check number of read I/Os");
+
+  h->pageNum = 6;
+  CHECK(unpinPage(bm, h));
+  h->pageNum = 7;
+  CHECK(unpinPage(bm, h));
+  h->pageNum = 8;
+  CHECK(unpinPage(bm, h));
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test the LFU page replacement strategy
+void
+testLFU (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    "[0 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0]",
+    "[0 0],[1 0],[2 0]",
+    // raise the frequency of page 0 to 3 and of page 1 to 2
+    "[0 0],[1 0],[2 0]",
+    "[0 0],[1 0],[2 0]",
+    "[0 0],[1 0],[2 0]",
+    // the least frequently used page is replaced
+    "[0 0],[1 0],[3 0]",
+    "[0 0],[1 0],[4 0]",
+    // page 4 reaches frequency 3, page 1 is now the least frequently used
+    "[0 0],[1 0],[4 0]",
+    "[0 0],[1 0],[4 0]",
+    "[0 0],[5 0],[4 0]"
+  };
+  const int requests[] = {0,1,2,0,0,1,3,4,4,4,5};
+  const int numRequests = 11;
+
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing LFU page replacement";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LFU, NULL));
+
+  for(i = 0; i < numRequests; i++)
+  {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+      ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+  }
+
+  // pinned page 5 is skipped although it is the least frequently used,
+  // pages 0 and 4 tie at frequency 3 and the least recently used one goes
+  CHECK(pinPage(bm, h, 5));
+  CHECK(pinPage(bm, h, 6));
+  ASSERT_EQUALS_POOL("[6 1],[5 1],[4 0]", bm, "pinned page is not replaced");
+
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(7, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(unpinPage(bm, h));
+  h->pageNum = 5;
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test that LFU aging lets a formerly hot page leave the pool
+void
+testLFUAging (void)
+{
+  const int requests[] = {0,0,0,1,2};
+  const int numRequests = 5;
+  BM_LFU_StratData aging;
+
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing LFU frequency aging";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+
+  // without aging page 0 keeps its frequency of 3 and page 1 is replaced
+  CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LFU, NULL));
+  for(i = 0; i < numRequests; i++)
+  {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_POOL("[0 0],[2 0]", bm, "hot page stays without aging");
+  CHECK(shutdownBufferPool(bm));
+
+  // halving every 4 pins brings page 0 back to frequency 1 before page 2 arrives
+  aging.agingInterval = 4;
+  CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LFU, &aging));
+  for(i = 0; i < numRequests; i++)
+  {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_POOL("[2 0],[1 0]", bm, "aged page is replaced");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test the LRU-K page replacement strategy with K = 2
+void
+testLRU_K (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    // pages 0 and 1 are referenced twice
+    "[0 0],[-1 0],[-1 0]",
+    "[0 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0]",
+    // a scan only replaces pages that have been referenced once
+    "[0 0],[1 0],[2 0]",
+    "[0 0],[1 0],[3 0]",
+    "[0 0],[1 0],[4 0]",
+    // page 2 returns with its retained history and now has two references
+    "[0 0],[1 0],[2 0]",
+    // page 0 has the oldest second-to-last reference
+    "[5 0],[1 0],[2 0]"
+  };
+  const int requests[] = {0,0,1,1,2,3,4,2,5};
+  const int numRequests = 9;
+
+  int i;
+  BM_LRU_K_StratData lru2 = { 2, 0, 0 };
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing LRU-K page replacement";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU_K, &lru2));
+
+  for(i = 0; i < numRequests; i++)
+  {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+      ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+  }
+
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(7, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test that references within the correlated reference period count as one
+void
+testLRU_KCorrelatedReferences (void)
+{
+  const int requests[] = {0,0,1,2};
+  const int numRequests = 4;
+  BM_LRU_K_StratData uncorrelated = { 2, 0, 0 };
+  BM_LRU_K_StratData correlated = { 2, 2, 0 };
+  const int returningRequests[] = {0,1,2,0,5,5,5,5,3};
+  const int numReturningRequests = 9;
+  BM_LRU_K_StratData returning = { 2, 3, 0 };
+
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle *pinned = MAKE_PAGE_HANDLE();
+  testName = "Testing LRU-K correlated reference period";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+
+  // two uncorrelated references protect page 0
+  CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LRU_K, &uncorrelated));
+  for(i = 0; i < numRequests; i++)
+  {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_POOL("[0 0],[2 0]", bm, "page referenced twice stays");
+  CHECK(shutdownBufferPool(bm));
+
+  // back-to-back references are one reference, page 0 is the least recently used
+  CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LRU_K, &correlated));
+  for(i = 0; i < numRequests; i++)
+  {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_POOL("[2 0],[1 0]", bm, "correlated references count once");
+  CHECK(shutdownBufferPool(bm));
+
+  // page 0 is evicted and pinned again within its period, which is still one reference; page 5 stays pinned
+  // and its hits only move the clock, so that pages 0 and 2 leave their period before page 3 is pinned
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU_K, &returning));
+  CHECK(pinPage(bm, pinned, 5));
+  for(i = 0; i < numReturningRequests; i++)
+  {
+      CHECK(pinPage(bm, h, returningRequests[i]));
+      CHECK(unpinPage(bm, h));
+  }
+  ASSERT_EQUALS_POOL("[5 1],[2 0],[3 0]", bm, "retained history keeps its correlated reference period");
+  CHECK(unpinPage(bm, pinned));
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  free(pinned);
+  TEST_DONE();
+}
+
+// test the ARC page replacement strategy
+void
+testARC (void)
+{
+  // expected results
+  const char *poolContents[] = {
+    // pages 0 and 1 are used twice and move to T2
+    "[0 0],[-1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0]",
+    "[0 0],[1 0],[-1 0]",
+    // a scan only cycles through T1
+    "[0 0],[1 0],[2 0]",
+    "[0 0],[1 0],[3 0]",
+    "[0 0],[1 0],[4 0]",
+    "[0 0],[1 0],[5 0]",
+    // a hit in B1 grows the target of T1, so T2 gives up page 0
+    "[3 0],[1 0],[5 0]",
+    // a hit in B2 shrinks it again, so T1 gives up page 5
+    "[3 0],[1 0],[0 0]"
+  };
+  const int requests[] = {0,1,0,1,2,3,4,5,3,0};
+  const int numRequests = 10;
+
+  int i;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing ARC page replacement";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 100);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_ARC, NULL));
+
+  for(i = 0; i < numRequests; i++)
+  {
+      CHECK(pinPage(bm, h, requests[i]));
+      CHECK(unpinPage(bm, h));
+      ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+  }
+
+  // every frame pinned
+  CHECK(pinPage(bm, h, 0));
+  CHECK(pinPage(bm, h, 1));
+  CHECK(pinPage(bm, h, 3));
+  ASSERT_ERROR(pinPage(bm, h, 6), "every frame is pinned");
+
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+  ASSERT_EQUALS_INT(8, getNumReadIO(bm), "check number of read I/Os");
+
+  CHECK(unpinPage(bm, h));
+  h->pageNum = 0;
+  CHECK(unpinPage(bm, h));
+  h->pageNum = 1;
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test that two buffer pools on different page files do not interfere
+void
+testMultiplePools (void)
+{
+  int i;
+  char *expected = malloc(sizeof(char) * 512);
+  BM_BufferPool *hot = MAKE_POOL();
+  BM_BufferPool *cold = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  testName = "Testing buffer pools side by side";
+
+  CHECK(createPageFile("testbuffer_hot.bin"));
+  CHECK(createPageFile("testbuffer_cold.bin"));
+  CHECK(initBufferPool(hot, "testbuffer_hot.bin", 3, RS_FIFO, NULL));
+  CHECK(initBufferPool(cold, "testbuffer_cold.bin", 2, RS_CLOCK, NULL));
+
+  // write interleaved pages with distinct contents to both files
+  for (i = 0; i < 6; i++)
+    {
+      CHECK(pinPage(hot, h, i));
+      sprintf(h->data, "%s-%i", "Hot", h->pageNum);
+      CHECK(markDirty(hot, h));
+      CHECK(unpinPage(hot, h));
+
+      CHECK(pinPage(cold, h, i));
+      sprintf(h->data, "%s-%i", "Cold", h->pageNum);
+      CHECK(markDirty(cold, h));
+      CHECK(unpinPage(cold, h));
+    }
+
+  ASSERT_EQUALS_POOL("[3x0],[4x0],[5x0]", hot, "hot pool keeps its own frames");
+  ASSERT_EQUALS_POOL("[4x0],[5x0]", cold, "cold pool keeps its own frames");
+  ASSERT_EQUALS_INT(3, getNumWriteIO(hot), "hot pool counts its own writes");
+  ASSERT_EQUALS_INT(4, getNumWriteIO(cold), "cold pool counts its own writes");
+
+  CHECK(shutdownBufferPool(hot));
+  CHECK(shutdownBufferPool(cold));
+
+  // read everything back through fresh pools
+  CHECK(initBufferPool(hot, "testbuffer_hot.bin", 3, RS_LRU, NULL));
+  CHECK(initBufferPool(cold, "testbuffer_cold.bin", 2, RS_LFU, NULL));
+  for (i = 0; i < 6; i++)
+    {
+      CHECK(pinPage(hot, h, i));
+      sprintf(expected, "%s-%i", "Hot", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading back hot page");
+      CHECK(unpinPage(hot, h));
+
+      CHECK(pinPage(cold, h, i));
+      sprintf(expected, "%s-%i", "Cold", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading back cold page");
+      CHECK(unpinPage(cold, h));
+    }
+  CHECK(shutdownBufferPool(hot));
+  CHECK(shutdownBufferPool(cold));
+
+  CHECK(destroyPageFile("testbuffer_hot.bin"));
+  CHECK(destroyPageFile("testbuffer_cold.bin"));
+
+  free(expected);
+  free(hot);
+  free(cold);
+  free(h);
+  TEST_DONE();
+}
+
+// state shared by the threads of testConcurrentPins
+#define CONCURRENT_THREADS 8
+#define CONCURRENT_PAGES 50
+#define CONCURRENT_PINS 2000
+
+typedef struct ConcurrentPinArgs
+{
+  BM_BufferPool *bm;
+  unsigned int seed;
+  int errors;
+} ConcurrentPinArgs;
+
+// pin random pages (sometimes two at once) and check that each pinned frame holds the requested page
+void *
+concurrentPinWorker (void *arg)
+{
+  ConcurrentPinArgs *args = (ConcurrentPinArgs *) arg;
+  BM_PageHandle first;
+  BM_PageHandle second;
+  char expected[PAGE_SIZE];
+  int i;
+
+  for (i = 0; i < CONCURRENT_PINS; i++)
+    {
+      int pageNum = rand_r(&args->seed) % CONCURRENT_PAGES;
+      bool pinTwo = rand_r(&args->seed) % 4 == 0;
+
+      if (pinPage(args->bm, &first, pageNum) != RC_OK)
+        {
+          args->errors++;
+          continue;
+        }
+      if (pinTwo && pinPage(args->bm, &second, (pageNum + 1) % CONCURRENT_PAGES) != RC_OK)
+        args->errors++;
+
+      sprintf(expected, "%s-%i", "Page", pageNum);
+      if (first.pageNum != pageNum || strcmp(expected, first.data) != 0)
+        args->errors++;
+      if (pinTwo)
+        {
+          sprintf(expected, "%s-%i", "Page", (pageNum + 1) % CONCURRENT_PAGES);
+          if (strcmp(expected, second.data) != 0)
+            args->errors++;
+          if (unpinPage(args->bm, &second) != RC_OK)
+            args->errors++;
+        }
+      if (unpinPage(args->bm, &first) != RC_OK)
+        args->errors++;
+    }
+  return NULL;
+}
+
+// run the workers on one pool and return the number of errors they found
+static int
+runConcurrentPinWorkers (BM_BufferPool *bm, unsigned int seed)
+{
+  pthread_t threads[CONCURRENT_THREADS];
+  ConcurrentPinArgs args[CONCURRENT_THREADS];
+  int errors = 0;
+  int i;
+
+  for (i = 0; i < CONCURRENT_THREADS; i++)
+    {
+      args[i].bm = bm;
+      args[i].seed = 17 * (i + 1) + seed;
+      args[i].errors = 0;
+      ASSERT_TRUE(pthread_create(&threads[i], NULL, concurrentPinWorker, &args[i]) == 0, "starting worker thread");
+    }
+  for (i = 0; i < CONCURRENT_THREADS; i++)
+    {
+      pthread_join(threads[i], NULL);
+      errors += args[i].errors;
+    }
+  return errors;
+}
+
+// several threads share one pool that is much smaller than the working set, then one that holds all of it
+void
+testConcurrentPins (void)
+{
+  ReplacementStrategy strategies[] = { RS_CLOCK, RS_FIFO, RS_LRU, RS_LFU, RS_LRU_K, RS_ARC };
+  int numStrategies = sizeof(strategies) / sizeof(strategies[0]);
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  PageNumber *frames;
+  int s, i, numOfResident;
+  testName = "Testing concurrent pins";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, CONCURRENT_PAGES + 1);
+
+  for (s = 0; s < numStrategies; s++)
+    {
+      CHECK(initBufferPool(bm, "testbuffer.bin", 2 * CONCURRENT_THREADS + 4, strategies[s], NULL));
+      ASSERT_EQUALS_INT(0, runConcurrentPinWorkers(bm, s), "every pin returned the requested page");
+      ASSERT_TRUE(getNumReadIO(bm) >= 2 * CONCURRENT_THREADS + 4, "pages were replaced while threads were pinning");
+      CHECK(shutdownBufferPool(bm));
+    }
+
+  // once every page is resident the threads only hit, and the hits and unpins they recorded all reach the strategy
+  for (s = 0; s < numStrategies; s++)
+    {
+      CHECK(initBufferPool(bm, "testbuffer.bin", CONCURRENT_PAGES, strategies[s], NULL));
+      for (i = 0; i < CONCURRENT_PAGES; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          CHECK(unpinPage(bm, h));
+        }
+      ASSERT_EQUALS_INT(0, runConcurrentPinWorkers(bm, s), "every hit returned the requested page");
+      ASSERT_EQUALS_INT(CONCURRENT_PAGES, getNumReadIO(bm), "every pin after the first round was a hit");
+
+      // page 0 becomes the least recently used page
+      for (i = 1; i < CONCURRENT_PAGES; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          CHECK(unpinPage(bm, h));
+        }
+      CHECK(pinPage(bm, h, CONCURRENT_PAGES));
+      CHECK(unpinPage(bm, h));
+      if (strategies[s] == RS_LRU)
+        {
+          frames = getFrameContents(bm);
+          for (numOfResident = 0, i = 0; i < CONCURRENT_PAGES; i++)
+            numOfResident += (frames[i] == 0);
+          free(frames);
+          ASSERT_EQUALS_INT(0, numOfResident, "LRU replaced the least recently used page");
+        }
+
+      // shrinking only works if the strategy knows every frame is unpinned
+      CHECK(resizeBufferPool(bm, 1));
+      CHECK(pinPage(bm, h, 0));
+      ASSERT_EQUALS_STRING("Page-0", h->data, "reading page after shrinking");
+      CHECK(unpinPage(bm, h));
+      CHECK(shutdownBufferPool(bm));
+    }
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// the background writer cleans unpinned dirty frames, so later evictions do not write
+void
+testBackgroundWriter (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_BackgroundWriterConfig config = { 0, 4, 1 };
+  char *expected = malloc(sizeof(char) * 512);
+  bool *dirty;
+  int i, round, numDirty;
+  testName = "Testing background writer";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 5, RS_LRU, NULL));
+  CHECK(startBackgroundWriter(bm, &config));
+  ASSERT_TRUE(startBackgroundWriter(bm, &config) == RC_BACKGROUND_WRITER_ERROR, "a pool has only one writer");
+
+  // dirty five pages and keep the first one pinned
+  for (i = 0; i < 5; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(h->data, "%s-%i", "Clean", h->pageNum);
+      CHECK(markDirty(bm, h));
+      if (i > 0)
+        CHECK(unpinPage(bm, h));
+    }
+
+  // wait (at most about five seconds) until only the pinned page is still dirty
+  for (round = 0; round < 5000; round++)
+    {
+      dirty = getDirtyFlags(bm);
+      for (numDirty = 0, i = 0; i < 5; i++)
+        numDirty += dirty[i];
+      free(dirty);
+      if (numDirty == 1)
+        break;
+      nanosleep(&(struct timespec){ 0, 1000000 }, NULL);
+    }
+  ASSERT_EQUALS_INT(1, numDirty, "the writer cleaned every unpinned dirty page");
+  ASSERT_EQUALS_INT(4, getNumWriteIO(bm), "pinned page was not written");
+
+  CHECK(stopBackgroundWriter(bm));
+  CHECK(stopBackgroundWriter(bm));
+
+  // replacing the clean pages does not write anything
+  for (i = 5; i < 9; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_INT(4, getNumWriteIO(bm), "evictions found clean victims");
+
+  h->pageNum = 0;
+  CHECK(unpinPage(bm, h));
+  CHECK(startBackgroundWriter(bm, NULL));
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  for (i = 0; i < 10; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", (i < 5) ? "Clean" : "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading back page");
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(expected);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// explicit prefetching and sequential read-ahead
+void
+testReadAhead (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  char *expected = malloc(sizeof(char) * 512);
+  int i;
+  testName = "Testing prefetching and sequential read-ahead";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 12);
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 6, RS_FIFO, NULL));
+
+  // prefetched pages get frames right away, while their reads finish in the background
+  CHECK(prefetchPages(bm, 0, 3));
+  ASSERT_EQUALS_FRAMES(bm, 6, "0,1,2,-1,-1,-1", "prefetched pages are resident");
+  for (i = 0; i < 3; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading prefetched page");
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[-1 0],[-1 0],[-1 0]", bm, "prefetched pages are not left pinned");
+  ASSERT_EQUALS_INT(3, getNumReadIO(bm), "each prefetched page was read once");
+
+  // pages past the end of the file are not prefetched
+  CHECK(prefetchPages(bm, 11, 4));
+  ASSERT_EQUALS_FRAMES(bm, 6, "0,1,2,11,-1,-1", "prefetch stops at the end of the file");
+
+  // three pins in a row start reading ahead
+  CHECK(setReadAheadWindow(bm, 2));
+  for (i = 3; i < 6; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_FRAMES(bm, 6, "5,6,7,11,3,4", "pages following a scan are read ahead");
+
+  CHECK(shutdownBufferPool(bm));
+
+  // a scan through a pool that holds the whole file reads every page exactly once
+  CHECK(initBufferPool(bm, "testbuffer.bin", 12, RS_LRU, NULL));
+  CHECK(setReadAheadWindow(bm, 3));
+  for (i = 0; i < 10; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading page of the scan");
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(pinPage(bm, h, 11));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(12, getNumReadIO(bm), "the scan read every page once");
+  ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "read-ahead writes nothing");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(expected);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// pin and unpin several pages with one call
+void
+testBatchPins (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle handles[4];
+  BM_PageHandle failed[4];
+  PageNumber first[] = { 3, 0, 3, 2 };
+  PageNumber second[] = { 2, 5, 6, 7 };
+  char *expected = malloc(sizeof(char) * 512);
+  int i;
+  testName = "Testing batch pins";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+
+  // a page listed twice is pinned twice but read once
+  CHECK(pinPages(bm, first, handles, 4));
+  for (i = 0; i < 4; i++)
+    {
+      sprintf(expected, "%s-%i", "Page", first[i]);
+      ASSERT_EQUALS_STRING(expected, handles[i].data, "batch pinned page holds its data");
+    }
+  ASSERT_EQUALS_POOL("[3 2],[0 1],[2 1],[-1 0]", bm, "every page of the batch is pinned");
+  ASSERT_EQUALS_INT(3, getNumReadIO(bm), "pages of the batch are read once");
+
+  // a batch that does not fit leaves nothing pinned
+  ASSERT_ERROR(pinPages(bm, second, failed, 4), "batch larger than the free frames");
+  ASSERT_EQUALS_POOL("[3 2],[0 1],[2 1],[5 0]", bm, "failed batch released its pins");
+
+  CHECK(unpinPages(bm, handles, 4));
+  ASSERT_EQUALS_POOL("[3 0],[0 0],[2 0],[5 0]", bm, "unpinPages releases the batch");
+
+  CHECK(pinPages(bm, second, handles, 4));
+  for (i = 0; i < 4; i++)
+    {
+      sprintf(expected, "%s-%i", "Page", second[i]);
+      ASSERT_EQUALS_STRING(expected, handles[i].data, "batch pinned page holds its data");
+    }
+  CHECK(unpinPages(bm, handles, 4));
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(expected);
+  free(bm);
+  TEST_DONE();
+}
+
+// dirty pages are flushed in page order, so a pool can grow its file from any queue order
+void
+testSortedFlush (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  char *expected = malloc(sizeof(char) * 512);
+  int i;
+  testName = "Testing sorted and coalesced flushing";
+
+  CHECK(createPageFile("testbuffer.bin"));
+
+  // LRU keeps the most recently used (and highest) page at the front of its queue
+  CHECK(initBufferPool(bm, "testbuffer.bin", 6, RS_LRU, NULL));
+  for (i = 0; i < 6; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(h->data, "%s-%i", "Sorted", h->pageNum);
+      CHECK(markDirty(bm, h));
+      if (i != 2)
+        CHECK(unpinPage(bm, h));
+    }
+
+  // page 2 is pinned, so only pages 0 and 1 can be written ahead of the gap
+  ASSERT_ERROR(forceFlushPool(bm), "pages behind a pinned page cannot extend the file");
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[2x1],[3x0],[4x0],[5x0]", bm, "pages up to the gap were flushed");
+  ASSERT_EQUALS_INT(2, getNumWriteIO(bm), "one write per page");
+
+  h->pageNum = 2;
+  CHECK(unpinPage(bm, h));
+  CHECK(forceFlushPool(bm));
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[3 0],[4 0],[5 0]", bm, "every page was flushed");
+  ASSERT_EQUALS_INT(6, getNumWriteIO(bm), "one write per page");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  for (i = 0; i < 6; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Sorted", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading back flushed page");
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(expected);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// a scan through an access ring leaves the rest of the pool alone
+void
+testAccessRing (void)
+{
+  ReplacementStrategy strategies[] = { RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC };
+  int numStrategies = sizeof(strategies) / sizeof(strategies[0]);
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_AccessRing ring;
+  char *expected = malloc(sizeof(char) * 512);
+  PageNumber *frames;
+  int s, i, j, numHot;
+  testName = "Testing access rings";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 30);
+
+  for (s = 0; s < numStrategies; s++)
+    {
+      CHECK(initBufferPool(bm, "testbuffer.bin", 6, strategies[s], NULL));
+
+      // the hot set: pages 0 to 2, used twice
+      for (j = 0; j < 2; j++)
+        for (i = 0; i < 3; i++)
+          {
+            CHECK(pinPage(bm, h, i));
+            CHECK(unpinPage(bm, h));
+          }
+
+      CHECK(initAccessRing(bm, &ring, 2));
+      for (i = 10; i < 30; i++)
+        {
+          CHECK(pinPageInRing(bm, &ring, h, i));
+          sprintf(expected, "%s-%i", "Page", i);
+          ASSERT_EQUALS_STRING(expected, h->data, "reading page through the ring");
+          CHECK(unpinPage(bm, h));
+        }
+      CHECK(freeAccessRing(&ring));
+
+      frames = getFrameContents(bm);
+      for (numHot = 0, i = 0; i < 6; i++)
+        numHot += (frames[i] >= 0 && frames[i] < 3);
+      free(frames);
+      ASSERT_EQUALS_INT(3, numHot, "the hot set survived the scan");
+      ASSERT_EQUALS_INT(23, getNumReadIO(bm), "every scanned page was read once");
+
+      CHECK(shutdownBufferPool(bm));
+    }
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(expected);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// counters and snapshot of a pool
+void
+testPoolStatistics (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolStatistics stats;
+  PageNumber frames[3];
+  bool dirty[3];
+  int fixCounts[3];
+  int i;
+  testName = "Testing pool statistics and snapshots";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  for (i = 0; i < 3; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      if (i == 1)
+        CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(pinPage(bm, h, 0));
+  CHECK(getPoolSnapshot(bm, frames, dirty, fixCounts, NULL));
+  ASSERT_EQUALS_INT(0, frames[0], "page 0 in frame 0");
+  ASSERT_EQUALS_INT(1, dirty[1], "page 1 is dirty");
+  ASSERT_EQUALS_INT(1, fixCounts[0], "page 0 is pinned");
+  CHECK(unpinPage(bm, h));
+
+  // FIFO replaces the clean page 0 and then the dirty page 1
+  for (i = 3; i < 5; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+
+  CHECK(getPoolSnapshot(bm, frames, dirty, fixCounts, &stats));
+  ASSERT_EQUALS_POOL("[3 0],[4 0],[2 0]", bm, "pages 0 and 1 were replaced");
+  ASSERT_EQUALS_INT(4, frames[1], "page 4 in frame 1");
+  ASSERT_EQUALS_INT(0, dirty[1], "page 4 is clean");
+  ASSERT_EQUALS_INT(0, fixCounts[1], "page 4 is unpinned");
+  ASSERT_EQUALS_INT(1, stats.hits, "one hit");
+  ASSERT_EQUALS_INT(5, stats.misses, "five misses");
+  ASSERT_EQUALS_INT(2, stats.evictions, "two evictions");
+  ASSERT_EQUALS_INT(1, stats.dirtyEvictions, "one of them wrote the page back");
+  ASSERT_EQUALS_INT(0, stats.pinWaits, "no pin waited for another thread");
+  ASSERT_EQUALS_INT(5, stats.readIO, "one read per miss");
+  ASSERT_EQUALS_INT(1, stats.writeIO, "one write");
+
+  // prefetching is neither a hit nor a miss
+  CHECK(prefetchPages(bm, 5, 1));
+  CHECK(getPoolSnapshot(bm, NULL, NULL, NULL, &stats));
+  ASSERT_EQUALS_INT(5, stats.misses, "prefetch is not a miss");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// pin, unpin and I/O latencies end up in the histograms
+void
+testLatencyHistograms (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  LatencyHistogram *before = malloc(LATENCY_NUM_OPS * sizeof(LatencyHistogram));
+  LatencyHistogram *after = malloc(LATENCY_NUM_OPS * sizeof(LatencyHistogram));
+  int expected[LATENCY_NUM_OPS] = { 2, 3, 5, 3, 0 };
+  char *dump;
+  int i, op;
+  testName = "Testing latency histograms";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+
+  for (op = 0; op < LATENCY_NUM_OPS; op++)
+    getLatencyHistogram(op, &before[op]);
+
+  // three misses and two hits
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  for (i = 0; i < 5; i++)
+    {
+      CHECK(pinPage(bm, h, i % 3));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(shutdownBufferPool(bm));
+
+  for (op = 0; op < LATENCY_NUM_OPS; op++)
+    {
+      getLatencyHistogram(op, &after[op]);
+      ASSERT_EQUALS_INT(latencyHistogramsEnabled() ? expected[op] : 0,
+          (int) (after[op].count - before[op].count), latencyOpName(op));
+      ASSERT_TRUE(latencyPercentile(&after[op], 50) <= latencyPercentile(&after[op], 99)
+          && latencyPercentile(&after[op], 99) <= latencyPercentile(&after[op], 99.9)
+          && latencyPercentile(&after[op], 99.9) <= after[op].maxNanos, "percentiles are ordered");
+    }
+
+  dump = sprintLatencyHistograms();
+  ASSERT_TRUE(dump != NULL && strstr(dump, "pinMiss count=") != NULL, "dump has a line per operation");
+  free(dump);
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(before);
+  free(after);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// growing and shrinking a pool keeps its pages
+void
+testResizePool (void)
+{
+  ReplacementStrategy strategies[] = { RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC };
+  // pages that survive shrinking to two frames, in eviction order (only given for FIFO and LRU)
+  const char *survivors[] = { "4,5", "3,2", NULL, NULL, NULL, NULL };
+  int numStrategies = sizeof(strategies) / sizeof(strategies[0]);
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle *pinned = MAKE_PAGE_HANDLE();
+  BM_BackgroundWriterConfig config = { 0, 4, 1 };
+  char *expected = malloc(sizeof(char) * 512);
+  PageNumber frames[6];
+  int s, i, numResident;
+  testName = "Testing online pool resizing";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 20);
+
+  for (s = 0; s < numStrategies; s++)
+    {
+      CHECK(initBufferPool(bm, "testbuffer.bin", 4, strategies[s], NULL));
+      // the background writer walks the frames while they are replaced
+      if (s % 2)
+        CHECK(startBackgroundWriter(bm, &config));
+      for (i = 0; i < 4; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          if (i == 1)
+            {
+              sprintf(h->data, "%s-%i", "Resized", h->pageNum);
+              CHECK(markDirty(bm, h));
+            }
+          CHECK(unpinPage(bm, h));
+        }
+
+      // growing adds frames, so pinned pages stay where they are
+      CHECK(pinPage(bm, pinned, 0));
+      CHECK(resizeBufferPool(bm, 6));
+      ASSERT_EQUALS_INT(6, bm->numPages, "pool grew");
+      ASSERT_EQUALS_STRING("Page-0", pinned->data, "pinned page stayed in place while growing");
+      CHECK(unpinPage(bm, pinned));
+      CHECK(getPoolSnapshot(bm, frames, NULL, NULL, NULL));
+      for (numResident = 0, i = 0; i < 6; i++)
+        numResident += (frames[i] >= 0 && frames[i] < 4);
+      ASSERT_EQUALS_INT(4, numResident, "pages kept while growing");
+
+      for (i = 4; i < 6; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          CHECK(unpinPage(bm, h));
+        }
+      for (i = 0; i < 4; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          sprintf(expected, "%s-%i", (i == 1) ? "Resized" : "Page", i);
+          ASSERT_EQUALS_STRING(expected, h->data, "page content survived the resize");
+          CHECK(unpinPage(bm, h));
+        }
+      ASSERT_EQUALS_INT(6, getNumReadIO(bm), "no page was read again");
+
+      CHECK(pinPage(bm, h, 2));
+      ASSERT_TRUE(resizeBufferPool(bm, 2) == RC_FRAME_IN_USE, "a pinned page in a removed frame blocks a resize");
+      ASSERT_EQUALS_INT(6, bm->numPages, "pool kept its size");
+      CHECK(unpinPage(bm, h));
+
+      CHECK(resizeBufferPool(bm, 2));
+      ASSERT_EQUALS_INT(2, bm->numPages, "pool shrank");
+      if (survivors[s])
+        ASSERT_EQUALS_FRAMES(bm, 2, survivors[s], "the strategy kept its most valuable pages");
+
+      // only the frames that are removed have to be unpinned
+      CHECK(getPoolSnapshot(bm, frames, NULL, NULL, NULL));
+      CHECK(pinPage(bm, pinned, frames[0]));
+      CHECK(resizeBufferPool(bm, 1));
+      ASSERT_EQUALS_INT(1, bm->numPages, "pool shrank around a pinned page");
+      sprintf(expected, "%s-%i", (frames[0] == 1) ? "Resized" : "Page", frames[0]);
+      ASSERT_EQUALS_STRING(expected, pinned->data, "pinned page kept its frame");
+      CHECK(unpinPage(bm, pinned));
+
+      CHECK(pinPage(bm, h, 1));
+      ASSERT_EQUALS_STRING("Resized-1", h->data, "dirty page survived the shrink");
+      CHECK(unpinPage(bm, h));
+      CHECK(pinPage(bm, h, 10));
+      CHECK(unpinPage(bm, h));
+      CHECK(shutdownBufferPool(bm));
+
+      // every dirty page was written back
+      CHECK(initBufferPool(bm, "testbuffer.bin", 2, strategies[s], NULL));
+      CHECK(pinPage(bm, h, 1));
+      ASSERT_EQUALS_STRING("Resized-1", h->data, "dirty page reached the disk");
+      sprintf(h->data, "%s-%i", "Page", h->pageNum);
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+      CHECK(shutdownBufferPool(bm));
+    }
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(expected);
+  free(bm);
+  free(h);
+  free(pinned);
+  TEST_DONE();
+}
+
+// frame memory backed by huge pages, with fallback
+void
+testPoolMemory (void)
+{
+  BM_HugePages requests[] = { BM_HUGE_PAGES_NONE, BM_HUGE_PAGES_TRANSPARENT, BM_HUGE_PAGES_EXPLICIT };
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolMemoryConfig config, actual;
+  char *expected = malloc(sizeof(char) * 512);
+  int r, i;
+  testName = "Testing huge page backed frame memory";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+
+  for (r = 0; r < 3; r++)
+    {
+      config.hugePages = requests[r];
+      config.lockMemory = (r > 0);
+      CHECK(initBufferPoolWithMemory(bm, "testbuffer.bin", 3, RS_LRU, NULL, &config));
+      CHECK(getPoolMemory(bm, &actual));
+      ASSERT_TRUE(actual.hugePages <= requests[r], "a pool never gets more than it asked for");
+      if (r == 0)
+        ASSERT_TRUE(!actual.lockMemory, "memory is only locked on request");
+
+      for (i = 0; i < 10; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          sprintf(expected, "%s-%i", "Page", i);
+          ASSERT_EQUALS_STRING(expected, h->data, "reading page into huge page backed frame");
+          CHECK(unpinPage(bm, h));
+        }
+
+      // a resize allocates the new frames the same way
+      CHECK(resizeBufferPool(bm, 1000));
+      CHECK(getPoolMemory(bm, &actual));
+      ASSERT_TRUE(actual.hugePages <= requests[r], "resized pool keeps its kind of memory");
+      CHECK(pinPage(bm, h, 9));
+      ASSERT_EQUALS_STRING("Page-9", h->data, "page moved to the resized frames");
+      CHECK(unpinPage(bm, h));
+      CHECK(shutdownBufferPool(bm));
+    }
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(expected);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// asynchronous reads and writes through the storage manager's I/O queue
+void
+testAsyncIO (void)
+{
+  SM_FileHandle fh;
+  SM_AsyncIO aio;
+  SM_IOCompletion completions[8];
+  SM_PageHandle pages[4];
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  char *expected = malloc(sizeof(char) * 512);
+  int i, reaped, total;
+  testName = "Testing asynchronous I/O";
+
+  for (i = 0; i < 4; i++)
+    pages[i] = malloc(PAGE_SIZE);
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  CHECK(initAsyncIO(&aio, 2));
+
+  // a run of three pages and a single page after it, both in flight at once
+  for (i = 0; i < 4; i++)
+    sprintf(pages[i], "%s-%i", "Async", i);
+  CHECK(submitWrite(&aio, &fh, 0, 3, pages, (void *) 1));
+  CHECK(submitWrite(&aio, &fh, 3, 1, &pages[3], (void *) 2));
+  ASSERT_EQUALS_INT(RC_IO_QUEUE_FULL, submitWrite(&aio, &fh, 4, 1, pages, NULL), "queue holds queueDepth requests");
+  ASSERT_EQUALS_INT(1, fh.totalNumPages, "writes in flight do not extend the file yet");
+  for (total = 0; total < 2; total += reaped)
+    {
+      CHECK(reapCompletions(&aio, completions + total, 8 - total, 2 - total, &reaped));
+      for (i = total; i < total + reaped; i++)
+        ASSERT_EQUALS_INT(RC_OK, completions[i].rc, "write completed");
+    }
+  ASSERT_EQUALS_INT(0, pendingAsyncIO(&aio), "all writes reaped");
+  ASSERT_EQUALS_INT(4, fh.totalNumPages, "completed writes extend the file");
+  ASSERT_EQUALS_INT(RC_INVALID_PAGE_RANGE, submitWrite(&aio, &fh, 5, 1, pages, NULL), "a write may not leave a gap");
+
+  // read back in reverse, the second read reaches past the end of the file
+  for (i = 0; i < 4; i++)
+    memset(pages[i], 0, PAGE_SIZE);
+  CHECK(submitRead(&aio, &fh, 2, 2, &pages[2], (void *) 3));
+  CHECK(submitRead(&aio, &fh, 0, 2, pages, (void *) 4));
+  for (total = 0; total < 2; total += reaped)
+    CHECK(reapCompletions(&aio, completions + total, 8 - total, 1, &reaped));
+  for (i = 0; i < 4; i++)
+    {
+      sprintf(expected, "%s-%i", "Async", i);
+      ASSERT_EQUALS_STRING(expected, pages[i], "reading page asynchronously");
+    }
+  CHECK(submitRead(&aio, &fh, 3, 3, pages, (void *) 5));
+  CHECK(reapCompletions(&aio, completions, 8, 1, &reaped));
+  ASSERT_EQUALS_INT(1, reaped, "one read reaped");
+  ASSERT_TRUE(completions[0].tag == (void *) 5, "completion carries the tag");
+  ASSERT_EQUALS_INT(1, completions[0].numOfPages, "read stops at the end of the file");
+  ASSERT_EQUALS_INT(RC_READ_NON_EXISTING_PAGE, completions[0].rc, "short read is reported");
+
+  CHECK(shutdownAsyncIO(&aio));
+  CHECK(closePageFile(&fh));
+
+  // the pool reads batches and flushes runs through its own queue
+  CHECK(initBufferPool(bm, "testbuffer.bin", 8, RS_LRU, NULL));
+  for (i = 0; i < 8; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(h->data, "%s-%i", "Flushed", i);
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(forceFlushPool(bm));
+  ASSERT_EQUALS_INT(8, getNumWriteIO(bm), "each dirty page written once");
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 8, RS_LRU, NULL));
+  CHECK(prefetchPages(bm, 0, 8));
+  for (i = 0; i < 8; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Flushed", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "reading page written by an asynchronous flush");
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_INT(8, getNumReadIO(bm), "each prefetched page read once");
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  for (i = 0; i < 4; i++)
+    free(pages[i]);
+  free(expected);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// state shared by the threads of testConcurrentReads
+typedef struct ConcurrentReadArgs
+{
+  SM_FileHandle *fh;
+  unsigned int seed;
+  int errors;
+} ConcurrentReadArgs;
+
+// read random pages through a shared handle and check each one
+void *
+concurrentReadWorker (void *arg)
+{
+  ConcurrentReadArgs *args = (ConcurrentReadArgs *) arg;
+  char page[PAGE_SIZE];
+  char expected[PAGE_SIZE];
+  int i;
+
+  for (i = 0; i < CONCURRENT_PINS; i++)
+    {
+      int pageNum = rand_r(&args->seed) % CONCURRENT_PAGES;
+      sprintf(expected, "%s-%i", "Page", pageNum);
+      if (readBlock(pageNum, args->fh, page) != RC_OK || strcmp(expected, page) != 0)
+        args->errors++;
+    }
+  return NULL;
+}
+
+// pages are read at their offset, so threads can share a handle and handles are independent
+void
+testConcurrentReads (void)
+{
+  pthread_t threads[CONCURRENT_THREADS];
+  ConcurrentReadArgs args[CONCURRENT_THREADS];
+  BM_BufferPool *bm = MAKE_POOL();
+  SM_FileHandle shared, other;
+  char *page = malloc(PAGE_SIZE);
+  int i, errors = 0;
+  testName = "Testing concurrent reads of one page file";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, CONCURRENT_PAGES);
+  CHECK(openPageFile("testbuffer.bin", &shared));
+  CHECK(openPageFile("testbuffer.bin", &other));
+  ASSERT_EQUALS_INT(CONCURRENT_PAGES, shared.totalNumPages, "page count taken from the file size");
+
+  for (i = 0; i < CONCURRENT_THREADS; i++)
+    {
+      args[i].fh = &shared;
+      args[i].seed = 31 * (i + 1);
+      args[i].errors = 0;
+      ASSERT_TRUE(pthread_create(&threads[i], NULL, concurrentReadWorker, &args[i]) == 0, "starting reader thread");
+    }
+  for (i = 0; i < CONCURRENT_THREADS; i++)
+    {
+      pthread_join(threads[i], NULL);
+      errors += args[i].errors;
+    }
+  ASSERT_EQUALS_INT(0, errors, "every read returned the requested page");
+
+  // the second handle keeps its own position and sees what the first one writes
+  CHECK(readBlock(3, &other, page));
+  CHECK(readBlock(7, &shared, page));
+  ASSERT_EQUALS_INT(3, getBlockPos(&other), "handles keep their own position");
+  sprintf(page, "%s-%i", "Rewritten", 7);
+  CHECK(writeBlock(7, &shared, page));
+  memset(page, 0, PAGE_SIZE);
+  CHECK(readBlock(7, &other, page));
+  ASSERT_EQUALS_STRING("Rewritten-7", page, "write through one handle is seen by the other");
+
+  // the page right after the end of the file reads as an empty page
+  memset(page, 'x', PAGE_SIZE);
+  CHECK(readBlock(CONCURRENT_PAGES, &other, page));
+  ASSERT_TRUE(page[0] == '\0' && page[PAGE_SIZE - 1] == '\0', "page beyond the end of the file is zeroed");
+
+  CHECK(closePageFile(&shared));
+  CHECK(closePageFile(&other));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(page);
+  free(bm);
+  TEST_DONE();
+}
+
+// memory-mapped page files and zero-copy read-only pins
+void
+testMappedStorage (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle *ro = MAKE_PAGE_HANDLE();
+  SM_FileHandle fh, writer;
+  SM_PageHandle mapped;
+  char *page = malloc(PAGE_SIZE);
+  char *expected = malloc(sizeof(char) * 512);
+  int i;
+  testName = "Testing memory-mapped storage";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+
+  // a mapped handle serves pages from the mapping and sees writes made through other handles
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  CHECK(openPageFile("testbuffer.bin", &writer));
+  CHECK(mapPageFile(&fh));
+  CHECK(adviseAccessPattern(&fh, SM_ACCESS_RANDOM));
+  CHECK(getMappedBlock(4, &fh, &mapped));
+  ASSERT_EQUALS_STRING("Page-4", mapped, "zero-copy page from the mapping");
+  ASSERT_TRUE(isMappedBlock(&fh, mapped), "page points into the mapping");
+  sprintf(page, "%s-%i", "Remapped", 4);
+  CHECK(writeBlock(4, &writer, page));
+  ASSERT_EQUALS_STRING("Remapped-4", mapped, "mapping shares the page cache");
+  sprintf(page, "%s-%i", "Appended", 10);
+  CHECK(writeBlock(10, &writer, page));
+  fh.totalNumPages = writer.totalNumPages;
+  CHECK(readBlock(10, &fh, page));
+  ASSERT_EQUALS_STRING("Appended-10", page, "mapping grows with the file");
+  ASSERT_ERROR(getMappedBlock(11, &fh, &mapped), "pages beyond the end of the file are not mapped");
+  CHECK(prefetchBlocks(0, 11, &fh));
+  CHECK(closePageFile(&fh));
+  sprintf(page, "%s-%i", "Page", 4);
+  CHECK(writeBlock(4, &writer, page));
+  CHECK(closePageFile(&writer));
+
+  // a mapped pool pins non-resident pages read-only without using frames
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  CHECK(setPoolStorageMode(bm, BM_STORAGE_MAPPED, BM_ACCESS_SEQUENTIAL));
+  for (i = 0; i < 10; i++)
+    {
+      CHECK(pinPageReadOnly(bm, ro, i));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, ro->data, "reading zero-copy page");
+      CHECK(unpinPage(bm, ro));
+    }
+  ASSERT_EQUALS_FRAMES(bm, 3, "-1,-1,-1", "zero-copy pins use no frames");
+  ASSERT_EQUALS_INT(0, getNumReadIO(bm), "zero-copy pins read nothing");
+
+  // resident pages are pinned in their frame, misses copy from the mapping
+  CHECK(pinPage(bm, h, 2));
+  ASSERT_EQUALS_STRING("Page-2", h->data, "miss copies from the mapping");
+  sprintf(h->data, "%s-%i", "Dirty", 2);
+  CHECK(markDirty(bm, h));
+  CHECK(pinPageReadOnly(bm, ro, 2));
+  ASSERT_TRUE(ro->data == h->data, "resident page is pinned in its frame");
+  ASSERT_EQUALS_POOL("[2x2],[-1 0],[-1 0]", bm, "read-only pin of a resident page counts");
+  CHECK(unpinPage(bm, ro));
+  CHECK(unpinPage(bm, h));
+
+  CHECK(pinPageReadOnly(bm, ro, 7));
+  ASSERT_ERROR(markDirty(bm, ro), "zero-copy pin cannot be marked dirty");
+  ASSERT_ERROR(shutdownBufferPool(bm), "shutdown waits for zero-copy pins");
+  ASSERT_ERROR(setPoolStorageMode(bm, BM_STORAGE_POSITIONAL, BM_ACCESS_NORMAL), "mapping stays while zero-copy pins are held");
+  CHECK(unpinPage(bm, ro));
+  CHECK(setPoolStorageMode(bm, BM_STORAGE_POSITIONAL, BM_ACCESS_NORMAL));
+  CHECK(pinPageReadOnly(bm, ro, 7));
+  ASSERT_EQUALS_FRAMES(bm, 3, "2,7,-1", "positional mode pins read-only pages in frames");
+  CHECK(unpinPage(bm, ro));
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  CHECK(setPoolStorageMode(bm, BM_STORAGE_MAPPED, BM_ACCESS_NORMAL));
+  CHECK(pinPageReadOnly(bm, ro, 2));
+  ASSERT_EQUALS_STRING("Dirty-2", ro->data, "flushed page seen through the mapping");
+  CHECK(unpinPage(bm, ro));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(page);
+  free(expected);
+  free(bm);
+  free(h);
+  free(ro);
+  TEST_DONE();
+}
+
+// storage and LRU hits are traced into the ring of the thread, and a dump decodes to the same events
+void
+testTracing (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  TraceRecord *records = malloc(TRACE_RING_SIZE * sizeof(TraceRecord));
+  TraceRecord *loaded;
+  char line[256];
+  int numOfRecords, numOfLoaded, i, reads = 0, hits = 0;
+  bool ordered = TRUE;
+  testName = "Testing event tracing";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 5);
+
+  // two misses read pages 3 and 4, the second pin of page 3 is a hit
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  CHECK(pinPage(bm, h, 3));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 4));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 3));
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  numOfRecords = traceSnapshot(records, TRACE_RING_SIZE);
+  for (i = 0; i < numOfRecords; i++)
+    {
+      if (i > 0 && records[i].timeNanos < records[i - 1].timeNanos)
+        ordered = FALSE;
+      if (records[i].event == TRACE_READ_BLOCK && records[i].args[1] == RC_OK)
+        reads++;
+      if (records[i].event == TRACE_LRU_HIT && records[i].args[0] == 3)
+        hits++;
+    }
+  ASSERT_TRUE(ordered, "snapshot is ordered by time");
+  if (traceLevel() >= TRACE_LEVEL_DEBUG)
+    {
+      ASSERT_TRUE(reads >= 2, "reads are traced");
+      ASSERT_TRUE(hits >= 1, "LRU hits are traced");
+      traceFormat(&records[numOfRecords - 1], line, sizeof(line));
+      ASSERT_TRUE(strstr(line, "DEBUG") != NULL, "record formats with its level");
+    }
+  else
+    ASSERT_EQUALS_INT(0, reads + hits, "debug events are compiled out");
+
+  // a dump holds at least the events of the snapshot and decodes in time order
+  CHECK(traceDump("testtrace.bin"));
+  CHECK(traceLoadDump("testtrace.bin", &loaded, &numOfLoaded));
+  ASSERT_TRUE(numOfLoaded >= numOfRecords, "dump holds the traced events");
+  for (i = 1; i < numOfLoaded; i++)
+    if (loaded[i - 1].timeNanos > loaded[i].timeNanos)
+      ordered = FALSE;
+  ASSERT_TRUE(ordered, "dump decodes in time order");
+  free(loaded);
+  remove("testtrace.bin");
+  ASSERT_ERROR(traceLoadDump("testbuffer.bin", &loaded, &numOfLoaded), "a page file is not a dump");
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(records);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// ensureCapacity and appendEmptyBlock extend the file in one step, with exact or geometric growth
+void
+testFileGrowth (void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle page = malloc(PAGE_SIZE);
+  SM_PageHandle zeros = calloc(PAGE_SIZE, 1);
+  int policy;
+  testName = "Testing file growth";
+
+  for (policy = SM_GROWTH_EXACT; policy <= SM_GROWTH_GEOMETRIC; policy++)
+    {
+      CHECK(createPageFile("testbuffer.bin"));
+      CHECK(openPageFile("testbuffer.bin", &fh));
+      CHECK(setGrowthPolicy(&fh, policy));
+
+      CHECK(ensureCapacity(1000, &fh));
+      ASSERT_EQUALS_INT(1000, fh.totalNumPages, "file grows to the requested capacity");
+      CHECK(ensureCapacity(10, &fh));
+      ASSERT_EQUALS_INT(1000, fh.totalNumPages, "a file that is long enough is left alone");
+      CHECK(readBlock(999, &fh, page));
+      ASSERT_TRUE(memcmp(page, zeros, PAGE_SIZE) == 0, "new pages read as zeros");
+
+      CHECK(appendEmptyBlock(&fh));
+      ASSERT_EQUALS_INT(1001, fh.totalNumPages, "append adds one page");
+      ASSERT_EQUALS_INT(1000, getBlockPos(&fh), "appended page becomes the current page");
+      sprintf(page, "%s-%i", "Page", 1001);
+      CHECK(writeBlock(1001, &fh, page));
+      CHECK(closePageFile(&fh));
+
+      // the number of pages follows from the size of the file, not from the space reserved beyond it
+      CHECK(openPageFile("testbuffer.bin", &fh));
+      ASSERT_EQUALS_INT(1002, fh.totalNumPages, "reopened file has the pages written");
+      CHECK(readBlock(1001, &fh, page));
+      ASSERT_EQUALS_STRING("Page-1001", page, "written page survives");
+      CHECK(closePageFile(&fh));
+      CHECK(destroyPageFile("testbuffer.bin"));
+    }
+
+  free(page);
+  free(zeros);
+  TEST_DONE();
+}
+
+// runs of pages are written from and read into separate buffers with one call, also through a mapping
+void
+testVectoredBlocks (void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle buffers[6];
+  char *expected = malloc(sizeof(char) * 64);
+  int mapped, i;
+  testName = "Testing vectored block reads and writes";
+
+  for (i = 0; i < 6; i++)
+    buffers[i] = malloc(PAGE_SIZE);
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  for (i = 0; i < 6; i++)
+    sprintf(buffers[i], "%s-%i", "Page", i);
+  CHECK(writeBlocks(0, 6, &fh, buffers));
+  ASSERT_EQUALS_INT(6, fh.totalNumPages, "run extends the file");
+
+  for (mapped = 0; mapped <= 1; mapped++)
+    {
+      if (mapped)
+        CHECK(mapPageFile(&fh));
+      for (i = 0; i < 6; i++)
+        memset(buffers[i], 0, PAGE_SIZE);
+      // buffers 4 and 5 get pages 2 to 3, buffers 0 to 3 pages 1 to 4
+      CHECK(readBlocks(2, 2, &fh, buffers + 4));
+      CHECK(readBlocks(1, 4, &fh, buffers));
+      ASSERT_EQUALS_INT(4, getBlockPos(&fh), "position is the last page read");
+      for (i = 0; i < 4; i++)
+        {
+          sprintf(expected, "%s-%i", "Page", i + 1);
+          ASSERT_EQUALS_STRING(expected, buffers[i], "page read into its buffer");
+        }
+      ASSERT_EQUALS_STRING("Page-2", buffers[4], "second run starts at its page");
+      ASSERT_EQUALS_STRING("Page-3", buffers[5], "second run ends at its page");
+      ASSERT_ERROR(readBlocks(4, 3, &fh, buffers), "run past the end of the file");
+      ASSERT_ERROR(readBlocks(-1, 2, &fh, buffers), "run before the start of the file");
+    }
+  CHECK(closePageFile(&fh));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  for (i = 0; i < 6; i++)
+    free(buffers[i]);
+  free(expected);
+  TEST_DONE();
+}
+
+// flip one byte of a page in testbuffer.bin behind the storage manager's back
+void
+corruptPage (int pageNum)
+{
+  FILE *file = fopen("testbuffer.bin", "r+b");
+  int c;
+  fseek(file, (long) pageNum * PAGE_SIZE + 100, SEEK_SET);
+  c = fgetc(file);
+  fseek(file, (long) pageNum * PAGE_SIZE + 100, SEEK_SET);
+  fputc(c ^ 0x40, file);
+  fclose(file);
+}
+
+// overwrite a page of testbuffer.bin with zeros, as a lost write would leave it
+void
+zeroPage (int pageNum)
+{
+  FILE *file = fopen("testbuffer.bin", "r+b");
+  char zeros[PAGE_SIZE];
+
+  memset(zeros, 0, PAGE_SIZE);
+  fseek(file, (long) pageNum * PAGE_SIZE, SEEK_SET);
+  fwrite(zeros, 1, PAGE_SIZE, file);
+  fclose(file);
+}
+
+// pages written with checksums are verified when read, by the storage manager and by a verifying pool
+void
+testPageChecksums (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle pages[2];
+  PageNumber pageNums[] = { 1, 2 };
+  SM_FileHandle fh;
+  SM_PageHandle page = malloc(PAGE_SIZE);
+  SM_PageHandle runPages[2];
+  int i;
+  testName = "Testing page checksums";
+
+  ASSERT_EQUALS_INT((int) 0xE3069283u, (int) computeCRC32C("123456789", 9), "CRC32C check value");
+  memset(page, 0, PAGE_SIZE);
+  ASSERT_EQUALS_INT(RC_CHECKSUM_MISMATCH, verifyBlock(page), "a page of zeros has no checksum");
+
+  // the storage manager stamps pages it writes and checks pages it reads
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  CHECK(setChecksumMode(&fh, SM_CHECKSUM_VERIFY));
+  for (i = 0; i < 4; i++)
+    {
+      memset(page, 0, PAGE_SIZE);
+      sprintf(page, "%s-%i", "Page", i);
+      CHECK(writeBlock(i, &fh, page));
+    }
+  ASSERT_EQUALS_INT(0, page[PAGE_CHECKSUM_OFFSET], "the checksum goes into a copy of the page");
+  CHECK(writeBlocks(3, 1, &fh, &page));
+  ASSERT_EQUALS_INT(0, page[PAGE_CHECKSUM_OFFSET], "a run of pages is stamped in copies too");
+  CHECK(readBlock(3, &fh, page));
+  CHECK(verifyBlock(page));
+  CHECK(appendEmptyBlock(&fh));
+  CHECK(ensureCapacity(7, &fh));
+  CHECK(readBlock(4, &fh, page));
+  runPages[0] = runPages[1] = page;
+  CHECK(readBlocks(5, 2, &fh, runPages));
+  CHECK(readBlock(2, &fh, page));
+  ASSERT_EQUALS_STRING("Page-2", page, "verified page reads back");
+  corruptPage(2);
+  ASSERT_EQUALS_INT(RC_CHECKSUM_MISMATCH, readBlock(2, &fh, page), "corrupt page is detected");
+  ASSERT_EQUALS_INT(RC_CHECKSUM_MISMATCH, verifyBlock(page), "corrupt page fails verification");
+  zeroPage(3);
+  ASSERT_EQUALS_INT(RC_CHECKSUM_MISMATCH, readBlock(3, &fh, page), "a written page that reads as zeros is detected");
+  CHECK(writeBlock(5, &fh, page));
+  zeroPage(5);
+  ASSERT_EQUALS_INT(RC_CHECKSUM_MISMATCH, readBlock(5, &fh, page), "an appended page stops being blank once written");
+  CHECK(readBlock(6, &fh, page));
+  CHECK(setChecksumMode(&fh, SM_CHECKSUM_NONE));
+  CHECK(readBlock(2, &fh, page));
+  CHECK(closePageFile(&fh));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  CHECK(setChecksumMode(&fh, SM_CHECKSUM_VERIFY));
+  ASSERT_EQUALS_INT(RC_CHECKSUM_MISMATCH, readBlock(6, &fh, page), "pages a file had when opened count as written");
+  CHECK(readBlock(7, &fh, page));
+  CHECK(closePageFile(&fh));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  // a verifying pool fails the pins of a corrupt page, a pool that only writes checksums does not look
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  CHECK(setPoolChecksumMode(bm, BM_CHECKSUM_WRITE));
+  for (i = 0; i < 4; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(h->data, "%s-%i", "Page", i);
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(shutdownBufferPool(bm));
+  corruptPage(2);
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  CHECK(pinPage(bm, h, 2));
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  CHECK(setPoolChecksumMode(bm, BM_CHECKSUM_VERIFY));
+  CHECK(pinPage(bm, h, 1));
+  ASSERT_EQUALS_STRING("Page-1", h->data, "intact page pins");
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(RC_CHECKSUM_MISMATCH, pinPage(bm, h, 2), "pin of a corrupt page fails");
+  ASSERT_EQUALS_INT(RC_CHECKSUM_MISMATCH, pinPage(bm, h, 2), "corrupt page stays detected while resident");
+  ASSERT_EQUALS_INT(RC_CHECKSUM_MISMATCH, pinPages(bm, pageNums, pages, 2), "batch with a corrupt page fails");
+  ASSERT_EQUALS_POOL("[1 0],[2 0],[-1 0]", bm, "failed pins hold no pin");
+  CHECK(setPoolStorageMode(bm, BM_STORAGE_MAPPED, BM_ACCESS_NORMAL));
+  ASSERT_EQUALS_INT(RC_CHECKSUM_MISMATCH, pinPageReadOnly(bm, h, 2), "zero-copy pin of a corrupt page fails");
+  CHECK(pinPageReadOnly(bm, h, 3));
+  ASSERT_EQUALS_STRING("Page-3", h->data, "intact page pins zero-copy");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(page);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// size of testbuffer.bin in bytes
+long
+pageFileSize (void)
+{
+  FILE *file = fopen("testbuffer.bin", "rb");
+  long size;
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  fclose(file);
+  return size;
+}
+
+// fill a page with bytes that do not compress
+void
+fillNoise (SM_PageHandle page, int length)
+{
+  int i;
+  for (i = 0; i < length; i++)
+    page[i] = (char) (rand() >> 7);
+}
+
+// a compressed page file reads and writes like a plain one, through the storage manager and a pool
+void
+testCompressedPages (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  SM_FileHandle fh;
+  SM_AsyncIO aio;
+  SM_IOCompletion completions[4];
+  SM_PageHandle pages[4];
+  SM_PageHandle page = malloc(PAGE_SIZE);
+  SM_PageHandle noise = malloc(PAGE_SIZE);
+  SM_PageHandle zeros = calloc(PAGE_SIZE, 1);
+  char *expected = malloc(sizeof(char) * 64);
+  unsigned int fields[2];
+  unsigned long long mapOffset;
+  int i, reaped;
+  testName = "Testing compressed page files";
+
+  srand(42);
+  for (i = 0; i < 4; i++)
+    pages[i] = malloc(PAGE_SIZE);
+
+  CHECK(createCompressedPageFile("testbuffer.bin"));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_EQUALS_INT(1, fh.totalNumPages, "new compressed file has one page");
+  CHECK(readBlock(0, &fh, page));
+  ASSERT_TRUE(memcmp(page, zeros, PAGE_SIZE) == 0, "first page reads as zeros");
+  ASSERT_EQUALS_INT(RC_MAP_FAILED, mapPageFile(&fh), "compressed file can not be mapped");
+
+  for (i = 0; i < 200; i++)
+    {
+      memset(page, 0, PAGE_SIZE);
+      sprintf(page, "%s-%i", "Page", i);
+      CHECK(writeBlock(i, &fh, page));
+    }
+  fillNoise(noise, PAGE_SIZE);
+  CHECK(writeBlock(200, &fh, noise));
+  ASSERT_EQUALS_INT(201, fh.totalNumPages, "writes extend the file");
+  ASSERT_TRUE(pageFileSize() < 201 * PAGE_SIZE / 4, "compressed file is smaller than its pages");
+  CHECK(readBlock(200, &fh, page));
+  ASSERT_TRUE(memcmp(page, noise, PAGE_SIZE) == 0, "page that does not compress reads back");
+
+  // page 5 outgrows its slot and moves, page 200 shrinks in place; their neighbours are left alone
+  fillNoise(noise, PAGE_SIZE / 2);
+  memset(noise + PAGE_SIZE / 2, 0, PAGE_SIZE / 2);
+  CHECK(writeBlock(5, &fh, noise));
+  memset(page, 0, PAGE_SIZE);
+  sprintf(page, "%s-%i", "Page", 200);
+  CHECK(writeBlock(200, &fh, page));
+  CHECK(readBlock(5, &fh, page));
+  ASSERT_TRUE(memcmp(page, noise, PAGE_SIZE) == 0, "grown page reads back");
+  CHECK(readBlock(200, &fh, page));
+  ASSERT_EQUALS_STRING("Page-200", page, "shrunk page reads back");
+  for (i = 4; i <= 6; i += 2)
+    {
+      CHECK(readBlock(i, &fh, page));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, page, "neighbour of a rewritten page");
+    }
+
+  // growing past the map's first region moves the map
+  CHECK(ensureCapacity(3000, &fh));
+  ASSERT_EQUALS_INT(3000, fh.totalNumPages, "file grows to the requested capacity");
+  CHECK(readBlock(2999, &fh, page));
+  ASSERT_TRUE(memcmp(page, zeros, PAGE_SIZE) == 0, "new pages read as zeros");
+  CHECK(appendEmptyBlock(&fh));
+  memset(page, 0, PAGE_SIZE);
+  sprintf(page, "%s-%i", "Page", 3000);
+  CHECK(writeBlock(3000, &fh, page));
+  CHECK(closePageFile(&fh));
+
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_EQUALS_INT(3001, fh.totalNumPages, "reopened file keeps its pages");
+  CHECK(readBlocks(197, 4, &fh, pages));
+  for (i = 0; i < 4; i++)
+    {
+      sprintf(expected, "%s-%i", "Page", 197 + i);
+      ASSERT_EQUALS_STRING(expected, pages[i], "reopened page reads back");
+    }
+  CHECK(readBlock(5, &fh, page));
+  ASSERT_TRUE(memcmp(page, noise, PAGE_SIZE) == 0, "moved page survives reopening");
+  CHECK(readBlock(3000, &fh, page));
+  ASSERT_EQUALS_STRING("Page-3000", page, "page after the moved map survives");
+
+  // asynchronous requests and checksums work on the decompressed pages
+  CHECK(setChecksumMode(&fh, SM_CHECKSUM_VERIFY));
+  CHECK(initAsyncIO(&aio, 2));
+  for (i = 0; i < 4; i++)
+    {
+      memset(pages[i], 0, PAGE_SIZE);
+      sprintf(pages[i], "%s-%i", "Async", i);
+    }
+  CHECK(submitWrite(&aio, &fh, 10, 4, pages, (void *) 1));
+  CHECK(reapCompletions(&aio, completions, 4, 1, &reaped));
+  ASSERT_EQUALS_INT(RC_OK, completions[0].rc, "compressed write completed");
+  ASSERT_EQUALS_INT(0, pages[0][PAGE_CHECKSUM_OFFSET], "an asynchronous write stamps copies of its pages");
+  for (i = 0; i < 4; i++)
+    memset(pages[i], 0, PAGE_SIZE);
+  CHECK(submitRead(&aio, &fh, 10, 4, pages, (void *) 2));
+  CHECK(reapCompletions(&aio, completions, 4, 1, &reaped));
+  ASSERT_EQUALS_INT(RC_OK, completions[0].rc, "compressed read verified");
+  for (i = 0; i < 4; i++)
+    {
+      sprintf(expected, "%s-%i", "Async", i);
+      ASSERT_EQUALS_STRING(expected, pages[i], "reading compressed page asynchronously");
+    }
+  CHECK(shutdownAsyncIO(&aio));
+  CHECK(closePageFile(&fh));
+
+  // a pool on a compressed file
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  for (i = 0; i < 6; i++)
+    {
+      CHECK(pinPage(bm, h, 20 + i));
+      sprintf(expected, "%s-%i", "Page", 20 + i);
+      ASSERT_EQUALS_STRING(expected, h->data, "pool reads compressed page");
+      sprintf(h->data, "%s-%i", "Pool", 20 + i);
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(shutdownBufferPool(bm));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  for (i = 0; i < 6; i++)
+    {
+      CHECK(readBlock(20 + i, &fh, page));
+      sprintf(expected, "%s-%i", "Pool", 20 + i);
+      ASSERT_EQUALS_STRING(expected, page, "pool writes compressed page");
+    }
+  CHECK(closePageFile(&fh));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  // a compressed file whose map can not be read is refused, not opened as a plain file
+  CHECK(createCompressedPageFile("testbuffer.bin"));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  for (i = 0; i < 4; i++)
+    CHECK(writeBlock(i, &fh, pages[i]));
+  CHECK(closePageFile(&fh));
+  ASSERT_TRUE(truncate("testbuffer.bin", PAGE_SIZE + 16) == 0, "map cut short");
+  ASSERT_EQUALS_INT(RC_READ_FAILED, openPageFile("testbuffer.bin", &fh), "compressed file without its map is refused");
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  // a plain file whose first page starts like a compressed header stays a plain file
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  memset(page, 0, PAGE_SIZE);
+  memcpy(page, "SMLZPGF1", 8);
+  fields[0] = 1;
+  fields[1] = 1024;
+  memcpy(page + 8, fields, sizeof(fields));
+  mapOffset = PAGE_SIZE;
+  memcpy(page + 16, &mapOffset, sizeof(mapOffset));
+  CHECK(writeBlock(0, &fh, page));
+  CHECK(ensureCapacity(3, &fh));
+  CHECK(closePageFile(&fh));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_EQUALS_INT(3, fh.totalNumPages, "page count of a plain file follows from its size");
+  CHECK(readBlock(0, &fh, noise));
+  ASSERT_TRUE(memcmp(page, noise, PAGE_SIZE) == 0, "first page of a plain file reads as written");
+  CHECK(closePageFile(&fh));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  for (i = 0; i < 4; i++)
+    free(pages[i]);
+  free(page);
+  free(noise);
+  free(zeros);
+  free(expected);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
@@ -0,0 +1,46 @@
+/** @file trace_decode.c
+*  @brief Prints a trace dump as text.
+*
+*  Usage: trace_decode <dump file> [minimum level]
+*
+*  Reads a dump written by traceDump or by the crash handler installed with
+*  traceDumpOnCrash and prints its events, one per line and ordered by time.
+*  A level (1 errors, 2 warnings, 3 info, 4 debug) limits the output to the
+*  events at that level or more severe.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "trace_log.h"
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2 || argc > 3)
+	{
+		fprintf(stderr, "usage: %s <dump file> [minimum level]\n", argv[0]);
+		return 2;
+	}
+	int maxLevel = (argc == 3) ? atoi(argv[2]) : TRACE_LEVEL_DEBUG;
+
+	TraceRecord *records;
+	int numOfRecords;
+	RC rc = traceLoadDump(argv[1], &records, &numOfRecords);
+	if (rc != RC_OK)
+	{
+		fprintf(stderr, "%s: can not read trace dump %s (error %d)\n", argv[0], argv[1], rc);
+		return 1;
+	}
+
+	char line[256];
+	for (int i = 0; i < numOfRecords; i++)
+	{
+		if (records[i].level <= maxLevel)
+		{
+			traceFormat(&records[i], line, sizeof(line));
+			printf("%s\n", line);
+		}
+	}
+	free(records);
+	return 0;
+}
@@ -0,0 +1,405 @@
+#include "trace_log.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+Every thread records into a ring of its own, so recording takes no latch: the ring has a single writer, which stores
+the record and then publishes it by advancing written. A reader copies the published records and drops those the
+writer may have overwritten meanwhile. Rings are linked into a registry that is never shortened; when a thread
+exits its ring is marked free and handed to the next thread that starts recording, so the events of exited threads
+stay visible until they are overwritten.
+*/
+typedef struct TraceRing {
+	TraceRecord records[TRACE_RING_SIZE];
+	atomic_ulong written; // number of records ever written into the ring
+	atomic_int inUse; // a live thread records into the ring
+	struct TraceRing *next;
+} TraceRing;
+
+/*
+A dump is a TraceDumpHeader followed by numOfRecords records, in no particular order.
+*/
+typedef struct TraceDumpHeader {
+	char magic[8];
+	unsigned int recordSize;
+	unsigned int numOfRecords;
+} TraceDumpHeader;
+
+static const char traceMagic[8] = { 'B', 'M', 'T', 'R', 'A', 'C', 'E', '1' };
+
+static pthread_mutex_t registryLatch = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic(TraceRing *) registry;
+static atomic_uint nextThread;
+static pthread_once_t threadKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t threadKey;
+static _Thread_local TraceRing *localRing;
+static _Thread_local unsigned int localThread;
+static char crashDumpFile[256];
+
+/*
+Names of the events and of their arguments, as trace_decode prints them.
+*/
+typedef struct TraceEventInfo {
+	const char *name;
+	const char *args[TRACE_NUM_ARGS];
+} TraceEventInfo;
+
+static const TraceEventInfo eventInfo[TRACE_NUM_EVENTS] = {
+	{ "createPageFile", { "rc", NULL, NULL } },
+	{ "openPageFile", { "rc", "pages", NULL } },
+	{ "readBlock", { "page", "rc", NULL } },
+	{ "writeBlock", { "page", "rc", NULL } },
+	{ "getBlockPos", { "page", NULL, NULL } },
+	{ "appendEmptyBlock", { "page", "rc", NULL } },
+	{ "ensureCapacity", { "pages", "total", "rc" } },
+	{ "lruHit", { "page", "frame", NULL } },
+	{ "noFreeFrame", { "page", NULL, NULL } },
+	{ "readBlocks", { "page", "count", "rc" } },
+	{ "writeBlocks", { "page", "count", "rc" } }
+};
+
+static const char *levelNames[] = { "NONE", "ERROR", "WARN", "INFO", "DEBUG" };
+
+/**
+*
+* This function runs when a thread that recorded events exits and gives its ring back for reuse.
+*
+*/
+static void releaseRing(void *arg)
+{
+	TraceRing *ring = arg;
+	atomic_store_explicit(&ring->inUse, 0, memory_order_release);
+}
+
+static void createThreadKey(void)
+{
+	pthread_key_create(&threadKey, releaseRing);
+}
+
+/**
+*
+* This function returns the ring of the calling thread, taking a free one or adding a new one to the registry on
+* the thread's first event.
+*
+*/
+static TraceRing *threadRing(void)
+{
+	if (localRing) {
+		return localRing;
+	}
+
+	TraceRing *ring = NULL;
+	pthread_mutex_lock(&registryLatch);
+	for (TraceRing *candidate = atomic_load(&registry); candidate; candidate = candidate->next) {
+		int expected = 0;
+		if (atomic_compare_exchange_strong(&candidate->inUse, &expected, 1)) {
+			ring = candidate;
+			break;
+		}
+	}
+	if (!ring) {
+		ring = calloc(1, sizeof(TraceRing));
+		if (ring) {
+			atomic_store(&ring->inUse, 1);
+			ring->next = atomic_load(&registry);
+			atomic_store(&registry, ring);
+		}
+	}
+	pthread_mutex_unlock(&registryLatch);
+	if (!ring) {
+		return NULL;
+	}
+
+	pthread_once(&threadKeyOnce, createThreadKey);
+	pthread_setspecific(threadKey, ring);
+	localThread = atomic_fetch_add(&nextThread, 1) + 1;
+	localRing = ring;
+	return ring;
+}
+
+/**
+*
+* This function records one event in the ring of the calling thread. It is called through TRACE_EVENT.
+*
+*/
+void traceRecord(const int level, const TraceEventId event, const int arg0, const int arg1, const int arg2)
+{
+	TraceRing *ring = threadRing();
+	if (!ring) {
+		return;
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	unsigned long written = atomic_load_explicit(&ring->written, memory_order_relaxed);
+	TraceRecord *record = &ring->records[written % TRACE_RING_SIZE];
+	record->timeNanos = (unsigned long)now.tv_sec * 1000000000UL + (unsigned long)now.tv_nsec;
+	record->event = (unsigned short)event;
+	record->level = (unsigned char)level;
+	record->reserved = 0;
+	record->thread = localThread;
+	record->args[0] = arg0;
+	record->args[1] = arg1;
+	record->args[2] = arg2;
+	atomic_store_explicit(&ring->written, written + 1, memory_order_release);
+}
+
+/**
+*
+* This function copies the records of one ring, oldest first, into records and returns how many it copied. Records
+* the writer may have overwritten while they were copied are left out.
+*
+*/
+static int copyRing(TraceRing *ring, TraceRecord *records)
+{
+	unsigned long end = atomic_load_explicit(&ring->written, memory_order_acquire);
+	unsigned long begin = (end > TRACE_RING_SIZE) ? end - TRACE_RING_SIZE : 0;
+	for (unsigned long i = begin; i < end; i++) {
+		records[i - begin] = ring->records[i % TRACE_RING_SIZE];
+	}
+
+	unsigned long overwritten = atomic_load_explicit(&ring->written, memory_order_acquire);
+	unsigned long valid = (overwritten > TRACE_RING_SIZE) ? overwritten - TRACE_RING_SIZE : 0;
+	if (valid <= begin) {
+		return (int)(end - begin);
+	}
+	if (valid >= end) {
+		return 0;
+	}
+	memmove(records, records + (valid - begin), (end - valid) * sizeof(TraceRecord));
+	return (int)(end - valid);
+}
+
+/**
+*
+* This function orders records by time.
+*
+*/
+static int compareRecords(const void *first, const void *second)
+{
+	unsigned long firstTime = ((const TraceRecord *)first)->timeNanos;
+	unsigned long secondTime = ((const TraceRecord *)second)->timeNanos;
+	return (firstTime > secondTime) - (firstTime < secondTime);
+}
+
+/**
+*
+* This function collects the events of all threads into one array ordered by time and returns its length.
+*
+*/
+static int collectRecords(TraceRecord **all)
+{
+	int numOfRings = 0;
+	pthread_mutex_lock(&registryLatch);
+	for (TraceRing *ring = atomic_load(&registry); ring; ring = ring->next) {
+		numOfRings++;
+	}
+
+	int numOfRecords = 0;
+	*all = malloc(((size_t)numOfRings * TRACE_RING_SIZE + 1) * sizeof(TraceRecord));
+	if (*all) {
+		for (TraceRing *ring = atomic_load(&registry); ring; ring = ring->next) {
+			numOfRecords += copyRing(ring, *all + numOfRecords);
+		}
+	}
+	pthread_mutex_unlock(&registryLatch);
+
+	if (*all) {
+		qsort(*all, numOfRecords, sizeof(TraceRecord), compareRecords);
+	}
+	return numOfRecords;
+}
+
+/**
+*
+* This function fills records with the most recent events of all threads, up to maxRecords of them, oldest first,
+* and returns how many it filled in.
+*
+*/
+int traceSnapshot(TraceRecord *const records, const int maxRecords)
+{
+	TraceRecord *all;
+	int numOfRecords = collectRecords(&all);
+	if (!all) {
+		return 0;
+	}
+
+	int first = (numOfRecords > maxRecords) ? numOfRecords - maxRecords : 0;
+	memcpy(records, all + first, (numOfRecords - first) * sizeof(TraceRecord));
+	free(all);
+	return numOfRecords - first;
+}
+
+/**
+*
+* This function writes the events of all threads to a dump file that trace_decode can read.
+*
+*/
+RC traceDump(const char *const fileName)
+{
+	TraceRecord *all;
+	int numOfRecords = collectRecords(&all);
+	if (!all) {
+		return RC_WRITE_FAILED;
+	}
+
+	FILE *file = fopen(fileName, "wb");
+	if (!file) {
+		free(all);
+		return RC_FILE_NOT_FOUND;
+	}
+	TraceDumpHeader header;
+	memcpy(header.magic, traceMagic, sizeof(traceMagic));
+	header.recordSize = sizeof(TraceRecord);
+	header.numOfRecords = numOfRecords;
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(all, sizeof(TraceRecord), numOfRecords, file) == (size_t)numOfRecords;
+	free(all);
+	return (fclose(file) == 0 && written) ? RC_OK : RC_WRITE_FAILED;
+}
+
+/**
+*
+* This function is the signal handler installed by traceDumpOnCrash. It writes the rings as they are, using only
+* async-signal-safe calls and no latch, and then lets the signal take its default course.
+*
+*/
+static void dumpOnSignal(int signalNumber)
+{
+	int fd = open(crashDumpFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd >= 0) {
+		TraceDumpHeader header;
+		memcpy(header.magic, traceMagic, sizeof(traceMagic));
+		header.recordSize = sizeof(TraceRecord);
+		header.numOfRecords = 0;
+		for (TraceRing *ring = atomic_load(&registry); ring; ring = ring->next) {
+			unsigned long written = atomic_load(&ring->written);
+			header.numOfRecords += (written < TRACE_RING_SIZE) ? written : TRACE_RING_SIZE;
+		}
+		if (write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header)) {
+			for (TraceRing *ring = atomic_load(&registry); ring; ring = ring->next) {
+				unsigned long written = atomic_load(&ring->written);
+				size_t count = (written < TRACE_RING_SIZE) ? written : TRACE_RING_SIZE;
+				if (write(fd, ring->records, count * sizeof(TraceRecord)) < 0) {
+					break;
+				}
+			}
+		}
+		close(fd);
+	}
+	signal(signalNumber, SIG_DFL);
+	raise(signalNumber);
+}
+
+/**
+*
+* This function makes the process dump its events to fileName if it crashes (SIGSEGV, SIGBUS, SIGFPE, SIGILL or
+* SIGABRT), so the events leading up to the crash can be decoded afterwards.
+*
+*/
+RC traceDumpOnCrash(const char *const fileName)
+{
+	if (!fileName || strlen(fileName) >= sizeof(crashDumpFile)) {
+		return RC_FILE_NOT_FOUND;
+	}
+	strcpy(crashDumpFile, fileName);
+
+	int signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+	for (int i = 0; i < (int)(sizeof(signals) / sizeof(signals[0])); i++) {
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = dumpOnSignal;
+		sigemptyset(&action.sa_mask);
+		action.sa_flags = SA_RESETHAND;
+		if (sigaction(signals[i], &action, NULL) != 0) {
+			return RC_FILE_HANDLE_NOT_INIT;
+		}
+	}
+	return RC_OK;
+}
+
+/**
+*
+* This function reads a dump written by traceDump or the crash handler. The records, ordered by time, are returned
+* in a new array that the caller frees.
+*
+*/
+RC traceLoadDump(const char *const fileName, TraceRecord **const records, int *const numOfRecords)
+{
+	FILE *file = fopen(fileName, "rb");
+	if (!file) {
+		return RC_FILE_NOT_FOUND;
+	}
+
+	TraceDumpHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, traceMagic, sizeof(traceMagic)) != 0
+		|| header.recordSize != sizeof(TraceRecord)) {
+		fclose(file);
+		return RC_READ_FAILED;
+	}
+	*records = malloc(((size_t)header.numOfRecords + 1) * sizeof(TraceRecord));
+	*numOfRecords = *records ? (int)fread(*records, sizeof(TraceRecord), header.numOfRecords, file) : 0;
+	fclose(file);
+	if (!*records) {
+		return RC_READ_FAILED;
+	}
+	qsort(*records, *numOfRecords, sizeof(TraceRecord), compareRecords);
+	return RC_OK;
+}
+
+/**
+*
+* This function formats a record as one line of text (time, thread, level, event and named arguments) and returns
+* the length of the line, like snprintf.
+*
+*/
+int traceFormat(const TraceRecord *const record, char *const buffer, const int size)
+{
+	int length = snprintf(buffer, size, "%lu.%09lu T%u %-5s %s", record->timeNanos / 1000000000UL,
+						  record->timeNanos % 1000000000UL, record->thread, traceLevelName(record->level),
+						  traceEventName(record->event));
+	for (int i = 0; i < TRACE_NUM_ARGS && record->event < TRACE_NUM_EVENTS; i++) {
+		const char *argName = eventInfo[record->event].args[i];
+		if (argName && length < size) {
+			length += snprintf(buffer + length, size - length, " %s=%d", argName, record->args[i]);
+		}
+	}
+	return length;
+}
+
+/**
+*
+* These functions return the names of events and levels as the dump shows them.
+*
+*/
+const char *traceEventName(const int event)
+{
+	return (event >= 0 && event < TRACE_NUM_EVENTS) ? eventInfo[event].name : "unknown";
+}
+
+const char *traceLevelName(const int level)
+{
+	return (level >= 0 && level <= TRACE_LEVEL_DEBUG) ? levelNames[level] : "?";
+}
+
+/**
+*
+* This function returns the level tracing was compiled with, 0 if it was compiled out.
+*
+*/
+int traceLevel(void)
+{
+#if defined(BM_TRACE_LEVEL) && BM_TRACE_LEVEL > 0
+	return BM_TRACE_LEVEL;
+#else
+	return 0;
+#endif
+}
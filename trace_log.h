@@ -0,0 +1,72 @@
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include "dberror.h"
+#include "dt.h"
+
+/************************************************************
+ *                    event tracing                         *
+ ************************************************************/
+/* Events are small binary records (an event id, a level and up to three integer
+ * arguments) that each thread writes into its own ring of the most recent
+ * TRACE_RING_SIZE events; nothing is formatted or written out while tracing.
+ * traceDump writes the rings of all threads to a file, and the trace_decode tool
+ * turns such a dump into text, ordered by time.
+ *
+ * BM_TRACE_LEVEL selects at compile time which events are recorded: 1 keeps
+ * errors, 2 also warnings, 3 also info and 4 also debug events. If it is not
+ * defined (or 0) TRACE_EVENT expands to nothing and the arguments are not even
+ * evaluated. */
+#define TRACE_LEVEL_ERROR 1
+#define TRACE_LEVEL_WARN 2
+#define TRACE_LEVEL_INFO 3
+#define TRACE_LEVEL_DEBUG 4
+
+typedef enum TraceEventId {
+	TRACE_CREATE_FILE = 0,
+	TRACE_OPEN_FILE = 1,
+	TRACE_READ_BLOCK = 2,
+	TRACE_WRITE_BLOCK = 3,
+	TRACE_GET_BLOCK_POS = 4,
+	TRACE_APPEND_BLOCK = 5,
+	TRACE_ENSURE_CAPACITY = 6,
+	TRACE_LRU_HIT = 7,
+	TRACE_NO_FREE_FRAME = 8,
+	TRACE_READ_BLOCKS = 9,
+	TRACE_WRITE_BLOCKS = 10
+} TraceEventId;
+
+#define TRACE_NUM_EVENTS 11
+#define TRACE_NUM_ARGS 3
+#define TRACE_RING_SIZE 4096
+
+typedef struct TraceRecord {
+	unsigned long timeNanos; // CLOCK_REALTIME, so events can be matched with other logs
+	unsigned short event;
+	unsigned char level;
+	unsigned char reserved;
+	unsigned int thread;     // small number the tracing gives each thread
+	int args[TRACE_NUM_ARGS];
+} TraceRecord;
+
+#if defined(BM_TRACE_LEVEL) && BM_TRACE_LEVEL > 0
+#define TRACE_EVENT(level, event, arg0, arg1, arg2)                         \
+	do {                                                                    \
+		if ((level) <= BM_TRACE_LEVEL)                                      \
+			traceRecord((level), (event), (arg0), (arg1), (arg2));          \
+	} while (0)
+#else
+#define TRACE_EVENT(level, event, arg0, arg1, arg2) do { } while (0)
+#endif
+
+void traceRecord (const int level, const TraceEventId event, const int arg0, const int arg1, const int arg2);
+int traceSnapshot (TraceRecord *const records, const int maxRecords);
+RC traceDump (const char *const fileName);
+RC traceDumpOnCrash (const char *const fileName);
+RC traceLoadDump (const char *const fileName, TraceRecord **const records, int *const numOfRecords);
+int traceFormat (const TraceRecord *const record, char *const buffer, const int size);
+const char *traceEventName (const int event);
+const char *traceLevelName (const int level);
+int traceLevel (void);
+
+#endif